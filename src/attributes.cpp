@@ -618,6 +618,20 @@ sp_attribute_name(SPAttr id)
     return props[(int)id].name;
 }
 
+GQuark
+sp_attribute_quark(SPAttr id)
+{
+    static std::vector<GQuark> const quarks = [] {
+        std::vector<GQuark> quarks(n_attrs, 0);
+        for (unsigned int i = 1; i < n_attrs; i++) {
+            quarks[i] = g_quark_from_static_string(props[i].name);
+        }
+        return quarks;
+    }();
+    g_assert((int)id < n_attrs);
+    return quarks[(int)id];
+}
+
 std::vector<Glib::ustring> sp_attribute_name_list(bool css_only)
 {
     std::vector<Glib::ustring> result;
@@ -591,6 +591,12 @@ SPAttr sp_attribute_lookup(gchar const *key);
  */
 gchar const *sp_attribute_name(SPAttr id);
 
+/**
+ * Get the quark of an attribute name by id, for Inkscape::XML::Node::attribute(GQuark).
+ * Return 0 for invalid ids.
+ */
+GQuark sp_attribute_quark(SPAttr id);
+
 /**
  * Get sorted attribute name list.
  * @param css_only If true, only return CSS properties
@@ -31,7 +31,9 @@ public:
     enum {
         SIZE_AVAILABLE    = ( 1 << 0 ),
         USED_AVAILABLE    = ( 1 << 1 ),
-        GARBAGE_COLLECTED = ( 1 << 2 )
+        GARBAGE_COLLECTED = ( 1 << 2 ),
+        // Carved from memory of another heap, so not counted again in totals
+        SUBALLOCATED      = ( 1 << 3 )
     };
 
     virtual int features() const=0;
@@ -0,0 +1,320 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/**
+ * @file
+ * Vectorized row kernels of filter primitives.
+ *//*
+ * Authors:
+ *   See git history.
+ *
+ * Copyright (C) 2022 Authors
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include "display/cairo-simd.h"
+
+#include <algorithm>
+#include <cstring>
+
+// The vectorized kernels are written once with the vector extensions of GCC and Clang, and
+// compiled for each instruction set with the target attribute. Other compilers and CPUs use the
+// scalar kernels.
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+# define INK_SIMD_X86 1
+#else
+# define INK_SIMD_X86 0
+#endif
+
+namespace Inkscape {
+namespace SIMD {
+
+namespace {
+
+Level detect_level()
+{
+#if INK_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return Level::AVX2;
+    }
+    if (__builtin_cpu_supports("sse4.1")) {
+        return Level::SSE41;
+    }
+#endif
+    return Level::NONE;
+}
+
+Level best_level()
+{
+    static Level const level = detect_level();
+    return level;
+}
+
+Level &current_level()
+{
+    static Level level = best_level();
+    return level;
+}
+
+#if INK_SIMD_X86
+
+#if !defined(__clang__)
+// The helpers below pass vectors by value, but are always inlined into the kernels.
+# pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+
+/*
+ * N pixels at a time. Each channel is held in 32-bit lanes, so that the arithmetic is exactly
+ * that of the scalar kernels, including the unsigned wrap-around of their products. Division is
+ * done in double precision, which gives the exact integer quotient for the ranges involved.
+ */
+template <int N>
+struct Vec
+{
+    typedef guint32 U __attribute__((vector_size(4 * N)));
+    typedef gint32 I __attribute__((vector_size(4 * N)));
+    typedef double D __attribute__((vector_size(8 * N)));
+};
+
+template <typename V>
+inline __attribute__((always_inline)) V load(guint32 const *p)
+{
+    V v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+template <typename V>
+inline __attribute__((always_inline)) void store(guint32 *p, V v)
+{
+    std::memcpy(p, &v, sizeof(v));
+}
+
+// Same as pxclamp().
+template <typename I>
+inline __attribute__((always_inline)) I clamp(I v, I low, I high)
+{
+    return v < low ? low : (v > high ? high : v);
+}
+
+// Quotient of non-negative numerators by positive divisors.
+template <int N>
+inline __attribute__((always_inline)) typename Vec<N>::I divide(typename Vec<N>::I num, typename Vec<N>::I den)
+{
+    using I = typename Vec<N>::I;
+    using D = typename Vec<N>::D;
+    return __builtin_convertvector(__builtin_convertvector(num, D) / __builtin_convertvector(den, D), I);
+}
+
+// Same as premul_alpha().
+template <typename U>
+inline __attribute__((always_inline)) U premul(U color, U alpha)
+{
+    U temp = alpha * color + 128;
+    return (temp + (temp >> 8)) >> 8;
+}
+
+// Same as unpremul_alpha(), except that colors with zero alpha are left alone.
+template <int N>
+inline __attribute__((always_inline)) typename Vec<N>::U unpremul(typename Vec<N>::U color, typename Vec<N>::U alpha)
+{
+    using U = typename Vec<N>::U;
+    using I = typename Vec<N>::I;
+    I c = (I)color;
+    I a = (I)alpha;
+    I nonzero = a != 0;
+    I safe_a = nonzero ? a : I{} + 1;
+    I q = divide<N>(c * 255 + safe_a / 2, safe_a);
+    I result = c >= a ? I{} + 255 : q;
+    return (U)(nonzero ? result : c);
+}
+
+template <int N>
+inline __attribute__((always_inline)) int compose_arithmetic_impl(guint32 const *in1, guint32 const *in2, guint32 *out, int n, gint32 const *k)
+{
+    using U = typename Vec<N>::U;
+    using I = typename Vec<N>::I;
+    U const k0 = U{} + guint32(k[0]), k1 = U{} + guint32(k[1]), k2 = U{} + guint32(k[2]), k3 = U{} + guint32(k[3]);
+    I const zero = I{}, max_a = I{} + 255*255*255, half = I{} + 255*255/2, den = I{} + 255*255;
+
+    int i = 0;
+    for (; i + N <= n; i += N) {
+        U p1 = load<U>(in1 + i);
+        U p2 = load<U>(in2 + i);
+
+        I channels[4];
+        for (int c = 0; c < 4; ++c) {
+            U x1 = (p1 >> (8 * c)) & 0xff;
+            U x2 = (p2 >> (8 * c)) & 0xff;
+            channels[c] = (I)(k0*x1*x2 + k1*x1 + k2*x2 + k3);
+        }
+
+        I ao = clamp(channels[3], zero, max_a);
+        U result = (U)divide<N>(ao + half, den) << 24;
+        for (int c = 0; c < 3; ++c) {
+            result |= (U)divide<N>(clamp(channels[c], zero, ao) + half, den) << (8 * c);
+        }
+        store(out + i, result);
+    }
+    return i;
+}
+
+template <int N>
+inline __attribute__((always_inline)) int color_matrix_impl(guint32 const *in, guint32 *out, int n, gint32 const *v)
+{
+    using U = typename Vec<N>::U;
+    using I = typename Vec<N>::I;
+    I const zero = I{}, max_px = I{} + 255*255, den = I{} + 255;
+
+    int i = 0;
+    for (; i + N <= n; i += N) {
+        U px = load<U>(in + i);
+        U a = px >> 24;
+        U r = unpremul<N>((px >> 16) & 0xff, a);
+        U g = unpremul<N>((px >> 8) & 0xff, a);
+        U b = unpremul<N>(px & 0xff, a);
+
+        U channels[4];
+        for (int c = 0; c < 4; ++c) {
+            gint32 const *row = v + 5 * c;
+            I x = (I)(r*guint32(row[0]) + g*guint32(row[1]) + b*guint32(row[2]) + a*guint32(row[3]) + guint32(row[4]));
+            channels[c] = (U)divide<N>(clamp(x, zero, max_px) + 127, den);
+        }
+
+        U ao = channels[3];
+        U result = ao << 24 | premul(channels[0], ao) << 16 | premul(channels[1], ao) << 8 | premul(channels[2], ao);
+        store(out + i, result);
+    }
+    return i;
+}
+
+template <int N>
+inline __attribute__((always_inline)) int color_matrix_saturate_impl(guint32 const *in, guint32 *out, int n, double const *v)
+{
+    using U = typename Vec<N>::U;
+    using D = typename Vec<N>::D;
+
+    int i = 0;
+    for (; i + N <= n; i += N) {
+        U px = load<U>(in + i);
+        D r = __builtin_convertvector((px >> 16) & 0xff, D);
+        D g = __builtin_convertvector((px >> 8) & 0xff, D);
+        D b = __builtin_convertvector(px & 0xff, D);
+
+        U result = px & 0xff000000;
+        for (int c = 0; c < 3; ++c) {
+            D x = r*v[3*c] + g*v[3*c + 1] + b*v[3*c + 2] + 0.5;
+            result |= __builtin_convertvector(x, U) << (16 - 8 * c);
+        }
+        store(out + i, result);
+    }
+    return i;
+}
+
+template <int N>
+inline __attribute__((always_inline)) int color_matrix_hue_rotate_impl(guint32 const *in, guint32 *out, int n, gint32 const *v)
+{
+    using U = typename Vec<N>::U;
+    using I = typename Vec<N>::I;
+    I const zero = I{}, den = I{} + 255;
+
+    int i = 0;
+    for (; i + N <= n; i += N) {
+        U px = load<U>(in + i);
+        U a = px >> 24;
+        U r = (px >> 16) & 0xff;
+        U g = (px >> 8) & 0xff;
+        U b = px & 0xff;
+        I maxpx = (I)(a * 255);
+
+        U result = px & 0xff000000;
+        for (int c = 0; c < 3; ++c) {
+            I x = (I)(r*guint32(v[3*c]) + g*guint32(v[3*c + 1]) + b*guint32(v[3*c + 2]));
+            result |= (U)divide<N>(clamp(x, zero, maxpx) + 127, den) << (16 - 8 * c);
+        }
+        store(out + i, result);
+    }
+    return i;
+}
+
+// Instantiate a kernel for each instruction set; the returned value is the number of pixels done.
+#define INK_SIMD_KERNEL(name, params, args) \
+    __attribute__((target("avx2"))) int name##_avx2 params { return name##_impl<8> args; } \
+    __attribute__((target("sse4.1"))) int name##_sse41 params { return name##_impl<4> args; } \
+    int name##_simd params \
+    { \
+        switch (current_level()) { \
+            case Level::AVX2: return name##_avx2 args; \
+            case Level::SSE41: return name##_sse41 args; \
+            default: return 0; \
+        } \
+    }
+
+INK_SIMD_KERNEL(compose_arithmetic, (guint32 const *in1, guint32 const *in2, guint32 *out, int n, gint32 const *k), (in1, in2, out, n, k))
+INK_SIMD_KERNEL(color_matrix, (guint32 const *in, guint32 *out, int n, gint32 const *v), (in, out, n, v))
+INK_SIMD_KERNEL(color_matrix_saturate, (guint32 const *in, guint32 *out, int n, double const *v), (in, out, n, v))
+INK_SIMD_KERNEL(color_matrix_hue_rotate, (guint32 const *in, guint32 *out, int n, gint32 const *v), (in, out, n, v))
+
+#undef INK_SIMD_KERNEL
+
+#else
+
+int compose_arithmetic_simd(guint32 const *, guint32 const *, guint32 *, int, gint32 const *) { return 0; }
+int color_matrix_simd(guint32 const *, guint32 *, int, gint32 const *) { return 0; }
+int color_matrix_saturate_simd(guint32 const *, guint32 *, int, double const *) { return 0; }
+int color_matrix_hue_rotate_simd(guint32 const *, guint32 *, int, gint32 const *) { return 0; }
+
+#endif // INK_SIMD_X86
+
+} // namespace
+
+Level get_level()
+{
+    return current_level();
+}
+
+void set_level(Level level)
+{
+    current_level() = std::min(level, best_level());
+}
+
+void compose_arithmetic_row(guint32 const *in1, guint32 const *in2, guint32 *out, int n, gint32 const *k)
+{
+    for (int i = compose_arithmetic_simd(in1, in2, out, n, k); i < n; ++i) {
+        out[i] = compose_arithmetic(in1[i], in2[i], k);
+    }
+}
+
+void color_matrix_row(guint32 const *in, guint32 *out, int n, gint32 const *v)
+{
+    for (int i = color_matrix_simd(in, out, n, v); i < n; ++i) {
+        out[i] = color_matrix(in[i], v);
+    }
+}
+
+void color_matrix_saturate_row(guint32 const *in, guint32 *out, int n, double const *v)
+{
+    for (int i = color_matrix_saturate_simd(in, out, n, v); i < n; ++i) {
+        out[i] = color_matrix_saturate(in[i], v);
+    }
+}
+
+void color_matrix_hue_rotate_row(guint32 const *in, guint32 *out, int n, gint32 const *v)
+{
+    for (int i = color_matrix_hue_rotate_simd(in, out, n, v); i < n; ++i) {
+        out[i] = color_matrix_hue_rotate(in[i], v);
+    }
+}
+
+} // namespace SIMD
+} // namespace Inkscape
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
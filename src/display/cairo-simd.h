@@ -0,0 +1,151 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/**
+ * @file
+ * Pixel kernels of filter primitives, with vectorized versions for whole rows.
+ *//*
+ * Authors:
+ *   See git history.
+ *
+ * Copyright (C) 2022 Authors
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#ifndef SEEN_INKSCAPE_DISPLAY_CAIRO_SIMD_H
+#define SEEN_INKSCAPE_DISPLAY_CAIRO_SIMD_H
+
+#include <glib.h>
+#include "display/cairo-templates.h"
+#include "display/cairo-utils.h"
+
+namespace Inkscape {
+namespace SIMD {
+
+/**
+ * The instruction sets that the row kernels may use. The best one supported by the CPU is
+ * selected at runtime; NONE means the scalar kernels are used for every pixel.
+ */
+enum class Level
+{
+    NONE,
+    SSE41,
+    AVX2
+};
+
+/// The instruction set used by the row kernels.
+Level get_level();
+
+/**
+ * Restrict the instruction set used by the row kernels, e.g. to compare them with the scalar
+ * kernels. Levels that the CPU does not support are lowered to the best one that it does.
+ */
+void set_level(Level level);
+
+/*
+ * Scalar kernels. Each row kernel below produces exactly the same pixels as calling the
+ * corresponding scalar kernel on every pixel of the row.
+ */
+
+/// feComposite operator="arithmetic"; k holds k1 to k4 scaled by 255, 255^2, 255^2 and 255^3.
+inline guint32 compose_arithmetic(guint32 in1, guint32 in2, gint32 const *k)
+{
+    EXTRACT_ARGB32(in1, aa, ra, ga, ba)
+    EXTRACT_ARGB32(in2, ab, rb, gb, bb)
+
+    gint32 ao = k[0]*aa*ab + k[1]*aa + k[2]*ab + k[3];
+    gint32 ro = k[0]*ra*rb + k[1]*ra + k[2]*rb + k[3];
+    gint32 go = k[0]*ga*gb + k[1]*ga + k[2]*gb + k[3];
+    gint32 bo = k[0]*ba*bb + k[1]*ba + k[2]*bb + k[3];
+
+    ao = pxclamp(ao, 0, 255*255*255); // r, g and b are premultiplied, so should be clamped to the alpha channel
+    ro = (pxclamp(ro, 0, ao) + (255*255/2)) / (255*255);
+    go = (pxclamp(go, 0, ao) + (255*255/2)) / (255*255);
+    bo = (pxclamp(bo, 0, ao) + (255*255/2)) / (255*255);
+    ao = (ao + (255*255/2)) / (255*255);
+
+    ASSEMBLE_ARGB32(pxout, ao, ro, go, bo)
+    return pxout;
+}
+
+/// feColorMatrix type="matrix"; v holds the matrix scaled by 255, and by 255^2 for the offsets.
+inline guint32 color_matrix(guint32 in, gint32 const *v)
+{
+    EXTRACT_ARGB32(in, a, r, g, b)
+    // we need to un-premultiply alpha values for this type of matrix
+    // TODO: unpremul can be ignored if there is an identity mapping on the alpha channel
+    if (a != 0) {
+        r = unpremul_alpha(r, a);
+        g = unpremul_alpha(g, a);
+        b = unpremul_alpha(b, a);
+    }
+
+    gint32 ro = r*v[0]  + g*v[1]  + b*v[2]  + a*v[3]  + v[4];
+    gint32 go = r*v[5]  + g*v[6]  + b*v[7]  + a*v[8]  + v[9];
+    gint32 bo = r*v[10] + g*v[11] + b*v[12] + a*v[13] + v[14];
+    gint32 ao = r*v[15] + g*v[16] + b*v[17] + a*v[18] + v[19];
+    ro = (pxclamp(ro, 0, 255*255) + 127) / 255;
+    go = (pxclamp(go, 0, 255*255) + 127) / 255;
+    bo = (pxclamp(bo, 0, 255*255) + 127) / 255;
+    ao = (pxclamp(ao, 0, 255*255) + 127) / 255;
+
+    ro = premul_alpha(ro, ao);
+    go = premul_alpha(go, ao);
+    bo = premul_alpha(bo, ao);
+
+    ASSEMBLE_ARGB32(pxout, ao, ro, go, bo)
+    return pxout;
+}
+
+/// feColorMatrix type="saturate"; v holds the 3x3 matrix, with the saturation already applied.
+inline guint32 color_matrix_saturate(guint32 in, double const *v)
+{
+    EXTRACT_ARGB32(in, a, r, g, b)
+
+    // Note: this cannot be done in fixed point, because the loss of precision
+    //       causes overflow for some values of v
+    guint32 ro = r*v[0] + g*v[1] + b*v[2] + 0.5;
+    guint32 go = r*v[3] + g*v[4] + b*v[5] + 0.5;
+    guint32 bo = r*v[6] + g*v[7] + b*v[8] + 0.5;
+
+    ASSEMBLE_ARGB32(pxout, a, ro, go, bo)
+    return pxout;
+}
+
+/// feColorMatrix type="hueRotate"; v holds the 3x3 matrix scaled by 255.
+inline guint32 color_matrix_hue_rotate(guint32 in, gint32 const *v)
+{
+    EXTRACT_ARGB32(in, a, r, g, b)
+    gint32 maxpx = a*255;
+    gint32 ro = r*v[0] + g*v[1] + b*v[2];
+    gint32 go = r*v[3] + g*v[4] + b*v[5];
+    gint32 bo = r*v[6] + g*v[7] + b*v[8];
+    ro = (pxclamp(ro, 0, maxpx) + 127) / 255;
+    go = (pxclamp(go, 0, maxpx) + 127) / 255;
+    bo = (pxclamp(bo, 0, maxpx) + 127) / 255;
+
+    ASSEMBLE_ARGB32(pxout, a, ro, go, bo)
+    return pxout;
+}
+
+/*
+ * Row kernels, working on n consecutive ARGB32 pixels. The output may be the same as an input,
+ * but must not overlap it otherwise.
+ */
+void compose_arithmetic_row(guint32 const *in1, guint32 const *in2, guint32 *out, int n, gint32 const *k);
+void color_matrix_row(guint32 const *in, guint32 *out, int n, gint32 const *v);
+void color_matrix_saturate_row(guint32 const *in, guint32 *out, int n, double const *v);
+void color_matrix_hue_rotate_row(guint32 const *in, guint32 *out, int n, gint32 const *v);
+
+} // namespace SIMD
+} // namespace Inkscape
+
+#endif // SEEN_INKSCAPE_DISPLAY_CAIRO_SIMD_H
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
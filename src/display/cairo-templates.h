@@ -29,9 +29,60 @@ static const int OPENMP_THRESHOLD = 2048;
 #include <algorithm>
 #include <cairo.h>
 #include <cmath>
+#include <type_traits>
+#include <utility>
+#include <vector>
 #include "display/nr-3dutils.h"
 #include "display/cairo-utils.h"
 
+/*
+ * Functors may also provide a method processing a whole row of ARGB32 pixels, which is then used
+ * instead of calling the functor for every pixel of ARGB32 surfaces:
+ *   void blend_row(guint32 const *in1, guint32 const *in2, guint32 *out, int n);
+ *   void filter_row(guint32 const *in, guint32 *out, int n);
+ *   void synthesize_row(int y, int x0, int x1, guint32 *out);
+ */
+template <typename Blend, typename = void>
+struct ink_has_blend_row : std::false_type {};
+template <typename Blend>
+struct ink_has_blend_row<Blend, std::void_t<decltype(std::declval<Blend &>().blend_row(nullptr, nullptr, nullptr, 0))>>
+    : std::true_type {};
+
+template <typename Filter, typename = void>
+struct ink_has_filter_row : std::false_type {};
+template <typename Filter>
+struct ink_has_filter_row<Filter, std::void_t<decltype(std::declval<Filter &>().filter_row(nullptr, nullptr, 0))>>
+    : std::true_type {};
+
+template <typename Synth, typename = void>
+struct ink_has_synthesize_row : std::false_type {};
+template <typename Synth>
+struct ink_has_synthesize_row<Synth, std::void_t<decltype(std::declval<Synth &>().synthesize_row(0, 0, 0, nullptr))>>
+    : std::true_type {};
+
+/**
+ * Call a functor for each row from y0 to y1 (exclusive), spreading the rows over the number of
+ * threads set in the preferences, unless there are too few pixels for threading to pay off.
+ * @param y0     First row
+ * @param y1     Row after the last one
+ * @param width  Number of pixels processed in each row
+ * @param row    Functor called with the index of each row, from several threads at once
+ */
+template <typename Row>
+void ink_cairo_parallel_rows(int y0, int y1, int width, Row &&row)
+{
+    #if HAVE_OPENMP
+    int limit = width * (y1 - y0);
+    Inkscape::Preferences *prefs = Inkscape::Preferences::get();
+    int numOfThreads = prefs->getIntLimited("/options/threading/numthreads", omp_get_num_procs(), 1, 256);
+    if (numOfThreads){} // inform compiler we are using it.
+    #pragma omp parallel for if(limit > OPENMP_THRESHOLD) num_threads(numOfThreads)
+    #endif
+    for (int i = y0; i < y1; ++i) {
+        row(i);
+    }
+}
+
 /**
  * Blend two surfaces using the supplied functor.
  * This template blends two Cairo image surfaces using a blending functor that takes
@@ -84,7 +135,14 @@ void ink_cairo_surface_blend(cairo_surface_t *in1, cairo_surface_t *in2, cairo_s
     // The number of code paths here is evil.
     if (bpp1 == 4) {
         if (bpp2 == 4) {
-            if (fast_path) {
+            if constexpr (ink_has_blend_row<Blend>::value) {
+                #if HAVE_OPENMP
+                #pragma omp parallel for if(limit > OPENMP_THRESHOLD) num_threads(numOfThreads)
+                #endif
+                for (int i = 0; i < h; ++i) {
+                    blend.blend_row(in1_data + i * stride1/4, in2_data + i * stride2/4, out_data + i * strideout/4, w);
+                }
+            } else if (fast_path) {
                 #if HAVE_OPENMP
                 #pragma omp parallel for if(limit > OPENMP_THRESHOLD) num_threads(numOfThreads)
                 #endif
@@ -212,11 +270,21 @@ void ink_cairo_surface_filter(cairo_surface_t *in, cairo_surface_t *out, Filter
     // this is provided just in case, to avoid problems with strict aliasing rules
     if (in == out) {
         if (bppin == 4) {
-            #if HAVE_OPENMP
-            #pragma omp parallel for if(limit > OPENMP_THRESHOLD) num_threads(numOfThreads)
-            #endif
-            for (int i = 0; i < limit; ++i) {
-                *(in_data + i) = filter(*(in_data + i));
+            if constexpr (ink_has_filter_row<Filter>::value) {
+                #if HAVE_OPENMP
+                #pragma omp parallel for if(limit > OPENMP_THRESHOLD) num_threads(numOfThreads)
+                #endif
+                for (int i = 0; i < h; ++i) {
+                    guint32 *in_p = in_data + i * stridein/4;
+                    filter.filter_row(in_p, in_p, w);
+                }
+            } else {
+                #if HAVE_OPENMP
+                #pragma omp parallel for if(limit > OPENMP_THRESHOLD) num_threads(numOfThreads)
+                #endif
+                for (int i = 0; i < limit; ++i) {
+                    *(in_data + i) = filter(*(in_data + i));
+                }
             }
         } else {
             #if HAVE_OPENMP
@@ -236,7 +304,14 @@ void ink_cairo_surface_filter(cairo_surface_t *in, cairo_surface_t *out, Filter
     if (bppin == 4) {
         if (bppout == 4) {
             // bppin == 4, bppout == 4
-            if (fast_path) {
+            if constexpr (ink_has_filter_row<Filter>::value) {
+                #if HAVE_OPENMP
+                #pragma omp parallel for if(limit > OPENMP_THRESHOLD) num_threads(numOfThreads)
+                #endif
+                for (int i = 0; i < h; ++i) {
+                    filter.filter_row(in_data + i * stridein/4, out_data + i * strideout/4, w);
+                }
+            } else if (fast_path) {
                 #if HAVE_OPENMP
                 #pragma omp parallel for if(limit > OPENMP_THRESHOLD) num_threads(numOfThreads)
                 #endif
@@ -343,45 +418,38 @@ void ink_cairo_surface_synthesize(cairo_surface_t *out, cairo_rectangle_t const
     // 1. Cairo ARGB32 surface strides are always divisible by 4
     // 2. We can only receive CAIRO_FORMAT_ARGB32 or CAIRO_FORMAT_A8 surfaces
 
-    int w = out_area.width;
-    int h = out_area.height;
+    int x0 = out_area.x;
+    int y0 = out_area.y;
+    int x1 = x0 + out_area.width;
+    int y1 = y0 + out_area.height;
     int strideout = cairo_image_surface_get_stride(out);
     int bppout = cairo_image_surface_get_format(out) == CAIRO_FORMAT_A8 ? 1 : 4;
     // NOTE: fast path is not used, because we would need 2 divisions to get pixel indices
 
     unsigned char *out_data = cairo_image_surface_get_data(out);
 
-    #if HAVE_OPENMP
-    int limit = w * h;
-    Inkscape::Preferences *prefs = Inkscape::Preferences::get();
-    int numOfThreads = prefs->getIntLimited("/options/threading/numthreads", omp_get_num_procs(), 1, 256);
-    if (numOfThreads){} // inform compiler we are using it.
-    #endif
-
     if (bppout == 4) {
-        #if HAVE_OPENMP
-        #pragma omp parallel for if(limit > OPENMP_THRESHOLD) num_threads(numOfThreads)
-        #endif
-        for (int i = out_area.y; i < h; ++i) {
-            guint32 *out_p = reinterpret_cast<guint32*>(out_data + i * strideout);
-            for (int j = out_area.x; j < w; ++j) {
-                *out_p = synth(j, i);
-                ++out_p;
+        ink_cairo_parallel_rows(y0, y1, x1 - x0, [&](int i) {
+            guint32 *out_p = reinterpret_cast<guint32*>(out_data + i * strideout) + x0;
+            if constexpr (ink_has_synthesize_row<Synth>::value) {
+                synth.synthesize_row(i, x0, x1, out_p);
+            } else {
+                for (int j = x0; j < x1; ++j) {
+                    *out_p = synth(j, i);
+                    ++out_p;
+                }
             }
-        }
+        });
     } else {
         // bppout == 1
-        #if HAVE_OPENMP
-        #pragma omp parallel for if(limit > OPENMP_THRESHOLD) num_threads(numOfThreads)
-        #endif
-        for (int i = out_area.y; i < h; ++i) {
-            guint8 *out_p = out_data + i * strideout;
-            for (int j = out_area.x; j < w; ++j) {
+        ink_cairo_parallel_rows(y0, y1, x1 - x0, [&](int i) {
+            guint8 *out_p = out_data + i * strideout + x0;
+            for (int j = x0; j < x1; ++j) {
                 guint32 out_px = synth(j, i);
                 *out_p = out_px >> 24;
                 ++out_p;
             }
-        }
+        });
     }
     cairo_surface_mark_dirty(out);
 }
@@ -636,6 +704,31 @@ struct SurfaceSynth {
         return normal;
     }
 
+    // compute surface normals of pixels x0 to x1 (exclusive) in row y, same as surfaceNormalAt()
+    void surfaceNormalsRow(int y, int x0, int x1, double scale, NR::Fvector *normals) const {
+        // pixels which are not on an edge go through the branchless loop
+        int i0 = std::max(x0, 1);
+        int i1 = std::min(x1, _w - 1);
+        if (y > 0 && y < _h - 1 && i0 < i1) {
+            int n = i1 - i0 + 2;
+            std::vector<double> alpha(3 * n);
+            for (int r = 0; r < 3; ++r) {
+                for (int i = 0; i < n; ++i) {
+                    alpha[r * n + i] = alphaAt(i0 - 1 + i, y - 1 + r);
+                }
+            }
+            NR::sobel_normals(&alpha[1], &alpha[n + 1], &alpha[2 * n + 1], i1 - i0, scale, normals + (i0 - x0));
+        } else {
+            i0 = i1 = x1;
+        }
+        for (int x = x0; x < i0; ++x) {
+            normals[x - x0] = surfaceNormalAt(x, y, scale);
+        }
+        for (int x = i1; x < x1; ++x) {
+            normals[x - x0] = surfaceNormalAt(x, y, scale);
+        }
+    }
+
     unsigned char *_px;
     int _w, _h, _stride;
     bool _alpha;
@@ -30,6 +30,7 @@ struct CanvasItemBuffer {
     Geom::IntRect rect;
     int device_scale; // For high DPI monitors.
     Cairo::RefPtr<Cairo::Context> cr;
+    bool concurrent = false; // Rendered on a worker thread; shared state is already up-to-date and must not be modified.
 };
 
 } // Namespace Inkscape
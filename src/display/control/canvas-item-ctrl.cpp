@@ -286,8 +286,11 @@ void CanvasItemCtrl::render(Inkscape::CanvasItemBuffer *buf)
         return; // Hidden.
     }
 
-    if (!_built) {
-        build_cache(buf->device_scale);
+    {
+        std::lock_guard<std::mutex> lock(_cache_mutex);
+        if (!_built) {
+            build_cache(buf->device_scale);
+        }
     }
 
     Geom::Point c = _bounds.min() - buf->rect.min();
@@ -18,6 +18,7 @@
  */
 
 #include <memory>
+#include <mutex>
 #include <gdk-pixbuf/gdk-pixbuf.h>
 #include <2geom/point.h>
 
@@ -77,6 +78,7 @@ protected:
     // Display
     guint32 *_cache = nullptr;
     bool _built = false;
+    std::mutex _cache_mutex; // The cache is built on first render, which may happen on several threads.
 
     // Properties
     CanvasItemCtrlType _type   = CANVAS_ITEM_CTRL_TYPE_DEFAULT;
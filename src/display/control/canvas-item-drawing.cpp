@@ -187,7 +187,9 @@ void CanvasItemDrawing::render(Inkscape::CanvasItemBuffer *buf)
     }
 
     Inkscape::DrawingContext dc(buf->cr->cobj(), buf->rect.min());
-    _drawing->update();
+    if (!buf->concurrent) {
+        _drawing->update();
+    }
     _drawing->render(dc, buf->rect);
 }
 
@@ -21,6 +21,24 @@
 
 namespace Inkscape {
 
+namespace {
+
+// Groups with fewer children than this are picked by a linear scan.
+constexpr std::size_t PICK_INDEX_THRESHOLD = 64;
+
+// The largest box that DrawingItem::pick() may test the point against, before expanding by delta.
+Geom::OptRect pick_bounds(DrawingItem const &item)
+{
+    Geom::OptIntRect box = item.geometricBounds();
+    box.unionWith(item.visualBounds());
+    if (auto glyphs = dynamic_cast<DrawingGlyphs const *>(&item)) {
+        box.unionWith(glyphs->getPickBox());
+    }
+    return box ? Geom::OptRect(*box) : Geom::OptRect();
+}
+
+} // namespace
+
 DrawingGroup::DrawingGroup(Drawing &drawing)
     : DrawingItem(drawing)
 {}
@@ -82,9 +100,47 @@ unsigned DrawingGroup::_updateItem(Geom::IntRect const &area, UpdateContext cons
             _bbox.unionWith(outline ? i.geometricBounds() : i.visualBounds());
         }
     }
+    _updatePickIndex();
     return STATE_ALL;
 }
 
+/**
+ * Bring the pick index up-to-date with the boxes of the children, creating it if the group has
+ * become large enough to benefit from one. Children are always updated before this is called.
+ */
+void DrawingGroup::_updatePickIndex()
+{
+    if (_children.size() < PICK_INDEX_THRESHOLD) {
+        _pick_index.reset();
+        return;
+    }
+
+    if (!_pick_index) {
+        std::vector<Util::RectTree<DrawingItem *>::Entry> entries;
+        entries.reserve(_children.size());
+        for (auto &i : _children) {
+            entries.emplace_back(pick_bounds(i), &i);
+        }
+        _pick_index = std::make_unique<Util::RectTree<DrawingItem *>>(std::move(entries));
+        return;
+    }
+
+    // The children are the same and in the same order as when the index was built, since
+    // _childrenChanged() discards it otherwise. So only the boxes need to be refreshed.
+    std::size_t n = 0;
+    for (auto &i : _children) {
+        assert(_pick_index->value(n) == &i);
+        _pick_index->update(n, pick_bounds(i));
+        n++;
+    }
+}
+
+void DrawingGroup::_childrenChanged()
+{
+    // Rebuilt on next update; until then, picking falls back to a linear scan.
+    _pick_index.reset();
+}
+
 unsigned DrawingGroup::_renderItem(DrawingContext &dc, Geom::IntRect const &area, unsigned flags, DrawingItem *stop_at)
 {
     if (stop_at == nullptr) {
@@ -122,6 +178,18 @@ void DrawingGroup::_clipItem(DrawingContext &dc, Geom::IntRect const &area)
 
 DrawingItem *DrawingGroup::_pickItem(Geom::Point const &p, double delta, unsigned flags)
 {
+    if (_pick_index) {
+        // Only the children whose box can contain the point need testing. They are returned in
+        // z-order, so the result is the same as that of the linear scan below.
+        for (auto n : _pick_index->query(p, delta)) {
+            DrawingItem *picked = _pick_index->value(n)->pick(p, delta, flags);
+            if (picked) {
+                return _pick_children ? picked : this;
+            }
+        }
+        return nullptr;
+    }
+
     for (auto &i : _children) {
         DrawingItem *picked = i.pick(p, delta, flags);
         if (picked) {
@@ -13,7 +13,10 @@
 #ifndef SEEN_INKSCAPE_DISPLAY_DRAWING_GROUP_H
 #define SEEN_INKSCAPE_DISPLAY_DRAWING_GROUP_H
 
+#include <memory>
+
 #include "display/drawing-item.h"
+#include "util/rect-tree.h"
 
 namespace Inkscape {
 
@@ -37,8 +40,14 @@ protected:
     void _clipItem(DrawingContext &dc, Geom::IntRect const &area) override;
     DrawingItem *_pickItem(Geom::Point const &p, double delta, unsigned flags) override;
     bool _canClip() override;
+    void _childrenChanged() override;
+
+    void _updatePickIndex();
 
     std::unique_ptr<Geom::Affine> _child_transform;
+
+    /// Spatial index of the children's pick boxes, in z-order; only kept for groups with many children.
+    std::unique_ptr<Util::RectTree<DrawingItem *>> _pick_index;
 };
 
 bool is_drawing_group(DrawingItem *item);
@@ -0,0 +1,221 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Drawing items that show one shared subtree at several places, e.g. the clones of a symbol
+ *//*
+ * Authors: see git history
+ *
+ * Copyright (C) 2022 Authors
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include "display/drawing-instance.h"
+
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+
+#include "display/drawing-context.h"
+#include "display/drawing-surface.h"
+#include "display/drawing.h"
+
+namespace Inkscape {
+
+namespace {
+
+// Content larger than this many pixels is always drawn as vectors rather than kept rendered.
+constexpr double MAX_RASTER_AREA = 1 << 20;
+
+/// Returns whether the transform only moves by a whole number of pixels.
+bool is_pixel_translation(Geom::Affine const &affine)
+{
+    double constexpr EPS = 1e-6;
+    if (!affine.withoutTranslation().isIdentity(EPS)) {
+        return false;
+    }
+    auto const t = affine.translation();
+    return std::abs(t.x() - std::round(t.x())) < EPS && std::abs(t.y() - std::round(t.y())) < EPS;
+}
+
+} // namespace
+
+DrawingSource::DrawingSource(Drawing &drawing)
+    : DrawingGroup(drawing)
+{
+    _child_type = CHILD_SOURCE;
+}
+
+DrawingSource::~DrawingSource() = default;
+
+void DrawingSource::_markInstancesForUpdate(unsigned flags)
+{
+    _raster.reset();
+    if (_updating) {
+        // updated by one of the instances, which takes care of its own boxes
+        return;
+    }
+    for (auto instance : _instances) {
+        instance->_markForUpdate(flags, false);
+    }
+}
+
+void DrawingSource::_markInstancesForRendering()
+{
+    _raster.reset();
+    if (_updating) {
+        // each instance marks its own area once it is updated
+        return;
+    }
+    for (auto instance : _instances) {
+        instance->_markForRendering();
+    }
+}
+
+/**
+ * Returns all of the content rendered at the source transform, or null if it is too large to
+ * keep. The rendering is made on first use and kept until the content or the transform changes.
+ */
+DrawingSurface *DrawingSource::_rasterize(int device_scale)
+{
+    std::lock_guard<std::recursive_mutex> lock(_drawing.cacheMutex());
+    if (_raster && _raster->device_scale() == device_scale) {
+        return _raster.get();
+    }
+    _raster.reset();
+    if (!_drawbox || _drawbox->hasZeroArea() || double(_drawbox->width()) * _drawbox->height() > MAX_RASTER_AREA) {
+        return nullptr;
+    }
+    _raster = std::make_unique<DrawingSurface>(*_drawbox, device_scale);
+    DrawingContext dc(*_raster);
+    _renderItem(dc, *_drawbox, RENDER_BYPASS_CACHE, nullptr);
+    return _raster.get();
+}
+
+DrawingInstance::DrawingInstance(Drawing &drawing, DrawingSource *source)
+    : DrawingItem(drawing)
+    , _source(source)
+{
+    _source->_instances.push_back(this);
+}
+
+DrawingInstance::~DrawingInstance()
+{
+    auto &instances = _source->_instances;
+    instances.erase(std::find(instances.begin(), instances.end(), this));
+    if (instances.empty()) {
+        delete _source;
+    }
+}
+
+Geom::Affine DrawingInstance::_sourceToInstance() const
+{
+    if (_source->_source_ctm.isSingular(1e-18)) {
+        return Geom::identity();
+    }
+    return _source->_source_ctm.inverse() * _ctm;
+}
+
+unsigned DrawingInstance::_updateItem(Geom::IntRect const &/*area*/, UpdateContext const &ctx, unsigned flags, unsigned reset)
+{
+    auto &source = *_source;
+    source._updating = true;
+    // The first instance decides the transform of the content; the others render it through the
+    // difference, and only share its rendering if that is a whole pixel translation.
+    if (source._instances.front() == this) {
+        Geom::Affine const source_ctm = ctx.ctm.withoutTranslation();
+        if (!Geom::are_near(source._source_ctm, source_ctm, 1e-18)) {
+            source._source_ctm = source_ctm;
+            source._markForUpdate(STATE_ALL, true);
+            for (auto instance : source._instances) {
+                if (instance != this) {
+                    instance->_markForUpdate(STATE_ALL, false);
+                }
+            }
+        }
+    }
+    // Only the first instance updated in a pass passes on the reset, e.g. of a zoom, so that the
+    // content is updated once however many instances there are.
+    bool const first_in_pass = source._update_pass != _drawing.updatePass();
+    source._update_pass = _drawing.updatePass();
+    source.update(Geom::IntRect::infinite(), {source._source_ctm}, flags, first_in_pass ? reset : 0);
+    source._updating = false;
+
+    bool outline = _drawing.outline() || _drawing.outlineOverlay();
+    Geom::OptIntRect box = outline ? source.geometricBounds() : source.visualBounds();
+    if (box) {
+        _bbox = (Geom::Rect(*box) * _sourceToInstance()).roundOutwards();
+    } else {
+        _bbox = Geom::OptIntRect();
+    }
+    return STATE_ALL;
+}
+
+unsigned DrawingInstance::_renderItem(DrawingContext &dc, Geom::IntRect const &area, unsigned flags, DrawingItem *stop_at)
+{
+    Geom::Affine const to_instance = _sourceToInstance();
+    bool const outline = _drawing.outline();
+
+    if (!outline && !stop_at && !(flags & RENDER_FILTER_BACKGROUND) && _source->instanceCount() > 1 &&
+        is_pixel_translation(to_instance)) {
+        if (auto raster = _source->_rasterize(dc.surface()->device_scale())) {
+            Geom::IntPoint const offset(std::round(to_instance[4]), std::round(to_instance[5]));
+            dc.save();
+            dc.translate(offset);
+            dc.rectangle(area - offset);
+            dc.setSource(raster);
+            dc.fill();
+            dc.restore();
+            dc.setSource(0, 0, 0, 0);
+            return RENDER_OK;
+        }
+    }
+
+    Geom::OptIntRect source_area = (Geom::Rect(area) * to_instance.inverse()).roundOutwards();
+    source_area.intersectWith(outline ? _source->geometricBounds() : _source->visualBounds());
+    if (!source_area) {
+        return RENDER_OK;
+    }
+    dc.save();
+    dc.transform(to_instance);
+    unsigned result = _source->_renderItem(dc, *source_area, flags | RENDER_BYPASS_CACHE, stop_at);
+    dc.restore();
+    return result;
+}
+
+void DrawingInstance::_clipItem(DrawingContext &dc, Geom::IntRect const &area)
+{
+    Geom::Affine const to_instance = _sourceToInstance();
+    Geom::OptIntRect source_area = (Geom::Rect(area) * to_instance.inverse()).roundOutwards();
+    source_area.intersectWith(_source->geometricBounds());
+    if (!source_area) {
+        return;
+    }
+    dc.save();
+    dc.transform(to_instance);
+    _source->_clipItem(dc, *source_area);
+    dc.restore();
+}
+
+DrawingItem *DrawingInstance::_pickItem(Geom::Point const &p, double delta, unsigned flags)
+{
+    Geom::Affine const to_source = _sourceToInstance().inverse();
+    double const scale = to_source.descrim();
+    return _source->_pickItem(p * to_source, delta * scale, flags) ? this : nullptr;
+}
+
+bool DrawingInstance::_canClip()
+{
+    return true;
+}
+
+} // namespace Inkscape
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,106 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Drawing items that show one shared subtree at several places, e.g. the clones of a symbol
+ *//*
+ * Authors: see git history
+ *
+ * Copyright (C) 2022 Authors
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#ifndef SEEN_INKSCAPE_DISPLAY_DRAWING_INSTANCE_H
+#define SEEN_INKSCAPE_DISPLAY_DRAWING_INSTANCE_H
+
+#include <memory>
+#include <vector>
+
+#include "display/drawing-group.h"
+
+namespace Inkscape {
+
+class DrawingInstance;
+class DrawingSurface;
+
+/**
+ * @brief Content shared by several DrawingInstance items.
+ *
+ * The source is not part of the drawing tree. It is updated once per update of the drawing, at the
+ * transform of its first instance without the translation, and every instance renders it at its
+ * own transform. Changes to the content are passed on to all instances.
+ *
+ * The source is deleted with its last instance.
+ */
+class DrawingSource
+    : public DrawingGroup
+{
+public:
+    DrawingSource(Drawing &drawing);
+    ~DrawingSource() override;
+
+    std::size_t instanceCount() const { return _instances.size(); }
+
+protected:
+    void _markInstancesForUpdate(unsigned flags);
+    void _markInstancesForRendering();
+    DrawingSurface *_rasterize(int device_scale);
+
+    std::vector<DrawingInstance *> _instances;
+    Geom::Affine _source_ctm; ///< The transform the content is updated at
+    std::unique_ptr<DrawingSurface> _raster; ///< All of the content, rendered at _source_ctm
+    unsigned _update_pass = 0; ///< Drawing::updatePass() of the last update by an instance
+    bool _updating = false;
+
+    friend class DrawingItem;
+    friend class DrawingInstance;
+};
+
+/**
+ * @brief Drawing tree node that renders a DrawingSource at its own transform.
+ *
+ * Where the instance differs from the source only by a whole number of pixels, the content is
+ * painted from a rendering that all such instances share. Otherwise it is drawn as vectors
+ * through the difference of the transforms.
+ *
+ * The content must not need intermediate surfaces, which are aligned to device pixels: it may
+ * not have filters, clips, masks, opacity or blend modes.
+ */
+class DrawingInstance
+    : public DrawingItem
+{
+public:
+    DrawingInstance(Drawing &drawing, DrawingSource *source);
+    ~DrawingInstance() override;
+
+    DrawingSource *source() const { return _source; }
+
+protected:
+    unsigned _updateItem(Geom::IntRect const &area, UpdateContext const &ctx,
+                         unsigned flags, unsigned reset) override;
+    unsigned _renderItem(DrawingContext &dc, Geom::IntRect const &area, unsigned flags,
+                         DrawingItem *stop_at) override;
+    void _clipItem(DrawingContext &dc, Geom::IntRect const &area) override;
+    DrawingItem *_pickItem(Geom::Point const &p, double delta, unsigned flags) override;
+    bool _canClip() override;
+
+    /// Transform from the display coordinates of the source to those of this instance.
+    Geom::Affine _sourceToInstance() const;
+
+    DrawingSource *_source;
+
+    friend class DrawingSource;
+};
+
+} // namespace Inkscape
+
+#endif // SEEN_INKSCAPE_DISPLAY_DRAWING_INSTANCE_H
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -11,9 +11,11 @@
  */
 
 #include <climits>
+#include <mutex>
 
 #include "display/drawing-context.h"
 #include "display/drawing-group.h"
+#include "display/drawing-instance.h"
 #include "display/drawing-item.h"
 #include "display/drawing-pattern.h"
 #include "display/drawing-surface.h"
@@ -117,6 +119,7 @@ DrawingItem::~DrawingItem()
     case CHILD_NORMAL: {
         ChildrenList::iterator ithis = _parent->_children.iterator_to(*this);
         _parent->_children.erase(ithis);
+        _parent->_childrenChanged();
         } break;
     case CHILD_CLIP:
         // we cannot call setClip(NULL) or setMask(NULL),
@@ -146,6 +149,9 @@ DrawingItem::~DrawingItem()
     delete _fill_pattern;
     delete _clip;
     delete _mask;
+    if (_filter) {
+        _drawing.filterCache().forget(this);
+    }
     delete _filter;
     if (_style) sp_style_unref(_style);
 }
@@ -172,6 +178,7 @@ void DrawingItem::appendChild(DrawingItem *item)
     assert(item->_child_type == CHILD_ORPHAN);
     item->_child_type = CHILD_NORMAL;
     _children.push_back(*item);
+    _childrenChanged();
 
     // This ensures that _markForUpdate() called on the child will recurse to this item
     item->_state = STATE_ALL;
@@ -188,6 +195,7 @@ void DrawingItem::prependChild(DrawingItem *item)
     assert(item->_child_type == CHILD_ORPHAN);
     item->_child_type = CHILD_NORMAL;
     _children.push_front(*item);
+    _childrenChanged();
     // See appendChild for explanation
     item->_state = STATE_ALL;
     item->_markForUpdate(STATE_ALL, true);
@@ -207,6 +215,7 @@ void DrawingItem::clearChildren()
         i._child_type = CHILD_ORPHAN;
     }
     _children.clear_and_dispose(DeleteDisposer());
+    _childrenChanged();
     _markForUpdate(STATE_ALL, false);
 }
 
@@ -335,6 +344,9 @@ void DrawingItem::setStyle(SPStyle const *style, SPStyle const *context_style)
         style->getFilter()->build_renderer(_filter);
     } else {
         // no filter set for this group
+        if (_filter) {
+            _drawing.filterCache().forget(this);
+        }
         delete _filter;
         _filter = nullptr;
     }
@@ -453,6 +465,7 @@ void DrawingItem::setZOrder(unsigned z)
     ChildrenList::iterator i = _parent->_children.begin();
     std::advance(i, std::min(z, unsigned(_parent->_children.size())));
     _parent->_children.insert(i, *this);
+    _parent->_childrenChanged();
     _markForRendering();
 }
 
@@ -701,6 +714,7 @@ DrawingItem::render(DrawingContext &dc, Geom::IntRect const &area, unsigned flag
     Geom::OptIntRect iarea = carea;
     // expand carea to contain the dependent area of filters.
     if (forcecache) {
+        std::lock_guard<std::recursive_mutex> lock(_drawing.cacheMutex());
         iarea = _cacheRect();
         if (!iarea) {
             iarea = carea;
@@ -725,6 +739,7 @@ DrawingItem::render(DrawingContext &dc, Geom::IntRect const &area, unsigned flag
     // Render from cache if possible
     // Bypass in case of pattern, see below.
     if (_cached && !(flags & RENDER_BYPASS_CACHE)) {
+        std::lock_guard<std::recursive_mutex> lock(_drawing.cacheMutex());
         if (_cache && _cache->device_scale() != device_scale) {
             delete _cache;
             _cache = nullptr;
@@ -765,11 +780,14 @@ DrawingItem::render(DrawingContext &dc, Geom::IntRect const &area, unsigned flag
     nir |= (_mix_blend_mode != SP_CSS_BLEND_NORMAL); // 5. it has blend mode           
     nir |= (_isolation == SP_CSS_ISOLATION_ISOLATE); // 6. it is isolated    
     nir |= !parent();                                // 7. is root, need isolation from background
-    if (_prev_nir && !needs_intermediate_rendering) {
-        setCached(false, true);
+    {
+        std::lock_guard<std::recursive_mutex> lock(_drawing.cacheMutex());
+        if (_prev_nir && !needs_intermediate_rendering) {
+            setCached(false, true);
+        }
+        _prev_nir = needs_intermediate_rendering;
+        nir |= (_cache != nullptr);                  // 8. it is to be cached
     }
-    _prev_nir = needs_intermediate_rendering;
-    nir |= (_cache != nullptr);                      // 8. it is to be cached
 
     /* How the rendering is done.
      *
@@ -875,13 +893,16 @@ DrawingItem::render(DrawingContext &dc, Geom::IntRect const &area, unsigned flag
     ict.paint();
 
     // 6. Paint the completed rendering onto the base context (or into cache)
-    if (_cached && _cache) {
-        DrawingContext cachect(*_cache);
-        cachect.rectangle(*carea);
-        cachect.setOperator(CAIRO_OPERATOR_SOURCE);
-        cachect.setSource(&intermediate);
-        cachect.fill();
-        _cache->markClean(*carea);
+    {
+        std::lock_guard<std::recursive_mutex> lock(_drawing.cacheMutex());
+        if (_cached && _cache) {
+            DrawingContext cachect(*_cache);
+            cachect.rectangle(*carea);
+            cachect.setOperator(CAIRO_OPERATOR_SOURCE);
+            cachect.setSource(&intermediate);
+            cachect.fill();
+            _cache->markClean(*carea);
+        }
     }
 
     dc.rectangle(*carea);
@@ -1078,6 +1099,7 @@ DrawingItem::_markForRendering()
 
     // dirty the caches of all parents
     DrawingItem *bkg_root = nullptr;
+    DrawingItem *top = this;
 
     for (DrawingItem *i = this; i; i = i->_parent) {
         if (i != this && i->_filter) {
@@ -1089,6 +1111,13 @@ DrawingItem::_markForRendering()
         if (i->_background_accumulate) {
             bkg_root = i;
         }
+        top = i;
+    }
+
+    if (top->_child_type == CHILD_SOURCE) {
+        // shown only through its instances, which are somewhere else on the canvas
+        static_cast<DrawingSource *>(top)->_markInstancesForRendering();
+        return;
     }
 
     if (bkg_root && bkg_root->_parent && bkg_root->_parent->_parent) {
@@ -1147,6 +1176,8 @@ DrawingItem::_markForUpdate(unsigned flags, bool propagate)
         if (oldstate != _state && _parent) {
             // If we actually reset anything in state, recurse on the parent.
             _parent->_markForUpdate(flags, false);
+        } else if (oldstate != _state && _child_type == CHILD_SOURCE) {
+            static_cast<DrawingSource *>(this)->_markInstancesForUpdate(flags);
         } else {
             // If nothing changed, it means our ancestors are already invalidated
             // up to the root. Do not bother recursing, because it won't change anything.
@@ -154,7 +154,8 @@ protected:
         CHILD_MASK = 3, // referenced by _mask member of parent
         CHILD_ROOT = 4, // root item of _drawing
         CHILD_FILL_PATTERN = 5, // referenced by fill pattern of parent
-        CHILD_STROKE_PATTERN = 6 // referenced by stroke pattern of parent
+        CHILD_STROKE_PATTERN = 6, // referenced by stroke pattern of parent
+        CHILD_SOURCE = 7 // shared by DrawingInstance items, see drawing-instance.h
     };
     enum RenderResult {
         RENDER_OK = 0,
@@ -173,6 +174,7 @@ protected:
     virtual void _clipItem(DrawingContext &/*dc*/, Geom::IntRect const &/*area*/) {}
     virtual DrawingItem *_pickItem(Geom::Point const &/*p*/, double /*delta*/, unsigned /*flags*/) { return nullptr; }
     virtual bool _canClip() { return false; }
+    virtual void _childrenChanged() {} ///< Called when children are added, removed or reordered.
 
     // static functions start here
 
@@ -10,6 +10,8 @@
  * Released under GNU GPL v2+, read the file 'COPYING' for more information.
  */
 
+#include <vector>
+
 #include "2geom/pathvector.h"
 
 #include "style.h"
@@ -19,6 +21,7 @@
 #include "display/drawing-surface.h"
 #include "display/drawing-text.h"
 #include "display/drawing.h"
+#include "display/glyph-cache.h"
 
 #include "helper/geom.h"
 
@@ -26,6 +29,76 @@
 
 namespace Inkscape {
 
+namespace {
+
+/**
+ * Fills the current path and the glyph masks with the current source. The coverage of all glyphs
+ * is first added up in one mask at device pixels, so that where glyphs overlap or abut they are
+ * painted once, as when they are filled as one path.
+ */
+void fill_with_glyph_masks(DrawingContext &dc, std::vector<GlyphCache::Mask> const &masks, cairo_fill_rule_t fill_rule)
+{
+    if (masks.empty()) {
+        dc.fillPreserve();
+        return;
+    }
+
+    cairo_t *cr = dc.raw();
+    double scale_x, scale_y;
+    cairo_surface_get_device_scale(cairo_get_group_target(cr), &scale_x, &scale_y);
+    cairo_matrix_t matrix;
+    cairo_get_matrix(cr, &matrix);
+    Geom::Affine to_device;
+    ink_matrix_to_2geom(to_device, matrix);
+    to_device *= Geom::Scale(scale_x, scale_y);
+
+    Geom::OptIntRect area;
+    for (auto const &mask : masks) {
+        area.unionWith(Geom::IntRect::from_xywh(mask.origin, {cairo_image_surface_get_width(mask.surface),
+                                                              cairo_image_surface_get_height(mask.surface)}));
+    }
+    double x0, y0, x1, y1;
+    cairo_fill_extents(cr, &x0, &y0, &x1, &y1);
+    if (x0 < x1 && y0 < y1) {
+        area.unionWith((Geom::Rect(x0, y0, x1, y1) * to_device).roundOutwards());
+    }
+    cairo_clip_extents(cr, &x0, &y0, &x1, &y1);
+    area.intersectWith((Geom::Rect(x0, y0, x1, y1) * to_device).roundOutwards());
+    if (!area) {
+        return;
+    }
+
+    // Glyphs too large for masks are in the path. ADD clamps the sum to full coverage.
+    cairo_surface_t *coverage = cairo_image_surface_create(CAIRO_FORMAT_A8, area->width(), area->height());
+    cairo_t *ct = cairo_create(coverage);
+    cairo_set_antialias(ct, cairo_get_antialias(cr));
+    cairo_set_fill_rule(ct, fill_rule);
+    cairo_translate(ct, -area->left(), -area->top());
+    ink_cairo_transform(ct, to_device);
+    cairo_path_t *path = cairo_copy_path(cr);
+    cairo_append_path(ct, path);
+    cairo_path_destroy(path);
+    cairo_fill(ct);
+    cairo_identity_matrix(ct);
+    cairo_set_operator(ct, CAIRO_OPERATOR_ADD);
+    for (auto const &mask : masks) {
+        cairo_set_source_surface(ct, mask.surface, mask.origin.x() - area->left(), mask.origin.y() - area->top());
+        cairo_paint(ct);
+    }
+    cairo_destroy(ct);
+
+    Inkscape::DrawingContext::Save save(dc);
+    cairo_identity_matrix(cr);
+    cairo_pattern_t *pattern = cairo_pattern_create_for_surface(coverage);
+    cairo_matrix_init(&matrix, scale_x, 0, 0, scale_y, -area->left(), -area->top());
+    cairo_pattern_set_matrix(pattern, &matrix);
+    cairo_pattern_set_filter(pattern, CAIRO_FILTER_NEAREST);
+    cairo_mask(cr, pattern);
+    cairo_pattern_destroy(pattern);
+    cairo_surface_destroy(coverage);
+}
+
+} // namespace
 
 DrawingGlyphs::DrawingGlyphs(Drawing &drawing)
     : DrawingItem(drawing)
@@ -220,6 +293,7 @@ void DrawingText::clear()
 {
     _markForRendering();
     _children.clear_and_dispose(DeleteDisposer());
+    _childrenChanged();
 }
 
 bool DrawingText::addComponent(std::shared_ptr<FontInstance> const &font, int glyph, Geom::Affine const &trans, float width, float ascent, float descent, float phase_length)
@@ -591,6 +665,21 @@ unsigned DrawingText::_renderItem(DrawingContext &dc, Geom::IntRect const &/*are
             dc.newPath(); // Clear text-decoration path
         }
 
+        // Small glyphs that are only filled are composited from coverage masks, which are cached,
+        // instead of being added to the path.
+        GlyphCache &glyph_cache = _drawing.glyphCache();
+        bool const use_masks = has_fill && !has_stroke && glyph_cache.enabled() && !_drawing.getExact();
+        std::vector<GlyphCache::Mask> masks;
+        Geom::Affine to_device;
+        if (use_masks) {
+            cairo_matrix_t matrix;
+            cairo_get_matrix(dc.raw(), &matrix);
+            ink_matrix_to_2geom(to_device, matrix);
+            double scale_x, scale_y;
+            cairo_surface_get_device_scale(cairo_get_group_target(dc.raw()), &scale_x, &scale_y);
+            to_device *= Geom::Scale(scale_x, scale_y);
+        }
+
         // Accumulate the path that represents the glyphs and/or draw SVG glyphs.
         for (auto &i : _children) {
             DrawingGlyphs *g = dynamic_cast<DrawingGlyphs *>(&i);
@@ -625,6 +714,14 @@ unsigned DrawingText::_renderItem(DrawingContext &dc, Geom::IntRect const &/*are
                         dc.path(*g->pathvec);
                     }
                 } else {
+                    if (use_masks) {
+                        auto mask = glyph_cache.get(g->_font, g->_glyph, *g->pathvec, g->_ctm * to_device,
+                                                    _nrstyle.fill_rule, cairo_get_antialias(dc.raw()));
+                        if (mask.surface) {
+                            masks.push_back(mask);
+                            continue;
+                        }
+                    }
                     dc.path(*g->pathvec);
                 }
             }
@@ -636,7 +733,7 @@ unsigned DrawingText::_renderItem(DrawingContext &dc, Geom::IntRect const &/*are
             dc.transform(_ctm);
             if (has_fill && fill_first) {
                 _nrstyle.applyFill(dc);
-                dc.fillPreserve();
+                fill_with_glyph_masks(dc, masks, _nrstyle.fill_rule);
             }
         }
         {
@@ -666,10 +763,13 @@ unsigned DrawingText::_renderItem(DrawingContext &dc, Geom::IntRect const &/*are
             dc.transform(_ctm);
             if (has_fill && !fill_first) {
                 _nrstyle.applyFill(dc);
-                dc.fillPreserve();
+                fill_with_glyph_masks(dc, masks, _nrstyle.fill_rule);
             }
         }
         dc.newPath(); // Clear glyphs path
+        for (auto &mask : masks) {
+            cairo_surface_destroy(mask.surface);
+        }
 
         // Draw text decorations that go OVER the text (line through, blink)
         if (decorate) {
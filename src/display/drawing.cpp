@@ -33,8 +33,9 @@ static constexpr double grayscale_value_matrix[20] = {
 };
 
 Drawing::Drawing(Inkscape::CanvasItemDrawing *canvas_item_drawing)
-    : _canvas_item_drawing(canvas_item_drawing)
+    : _share_clones(canvas_item_drawing != nullptr)
     , _grayscale_colormatrix(std::vector<gdouble>(grayscale_value_matrix, grayscale_value_matrix + 20))
+    , _canvas_item_drawing(canvas_item_drawing)
 {
     // _canvas_item_drawing can be null. Used this way by Eraser tool.
 }
@@ -157,6 +158,8 @@ void
 Drawing::setCacheBudget(size_t bytes)
 {
     _cache_budget = bytes;
+    _filter_cache.setBudget(bytes / 4);
+    _glyph_cache.setBudget(bytes / 8);
     _pickItemsForCaching();
 }
 
@@ -169,6 +172,7 @@ Drawing::setGrayscaleMatrix(gdouble value_matrix[20]) {
 void
 Drawing::update(Geom::IntRect const &area, unsigned flags, unsigned reset)
 {
+    _update_pass++;
     if (_root) {
         auto ctx = _canvas_item_drawing ? _canvas_item_drawing->get_context() : UpdateContext();
         _root->update(area, ctx, flags, reset);
@@ -17,11 +17,14 @@
 #include <2geom/pathvector.h>
 #include <boost/operators.hpp>
 #include <boost/utility.hpp>
+#include <mutex>
 #include <set>
 #include <sigc++/sigc++.h>
 
 #include "display/drawing-item.h"
 #include "display/rendermode.h"
+#include "glyph-cache.h"
+#include "nr-filter-cache.h"
 #include "nr-filter-gaussian.h" // BLUR_QUALITY_BEST
 #include "nr-filter-colormatrix.h"
 
@@ -72,6 +75,24 @@ public:
     void setCacheLimit(Geom::OptIntRect const &r);
     void setCacheBudget(size_t bytes);
 
+    /// Whether clones that draw the same share one set of drawing items. On for the canvas.
+    bool shareClones() const { return _share_clones; }
+    void setShareClones(bool share) { _share_clones = share; }
+
+    /// Number of the current or last call to update(), to tell items updated in the same pass.
+    unsigned updatePass() const { return _update_pass; }
+
+    /// Guards the item caches, which are lazily created and filled during rendering.
+    /// Must be held when touching them from render(), so that several areas of the
+    /// drawing may be rendered concurrently.
+    std::recursive_mutex &cacheMutex() const { return _cache_mutex; }
+
+    /// Results of filter rendering, which get a share of the cache budget.
+    Filters::FilterCache &filterCache() { return _filter_cache; }
+
+    /// Coverage masks of small glyphs, which get a share of the cache budget.
+    GlyphCache &glyphCache() { return _glyph_cache; }
+
     OutlineColors const &colors() const { return _colors; }
 
     void setGrayscaleMatrix(double value_matrix[20]);
@@ -100,6 +121,8 @@ public:
 
 private:
     bool _exact = false;  // if true then rendering must be exact
+    bool _share_clones = false;
+    unsigned _update_pass = 0;
     RenderMode _rendermode = RenderMode::NORMAL;
     ColorMode _colormode = ColorMode::NORMAL;
     int _blur_quality = BLUR_QUALITY_BEST;
@@ -108,6 +131,9 @@ private:
 
     double _cache_score_threshold = 50000.0; ///< do not consider objects for caching below this score
     size_t _cache_budget = 0;                ///< maximum allowed size of cache
+    mutable std::recursive_mutex _cache_mutex;
+    Filters::FilterCache _filter_cache;
+    GlyphCache _glyph_cache;
 
     OutlineColors _colors;
     Filters::FilterColorMatrix::ColorMatrixMatrix _grayscale_colormatrix;
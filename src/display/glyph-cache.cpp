@@ -0,0 +1,177 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Coverage masks of glyphs rendered at small sizes, kept for reuse by all
+ * text of a drawing.
+ *
+ * Authors:
+ *   See git history.
+ *
+ * Copyright (C) 2022 Authors
+ *
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <iterator>
+#include <utility>
+
+#include "display/cairo-utils.h"
+#include "display/glyph-cache.h"
+
+namespace Inkscape {
+
+namespace {
+
+// Steps in which the transform of a glyph is rounded, in device pixels.
+int const LINEAR_STEPS = 16;
+int const SUBPIXEL_STEPS = 4;
+
+} // namespace
+
+bool GlyphCache::Key::operator==(Key const &other) const
+{
+    return font == other.font && glyph == other.glyph && std::equal(linear, linear + 4, other.linear) &&
+           subpixel == other.subpixel && fill_rule == other.fill_rule && antialias == other.antialias;
+}
+
+std::size_t GlyphCache::KeyHash::operator()(Key const &key) const
+{
+    std::size_t hash = std::hash<FontInstance const *>()(key.font);
+    for (int value : {key.glyph, key.linear[0], key.linear[1], key.linear[2], key.linear[3], key.subpixel,
+                      key.fill_rule, key.antialias}) {
+        hash = hash * 31 + std::hash<int>()(value);
+    }
+    return hash;
+}
+
+GlyphCache::~GlyphCache()
+{
+    while (!_entries.empty()) {
+        _erase(_entries.begin());
+    }
+}
+
+void GlyphCache::setBudget(std::size_t bytes)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _budget = bytes;
+    _trim();
+}
+
+GlyphCache::Mask GlyphCache::get(std::shared_ptr<FontInstance> const &font, int glyph, Geom::PathVector const &path,
+                                 Geom::Affine const &ctm, cairo_fill_rule_t fill_rule, cairo_antialias_t antialias)
+{
+    Mask mask;
+    if (!enabled() || path.empty() || std::max(ctm.expansionX(), ctm.expansionY()) > maxEmSize()) {
+        return mask;
+    }
+
+    Key key;
+    key.font = font.get();
+    key.glyph = glyph;
+    for (int i = 0; i < 4; ++i) {
+        key.linear[i] = std::lround(ctm[i] * LINEAR_STEPS);
+    }
+    Geom::IntPoint whole(int(std::floor(ctm[4])), int(std::floor(ctm[5])));
+    int subpixel_x = std::lround((ctm[4] - whole.x()) * SUBPIXEL_STEPS);
+    int subpixel_y = std::lround((ctm[5] - whole.y()) * SUBPIXEL_STEPS);
+    if (subpixel_x == SUBPIXEL_STEPS) {
+        subpixel_x = 0;
+        whole.x() += 1;
+    }
+    if (subpixel_y == SUBPIXEL_STEPS) {
+        subpixel_y = 0;
+        whole.y() += 1;
+    }
+    key.subpixel = subpixel_y * SUBPIXEL_STEPS + subpixel_x;
+    key.fill_rule = fill_rule;
+    key.antialias = antialias;
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto found = _index.find(key);
+        if (found != _index.end()) {
+            _entries.splice(_entries.begin(), _entries, found->second);
+            mask.surface = cairo_surface_reference(found->second->surface);
+            mask.origin = whole + found->second->offset;
+            return mask;
+        }
+    }
+
+    // Render the glyph at the rounded transform, outside the lock.
+    Geom::Affine const rounded(double(key.linear[0]) / LINEAR_STEPS, double(key.linear[1]) / LINEAR_STEPS,
+                               double(key.linear[2]) / LINEAR_STEPS, double(key.linear[3]) / LINEAR_STEPS,
+                               double(subpixel_x) / SUBPIXEL_STEPS, double(subpixel_y) / SUBPIXEL_STEPS);
+    Geom::OptRect bounds = (path * rounded).boundsFast();
+    if (!bounds) {
+        return mask;
+    }
+    Geom::IntRect const area = bounds->roundOutwards();
+    if (area.hasZeroArea()) {
+        return mask;
+    }
+
+    cairo_surface_t *surface = cairo_image_surface_create(CAIRO_FORMAT_A8, area.width(), area.height());
+    cairo_t *ct = cairo_create(surface);
+    cairo_set_antialias(ct, antialias);
+    cairo_set_fill_rule(ct, fill_rule);
+    cairo_translate(ct, -area.left(), -area.top());
+    ink_cairo_transform(ct, rounded);
+    feed_pathvector_to_cairo(ct, path);
+    cairo_fill(ct);
+    cairo_destroy(ct);
+    cairo_surface_flush(surface);
+
+    std::size_t const size = sizeof(Entry) + std::size_t(cairo_image_surface_get_stride(surface)) * area.height();
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto found = _index.find(key);
+    if (found != _index.end()) {
+        // another thread rendered it meanwhile
+        cairo_surface_destroy(surface);
+        mask.surface = cairo_surface_reference(found->second->surface);
+        mask.origin = whole + found->second->offset;
+        return mask;
+    }
+
+    mask.surface = surface;
+    mask.origin = whole + area.min();
+    if (size > _budget) {
+        return mask;
+    }
+    _entries.push_front({key, font, cairo_surface_reference(surface), area.min(), size});
+    _index.emplace(key, _entries.begin());
+    _size += size;
+    _trim();
+    return mask;
+}
+
+void GlyphCache::_erase(std::list<Entry>::iterator it)
+{
+    cairo_surface_destroy(it->surface);
+    _size -= it->size;
+    _index.erase(it->key);
+    _entries.erase(it);
+}
+
+void GlyphCache::_trim()
+{
+    while (_size > _budget && !_entries.empty()) {
+        _erase(std::prev(_entries.end()));
+    }
+}
+
+} /* namespace Inkscape */
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
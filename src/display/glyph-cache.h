@@ -0,0 +1,115 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#ifndef SEEN_INKSCAPE_DISPLAY_GLYPH_CACHE_H
+#define SEEN_INKSCAPE_DISPLAY_GLYPH_CACHE_H
+
+/*
+ * Coverage masks of glyphs rendered at small sizes, kept for reuse by all
+ * text of a drawing.
+ *
+ * Authors:
+ *   See git history.
+ *
+ * Copyright (C) 2022 Authors
+ *
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <2geom/affine.h>
+#include <2geom/int-point.h>
+#include <2geom/pathvector.h>
+#include <cairo.h>
+
+class FontInstance;
+
+namespace Inkscape {
+
+/**
+ * Least recently used coverage masks of glyphs, shared by all text items of a drawing.
+ *
+ * A mask is rendered for the linear part of the glyph's transform to device pixels, rounded to
+ * 1/16 of a pixel per em, and for the fractional part of its position, rounded to a quarter of a
+ * pixel. Glyphs larger than maxEmSize() on screen are not stored and should be drawn as paths.
+ */
+class GlyphCache {
+public:
+    /** A mask to be composited at the device pixel \a origin. */
+    struct Mask {
+        cairo_surface_t *surface = nullptr; ///< a new reference, or nullptr
+        Geom::IntPoint origin;
+    };
+
+    GlyphCache() = default;
+    GlyphCache(GlyphCache const &) = delete;
+    GlyphCache &operator=(GlyphCache const &) = delete;
+    ~GlyphCache();
+
+    /** Sets the memory that the stored masks may use. Zero disables the cache. */
+    void setBudget(std::size_t bytes);
+
+    /** Whether masks are stored at all. */
+    bool enabled() const { return _budget != 0; }
+
+    /** The largest em size in device pixels for which masks are made. */
+    static double maxEmSize() { return 48.0; }
+
+    /**
+     * Returns the coverage of \a path, the outline of \a glyph of \a font, transformed by \a ctm to
+     * device pixels and filled with the given rule and antialiasing. Returns a null surface if the
+     * glyph is too large to be drawn from a mask, or has nothing to draw.
+     */
+    Mask get(std::shared_ptr<FontInstance> const &font, int glyph, Geom::PathVector const &path,
+             Geom::Affine const &ctm, cairo_fill_rule_t fill_rule, cairo_antialias_t antialias);
+
+private:
+    struct Key {
+        FontInstance const *font;
+        int glyph;
+        int linear[4]; ///< in 1/16 pixel per em
+        int subpixel;  ///< x and y offsets in quarter pixels
+        int fill_rule;
+        int antialias;
+
+        bool operator==(Key const &other) const;
+    };
+
+    struct KeyHash {
+        std::size_t operator()(Key const &key) const;
+    };
+
+    struct Entry {
+        Key key;
+        std::shared_ptr<FontInstance> font; ///< keeps the address in the key unique
+        cairo_surface_t *surface;
+        Geom::IntPoint offset; ///< of the mask from the integer part of the glyph origin
+        std::size_t size;
+    };
+
+    void _erase(std::list<Entry>::iterator it);
+    void _trim();
+
+    std::list<Entry> _entries; ///< most recently used first
+    std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> _index;
+    std::size_t _size = 0;
+    std::atomic<std::size_t> _budget{0};
+    std::mutex _mutex;
+};
+
+} /* namespace Inkscape */
+
+#endif /* SEEN_INKSCAPE_DISPLAY_GLYPH_CACHE_H */
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -52,6 +52,26 @@ void normalized_sum(Fvector &r, const Fvector &a, const Fvector &b) {
     normalize_vector(r);
 }
 
+void sobel_normals(double const *above, double const *row, double const *below, int n, double scale,
+                   Fvector *normals)
+{
+    // The sums of alpha values are exact, so this gives the same normals as the weighted sums
+    // written out in surfaceNormalAt().
+    double const fx = -scale/255.0 * (1.0/4.0);
+    double const fy = fx;
+
+    for (int i = 0; i < n; ++i) {
+        double x = (above[i+1] - above[i-1]) + 2.0 * (row[i+1] - row[i-1]) + (below[i+1] - below[i-1]);
+        double y = (below[i-1] - above[i-1]) + 2.0 * (below[i] - above[i]) + (below[i+1] - above[i+1]);
+        x *= fx;
+        y *= fy;
+        double nv = sqrt(x*x + y*y + 1.0*1.0);
+        normals[i][X_3D] = x / nv;
+        normals[i][Y_3D] = y / nv;
+        normals[i][Z_3D] = 1.0 / nv;
+    }
+}
+
 }/* namespace NR */
 
 /*
@@ -90,6 +90,23 @@ void normalized_sum(Fvector &r, const Fvector &a, const Fvector &b);
  */
 void convert_coord(double &x, double &y, double &z, Geom::Affine const &trans);
 
+/**
+ * Computes the surface normals of n pixels of a bump map with the 3x3 Sobel operator, where
+ * none of the pixels is on the edge of the map. The result is the same as that of
+ * SurfaceSynth::surfaceNormalAt(), but the loop has no branches, so it can be vectorized.
+ *
+ * \param above alpha values of the row above the pixels, starting at the first pixel
+ * \param row alpha values of the row of the pixels
+ * \param below alpha values of the row below the pixels
+ * \param n the number of pixels
+ * \param scale the surface scale
+ * \param normals where the n normalized normals are stored
+ *
+ * The alpha value before the first pixel and after the last one must be readable in each row.
+ */
+void sobel_normals(double const *above, double const *row, double const *below, int n, double scale,
+                   Fvector *normals);
+
 } /* namespace NR */
 
 #endif /* __NR_3DUTILS_H__ */
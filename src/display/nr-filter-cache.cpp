@@ -0,0 +1,182 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Results of filter rendering, kept for reuse while neither the filter nor
+ * its input changes.
+ *
+ * Authors:
+ *   See git history.
+ *
+ * Copyright (C) 2022 Authors
+ *
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include <cstring>
+#include <iterator>
+#include <utility>
+#include <cairo.h>
+
+#include "display/cairo-utils.h"
+#include "display/nr-filter-cache.h"
+
+namespace Inkscape {
+namespace Filters {
+
+namespace {
+
+bool is_image(cairo_surface_t *surface)
+{
+    return cairo_surface_get_type(surface) == CAIRO_SURFACE_TYPE_IMAGE &&
+           cairo_image_surface_get_format(surface) == CAIRO_FORMAT_ARGB32;
+}
+
+std::size_t surface_size(cairo_surface_t *surface)
+{
+    if (cairo_surface_get_type(surface) != CAIRO_SURFACE_TYPE_IMAGE) {
+        return 0;
+    }
+    return std::size_t(cairo_image_surface_get_stride(surface)) * cairo_image_surface_get_height(surface);
+}
+
+bool same_pixels(cairo_surface_t *a, cairo_surface_t *b)
+{
+    int const width = cairo_image_surface_get_width(a);
+    int const height = cairo_image_surface_get_height(a);
+    if (width != cairo_image_surface_get_width(b) || height != cairo_image_surface_get_height(b)) {
+        return false;
+    }
+
+    cairo_surface_flush(a);
+    cairo_surface_flush(b);
+    int const stride_a = cairo_image_surface_get_stride(a);
+    int const stride_b = cairo_image_surface_get_stride(b);
+    unsigned char const *row_a = cairo_image_surface_get_data(a);
+    unsigned char const *row_b = cairo_image_surface_get_data(b);
+    for (int y = 0; y < height; ++y, row_a += stride_a, row_b += stride_b) {
+        if (std::memcmp(row_a, row_b, 4 * width) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+bool FilterCache::Key::operator==(Key const &other) const
+{
+    return item == other.item && ctm == other.ctm && area == other.area && bbox == other.bbox &&
+           device_scale == other.device_scale && quality == other.quality &&
+           blur_quality == other.blur_quality && signature == other.signature;
+}
+
+FilterCache::~FilterCache()
+{
+    while (!_entries.empty()) {
+        _erase(_entries.begin());
+    }
+}
+
+void FilterCache::setBudget(std::size_t bytes)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _budget = bytes;
+    _trim();
+}
+
+cairo_surface_t *FilterCache::lookup(Key const &key, cairo_surface_t *source)
+{
+    if (!is_image(source)) {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (auto it = _entries.begin(); it != _entries.end(); ++it) {
+        if (it->key == key) {
+            if (!same_pixels(it->source, source)) {
+                // the item draws something else now
+                _erase(it);
+                return nullptr;
+            }
+            _entries.splice(_entries.begin(), _entries, it);
+            return cairo_surface_reference(it->result);
+        }
+    }
+    return nullptr;
+}
+
+cairo_surface_t *FilterCache::snapshot(cairo_surface_t *source)
+{
+    if (!is_image(source)) {
+        return nullptr;
+    }
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        // the result is usually as large as the source, and both are kept
+        if (2 * surface_size(source) > _budget) {
+            return nullptr;
+        }
+    }
+    return ink_cairo_surface_copy(source);
+}
+
+void FilterCache::insert(Key key, cairo_surface_t *snapshot, cairo_surface_t *result)
+{
+    std::size_t const size = surface_size(snapshot) + surface_size(result);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (auto it = _entries.begin(); it != _entries.end(); ++it) {
+        if (it->key == key) {
+            _erase(it);
+            break;
+        }
+    }
+    if (size > _budget) {
+        cairo_surface_destroy(snapshot);
+        return;
+    }
+
+    _entries.push_front({std::move(key), snapshot, cairo_surface_reference(result), size});
+    _size += size;
+    _trim();
+}
+
+void FilterCache::forget(DrawingItem const *item)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (auto it = _entries.begin(); it != _entries.end();) {
+        auto next = std::next(it);
+        if (it->key.item == item) {
+            _erase(it);
+        }
+        it = next;
+    }
+}
+
+void FilterCache::_erase(std::list<Entry>::iterator it)
+{
+    cairo_surface_destroy(it->source);
+    cairo_surface_destroy(it->result);
+    _size -= it->size;
+    _entries.erase(it);
+}
+
+void FilterCache::_trim()
+{
+    while (_size > _budget && !_entries.empty()) {
+        _erase(std::prev(_entries.end()));
+    }
+}
+
+} /* namespace Filters */
+} /* namespace Inkscape */
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,115 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#ifndef SEEN_NR_FILTER_CACHE_H
+#define SEEN_NR_FILTER_CACHE_H
+
+/*
+ * Results of filter rendering, kept for reuse while neither the filter nor
+ * its input changes.
+ *
+ * Authors:
+ *   See git history.
+ *
+ * Copyright (C) 2022 Authors
+ *
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include <cstddef>
+#include <list>
+#include <mutex>
+#include <string>
+#include <2geom/affine.h>
+#include <2geom/rect.h>
+
+extern "C" {
+typedef struct _cairo_surface cairo_surface_t;
+}
+
+namespace Inkscape {
+class DrawingItem;
+
+namespace Filters {
+
+/**
+ * Least recently used results of Filter::render(), shared by all items of a drawing.
+ *
+ * A result is reused when the item renders the same area through the same filter, at the same
+ * transform and quality, and its source graphic is the same pixel for pixel. The source graphic
+ * is compared rather than tracked, because items are marked for rendering on many changes that
+ * do not alter what they draw.
+ */
+class FilterCache {
+public:
+    struct Key {
+        DrawingItem const *item;
+        std::string signature; ///< see Filter::set_signature()
+        Geom::Affine ctm;
+        Geom::IntRect area;
+        Geom::OptRect bbox;
+        int device_scale;
+        int quality;
+        int blur_quality;
+
+        bool operator==(Key const &other) const;
+    };
+
+    FilterCache() = default;
+    FilterCache(FilterCache const &) = delete;
+    FilterCache &operator=(FilterCache const &) = delete;
+    ~FilterCache();
+
+    /** Sets the memory that the stored results and sources may use. Zero disables the cache. */
+    void setBudget(std::size_t bytes);
+
+    /**
+     * Returns a new reference to the result stored for the key, if it was computed from the same
+     * source graphic; otherwise returns nullptr.
+     */
+    cairo_surface_t *lookup(Key const &key, cairo_surface_t *source);
+
+    /**
+     * Returns a copy of the source graphic, to be passed to insert() once the filter has been
+     * rendered from it, or nullptr if its result cannot be stored.
+     */
+    cairo_surface_t *snapshot(cairo_surface_t *source);
+
+    /**
+     * Stores the result of rendering the filter from the snapshot of the source graphic.
+     * Takes over the snapshot and adds a reference to the result.
+     */
+    void insert(Key key, cairo_surface_t *snapshot, cairo_surface_t *result);
+
+    /** Drops all results of the item. */
+    void forget(DrawingItem const *item);
+
+private:
+    struct Entry {
+        Key key;
+        cairo_surface_t *source;
+        cairo_surface_t *result;
+        std::size_t size;
+    };
+
+    void _erase(std::list<Entry>::iterator it);
+    void _trim();
+
+    std::list<Entry> _entries; ///< most recently used first
+    std::size_t _size = 0;
+    std::size_t _budget = 0;
+    std::mutex _mutex;
+};
+
+} /* namespace Filters */
+} /* namespace Inkscape */
+
+#endif /* SEEN_NR_FILTER_CACHE_H */
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -13,6 +13,7 @@
 
 #include <cmath>
 #include <algorithm>
+#include "display/cairo-simd.h"
 #include "display/cairo-templates.h"
 #include "display/cairo-utils.h"
 #include "display/nr-filter-colormatrix.h"
@@ -47,30 +48,11 @@ FilterColorMatrix::ColorMatrixMatrix::ColorMatrixMatrix(std::vector<double> cons
 }
 
 guint32 FilterColorMatrix::ColorMatrixMatrix::operator()(guint32 in) {
-    EXTRACT_ARGB32(in, a, r, g, b)
-    // we need to un-premultiply alpha values for this type of matrix
-    // TODO: unpremul can be ignored if there is an identity mapping on the alpha channel
-    if (a != 0) {
-        r = unpremul_alpha(r, a);
-        g = unpremul_alpha(g, a);
-        b = unpremul_alpha(b, a);
-    }
+    return Inkscape::SIMD::color_matrix(in, _v);
+}
 
-    gint32 ro = r*_v[0]  + g*_v[1]  + b*_v[2]  + a*_v[3]  + _v[4];
-    gint32 go = r*_v[5]  + g*_v[6]  + b*_v[7]  + a*_v[8]  + _v[9];
-    gint32 bo = r*_v[10] + g*_v[11] + b*_v[12] + a*_v[13] + _v[14];
-    gint32 ao = r*_v[15] + g*_v[16] + b*_v[17] + a*_v[18] + _v[19];
-    ro = (pxclamp(ro, 0, 255*255) + 127) / 255;
-    go = (pxclamp(go, 0, 255*255) + 127) / 255;
-    bo = (pxclamp(bo, 0, 255*255) + 127) / 255;
-    ao = (pxclamp(ao, 0, 255*255) + 127) / 255;
-
-    ro = premul_alpha(ro, ao);
-    go = premul_alpha(go, ao);
-    bo = premul_alpha(bo, ao);
-
-    ASSEMBLE_ARGB32(pxout, ao, ro, go, bo)
-    return pxout;
+void FilterColorMatrix::ColorMatrixMatrix::filter_row(guint32 const *in, guint32 *out, int n) {
+    Inkscape::SIMD::color_matrix_row(in, out, n, _v);
 }
 
 
@@ -84,16 +66,10 @@ struct ColorMatrixSaturate {
     }
 
     guint32 operator()(guint32 in) {
-        EXTRACT_ARGB32(in, a, r, g, b)
-
-        // Note: this cannot be done in fixed point, because the loss of precision
-        //       causes overflow for some values of v
-        guint32 ro = r*_v[0] + g*_v[1] + b*_v[2] + 0.5;
-        guint32 go = r*_v[3] + g*_v[4] + b*_v[5] + 0.5;
-        guint32 bo = r*_v[6] + g*_v[7] + b*_v[8] + 0.5;
-
-        ASSEMBLE_ARGB32(pxout, a, ro, go, bo)
-        return pxout;
+        return Inkscape::SIMD::color_matrix_saturate(in, _v);
+    }
+    void filter_row(guint32 const *in, guint32 *out, int n) {
+        Inkscape::SIMD::color_matrix_saturate_row(in, out, n, _v);
     }
 private:
     double _v[9];
@@ -117,17 +93,10 @@ struct ColorMatrixHueRotate {
         _v[8] = round((0.072 +0.928*coshue +0.072*sinhue)*255);
     }
     guint32 operator()(guint32 in) {
-        EXTRACT_ARGB32(in, a, r, g, b)
-        gint32 maxpx = a*255;
-        gint32 ro = r*_v[0] + g*_v[1] + b*_v[2];
-        gint32 go = r*_v[3] + g*_v[4] + b*_v[5];
-        gint32 bo = r*_v[6] + g*_v[7] + b*_v[8];
-        ro = (pxclamp(ro, 0, maxpx) + 127) / 255;
-        go = (pxclamp(go, 0, maxpx) + 127) / 255;
-        bo = (pxclamp(bo, 0, maxpx) + 127) / 255;
-
-        ASSEMBLE_ARGB32(pxout, a, ro, go, bo)
-        return pxout;
+        return Inkscape::SIMD::color_matrix_hue_rotate(in, _v);
+    }
+    void filter_row(guint32 const *in, guint32 *out, int n) {
+        Inkscape::SIMD::color_matrix_hue_rotate_row(in, out, n, _v);
     }
 private:
     gint32 _v[9];
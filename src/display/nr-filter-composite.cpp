@@ -12,6 +12,7 @@
 
 #include <cmath>
 
+#include "display/cairo-simd.h"
 #include "display/cairo-templates.h"
 #include "display/cairo-utils.h"
 #include "display/nr-filter-composite.h"
@@ -35,31 +36,19 @@ FilterComposite::~FilterComposite()
 
 struct ComposeArithmetic {
     ComposeArithmetic(double k1, double k2, double k3, double k4)
-        : _k1(round(k1 * 255))
-        , _k2(round(k2 * 255*255))
-        , _k3(round(k3 * 255*255))
-        , _k4(round(k4 * 255*255*255))
+        : _k{(gint32)round(k1 * 255),
+             (gint32)round(k2 * 255*255),
+             (gint32)round(k3 * 255*255),
+             (gint32)round(k4 * 255*255*255)}
     {}
     guint32 operator()(guint32 in1, guint32 in2) {
-        EXTRACT_ARGB32(in1, aa, ra, ga, ba)
-        EXTRACT_ARGB32(in2, ab, rb, gb, bb)
-
-        gint32 ao = _k1*aa*ab + _k2*aa + _k3*ab + _k4;
-        gint32 ro = _k1*ra*rb + _k2*ra + _k3*rb + _k4;
-        gint32 go = _k1*ga*gb + _k2*ga + _k3*gb + _k4;
-        gint32 bo = _k1*ba*bb + _k2*ba + _k3*bb + _k4;
-
-        ao = pxclamp(ao, 0, 255*255*255); // r, g and b are premultiplied, so should be clamped to the alpha channel
-        ro = (pxclamp(ro, 0, ao) + (255*255/2)) / (255*255);
-        go = (pxclamp(go, 0, ao) + (255*255/2)) / (255*255);
-        bo = (pxclamp(bo, 0, ao) + (255*255/2)) / (255*255);
-        ao = (ao + (255*255/2)) / (255*255);
-
-        ASSEMBLE_ARGB32(pxout, ao, ro, go, bo)
-        return pxout;
+        return Inkscape::SIMD::compose_arithmetic(in1, in2, _k);
+    }
+    void blend_row(guint32 const *in1, guint32 const *in2, guint32 *out, int n) {
+        Inkscape::SIMD::compose_arithmetic_row(in1, in2, out, n, _k);
     }
 private:
-    gint32 _k1, _k2, _k3, _k4;
+    gint32 _k[4];
 };
 
 void FilterComposite::render_cairo(FilterSlot &slot)
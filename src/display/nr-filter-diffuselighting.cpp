@@ -17,6 +17,7 @@
 #endif
 
 #include <glib.h>
+#include <vector>
 
 #include "display/cairo-templates.h"
 #include "display/cairo-utils.h"
@@ -47,6 +48,11 @@ FilterPrimitive * FilterDiffuseLighting::create() {
 FilterDiffuseLighting::~FilterDiffuseLighting()
 = default;
 
+/*
+ * The derived functors provide the lighting of a pixel with a given surface normal:
+ *   guint32 lightAt(int x, int y, NR::Fvector const &normal);
+ */
+template <typename Light>
 struct DiffuseLight : public SurfaceSynth {
     DiffuseLight(cairo_surface_t *bumpmap, double scale, double kd)
         : SurfaceSynth(bumpmap)
@@ -54,9 +60,19 @@ struct DiffuseLight : public SurfaceSynth {
         , _kd(kd)
     {}
 
+    guint32 operator()(int x, int y) {
+        return static_cast<Light *>(this)->lightAt(x, y, surfaceNormalAt(x, y, _scale));
+    }
+    void synthesize_row(int y, int x0, int x1, guint32 *out) {
+        std::vector<NR::Fvector> normals(x1 - x0);
+        surfaceNormalsRow(y, x0, x1, _scale, normals.data());
+        for (int x = x0; x < x1; ++x) {
+            out[x - x0] = static_cast<Light *>(this)->lightAt(x, y, normals[x - x0]);
+        }
+    }
+
 protected:
-    guint32 diffuseLighting(int x, int y, NR::Fvector const &light, NR::Fvector const &light_components) {
-        NR::Fvector normal = surfaceNormalAt(x, y, _scale);
+    guint32 diffuseLighting(NR::Fvector const &normal, NR::Fvector const &light, NR::Fvector const &light_components) {
         double k = _kd * NR::scalar_product(normal, light);
 
         guint32 r = CLAMP_D_TO_U8(k * light_components[LIGHT_RED]);
@@ -69,7 +85,7 @@ protected:
     double _scale, _kd;
 };
 
-struct DiffuseDistantLight : public DiffuseLight {
+struct DiffuseDistantLight : public DiffuseLight<DiffuseDistantLight> {
     DiffuseDistantLight(cairo_surface_t *bumpmap, SPFeDistantLight *light, guint32 color,
             double scale, double diffuse_constant)
         : DiffuseLight(bumpmap, scale, diffuse_constant)
@@ -79,14 +95,14 @@ struct DiffuseDistantLight : public DiffuseLight {
         dl.light_components(_light_components);
     }
 
-    guint32 operator()(int x, int y) {
-        return diffuseLighting(x, y, _lightv, _light_components);
+    guint32 lightAt(int /*x*/, int /*y*/, NR::Fvector const &normal) {
+        return diffuseLighting(normal, _lightv, _light_components);
     }
 private:
     NR::Fvector _lightv, _light_components;
 };
 
-struct DiffusePointLight : public DiffuseLight {
+struct DiffusePointLight : public DiffuseLight<DiffusePointLight> {
     DiffusePointLight(cairo_surface_t *bumpmap, SPFePointLight *light, guint32 color,
                       Geom::Affine const &trans, double scale, double diffuse_constant,
                       double x0, double y0, int device_scale)
@@ -98,10 +114,10 @@ struct DiffusePointLight : public DiffuseLight {
         _light.light_components(_light_components);
     }
 
-    guint32 operator()(int x, int y) {
+    guint32 lightAt(int x, int y, NR::Fvector const &normal) {
         NR::Fvector light;
         _light.light_vector(light, _x0 + x, _y0 + y, _scale * alphaAt(x, y)/255.0);
-        return diffuseLighting(x, y, light, _light_components);
+        return diffuseLighting(normal, light, _light_components);
     }
 private:
     PointLight _light;
@@ -109,7 +125,7 @@ private:
     double _x0, _y0;
 };
 
-struct DiffuseSpotLight : public DiffuseLight {
+struct DiffuseSpotLight : public DiffuseLight<DiffuseSpotLight> {
     DiffuseSpotLight(cairo_surface_t *bumpmap, SPFeSpotLight *light, guint32 color,
                      Geom::Affine const &trans, double scale, double diffuse_constant,
                      double x0, double y0, int device_scale)
@@ -119,11 +135,11 @@ struct DiffuseSpotLight : public DiffuseLight {
         , _y0(y0)
     {}
 
-    guint32 operator()(int x, int y) {
+    guint32 lightAt(int x, int y, NR::Fvector const &normal) {
         NR::Fvector light, light_components;
         _light.light_vector(light, _x0 + x, _y0 + y, _scale * alphaAt(x, y)/255.0);
         _light.light_components(light_components, light);
-        return diffuseLighting(x, y, light, light_components);
+        return diffuseLighting(normal, light, light_components);
     }
 private:
     SpotLight _light;
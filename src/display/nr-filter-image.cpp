@@ -23,6 +23,7 @@
 #include "display/nr-filter-units.h"
 #include "enums.h"
 #include <glibmm/fileutils.h>
+#include <mutex>
 
 namespace Inkscape {
 namespace Filters {
@@ -52,6 +53,11 @@ void FilterImage::render_cairo(FilterSlot &slot)
     if (!feImageHref)
         return;
 
+    // Both code paths below touch the object tree or lazily load the image, neither of
+    // which may happen on more than one rendering thread at a time.
+    static std::mutex mutex;
+    std::lock_guard<std::mutex> lock(mutex);
+
     //cairo_surface_t *input = slot.getcairo(_input);
 
     // Viewport is filter primitive area (in user coordinates).
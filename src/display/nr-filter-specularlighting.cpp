@@ -48,6 +48,11 @@ FilterPrimitive * FilterSpecularLighting::create() {
 FilterSpecularLighting::~FilterSpecularLighting()
 = default;
 
+/*
+ * The derived functors provide the lighting of a pixel with a given surface normal:
+ *   guint32 lightAt(int x, int y, NR::Fvector const &normal);
+ */
+template <typename Light>
 struct SpecularLight : public SurfaceSynth {
     SpecularLight(cairo_surface_t *bumpmap, double scale, double specular_constant,
             double specular_exponent)
@@ -56,9 +61,20 @@ struct SpecularLight : public SurfaceSynth {
         , _ks(specular_constant)
         , _exp(specular_exponent)
     {}
+
+    guint32 operator()(int x, int y) {
+        return static_cast<Light *>(this)->lightAt(x, y, surfaceNormalAt(x, y, _scale));
+    }
+    void synthesize_row(int y, int x0, int x1, guint32 *out) {
+        std::vector<NR::Fvector> normals(x1 - x0);
+        surfaceNormalsRow(y, x0, x1, _scale, normals.data());
+        for (int x = x0; x < x1; ++x) {
+            out[x - x0] = static_cast<Light *>(this)->lightAt(x, y, normals[x - x0]);
+        }
+    }
+
 protected:
-    guint32 specularLighting(int x, int y, NR::Fvector const &halfway, NR::Fvector const &light_components) {
-        NR::Fvector normal = surfaceNormalAt(x, y, _scale);
+    guint32 specularLighting(NR::Fvector const &normal, NR::Fvector const &halfway, NR::Fvector const &light_components) {
         double sp = NR::scalar_product(normal, halfway);
         double k = sp <= 0.0 ? 0.0 : _ks * pow(sp, _exp);
 
@@ -77,7 +93,7 @@ protected:
     double _scale, _ks, _exp;
 };
 
-struct SpecularDistantLight : public SpecularLight {
+struct SpecularDistantLight : public SpecularLight<SpecularDistantLight> {
     SpecularDistantLight(cairo_surface_t *bumpmap, SPFeDistantLight *light, guint32 color,
             double scale, double specular_constant, double specular_exponent)
         : SpecularLight(bumpmap, scale, specular_constant, specular_exponent)
@@ -88,14 +104,14 @@ struct SpecularDistantLight : public SpecularLight {
         dl.light_components(_light_components);
         NR::normalized_sum(_halfway, lv, NR::EYE_VECTOR);
     }
-    guint32 operator()(int x, int y) {
-        return specularLighting(x, y, _halfway, _light_components);
+    guint32 lightAt(int /*x*/, int /*y*/, NR::Fvector const &normal) {
+        return specularLighting(normal, _halfway, _light_components);
     }
 private:
     NR::Fvector _halfway, _light_components;
 };
 
-struct SpecularPointLight : public SpecularLight {
+struct SpecularPointLight : public SpecularLight<SpecularPointLight> {
     SpecularPointLight(cairo_surface_t *bumpmap, SPFePointLight *light, guint32 color,
             Geom::Affine const &trans, double scale, double specular_constant,
             double specular_exponent, double x0, double y0, int device_scale)
@@ -107,11 +123,11 @@ struct SpecularPointLight : public SpecularLight {
         _light.light_components(_light_components);
     }
 
-    guint32 operator()(int x, int y) {
+    guint32 lightAt(int x, int y, NR::Fvector const &normal) {
         NR::Fvector light, halfway;
         _light.light_vector(light, _x0 + x, _y0 + y, _scale * alphaAt(x, y)/255.0);
         NR::normalized_sum(halfway, light, NR::EYE_VECTOR);
-        return specularLighting(x, y, halfway, _light_components);
+        return specularLighting(normal, halfway, _light_components);
     }
 private:
     PointLight _light;
@@ -119,7 +135,7 @@ private:
     double _x0, _y0;
 };
 
-struct SpecularSpotLight : public SpecularLight {
+struct SpecularSpotLight : public SpecularLight<SpecularSpotLight> {
     SpecularSpotLight(cairo_surface_t *bumpmap, SPFeSpotLight *light, guint32 color,
             Geom::Affine const &trans, double scale, double specular_constant,
             double specular_exponent, double x0, double y0, int device_scale)
@@ -129,12 +145,12 @@ struct SpecularSpotLight : public SpecularLight {
         , _y0(y0)
     {}
 
-    guint32 operator()(int x, int y) {
+    guint32 lightAt(int x, int y, NR::Fvector const &normal) {
         NR::Fvector light, halfway, light_components;
         _light.light_vector(light, _x0 + x, _y0 + y, _scale * alphaAt(x, y)/255.0);
         _light.light_components(light_components, light);
         NR::normalized_sum(halfway, light, NR::EYE_VECTOR);
-        return specularLighting(x, y, halfway, light_components);
+        return specularLighting(normal, halfway, light_components);
     }
 private:
     SpotLight _light;
@@ -18,13 +18,29 @@
  * Released under GNU GPL v2+, read the file 'COPYING' for more information.
  */
 
+#include "display/cairo-simd.h"
 #include "display/cairo-templates.h"
 #include "display/cairo-utils.h"
 #include "display/nr-filter.h"
 #include "display/nr-filter-turbulence.h"
 #include "display/nr-filter-units.h"
 #include "display/nr-filter-utils.h"
+#include <algorithm>
 #include <cmath>
+#include <cstring>
+
+// The channels of a pixel are computed together when the CPU supports AVX2.
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+# define INK_TURBULENCE_AVX2 1
+# define INK_TURBULENCE_INLINE inline __attribute__((always_inline))
+# if !defined(__clang__)
+// Vectors are only passed to functions inlined into the AVX2 code.
+#  pragma GCC diagnostic ignored "-Wpsabi"
+# endif
+#else
+# define INK_TURBULENCE_AVX2 0
+# define INK_TURBULENCE_INLINE inline
+#endif
 
 namespace Inkscape {
 namespace Filters{
@@ -66,14 +82,14 @@ public:
                 _latticeSelector[i] = i;
 
                 do {
-                  _gradient[i][k][0] = static_cast<double>(_random() % (BSize*2) - BSize) / BSize;
-                  _gradient[i][k][1] = static_cast<double>(_random() % (BSize*2) - BSize) / BSize;
-                } while(_gradient[i][k][0] == 0 && _gradient[i][k][1] == 0);
+                  _gradient[i][0][k] = static_cast<double>(_random() % (BSize*2) - BSize) / BSize;
+                  _gradient[i][1][k] = static_cast<double>(_random() % (BSize*2) - BSize) / BSize;
+                } while(_gradient[i][0][k] == 0 && _gradient[i][1][k] == 0);
 
                 // normalize gradient
-                double s = hypot(_gradient[i][k][0], _gradient[i][k][1]);
-                _gradient[i][k][0] /= s;
-                _gradient[i][k][1] /= s;
+                double s = hypot(_gradient[i][0][k], _gradient[i][1][k]);
+                _gradient[i][0][k] /= s;
+                _gradient[i][1][k] /= s;
             }
         }
         while (--i) {
@@ -88,8 +104,8 @@ public:
             _latticeSelector[BSize + i] = _latticeSelector[i];
 
             for(int k = 0; k < 4; ++k) {
-                _gradient[BSize + i][k][0] = _gradient[i][k][0];
-                _gradient[BSize + i][k][1] = _gradient[i][k][1];
+                _gradient[BSize + i][0][k] = _gradient[i][0][k];
+                _gradient[BSize + i][1][k] = _gradient[i][1][k];
             }
         }
 
@@ -116,32 +132,167 @@ public:
             _wrapx = _tile.left() * _baseFreq[Geom::X] + PerlinOffset + _wrapw;
             _wrapy = _tile.top() * _baseFreq[Geom::Y] + PerlinOffset + _wraph;
         }
+#if INK_TURBULENCE_AVX2
+        _avx2 = SIMD::get_level() >= SIMD::Level::AVX2;
+#endif
         _inited = true;
     }
 
     G_GNUC_PURE
     guint32 turbulencePixel(Geom::Point const &p) const {
+#if INK_TURBULENCE_AVX2
+        if (_avx2) {
+            return _turbulencePixelAVX2(p);
+        }
+#endif
+        return _turbulencePixel<ScalarChannels>(p);
+    }
+
+    //G_GNUC_PURE
+    /*guint32 turbulencePixel(Geom::Point const &p) const {
+        if (!_fractalnoise) {
+            guint32 r = CLAMP_D_TO_U8(turbulence(0, p)*255.0);
+            guint32 g = CLAMP_D_TO_U8(turbulence(1, p)*255.0);
+            guint32 b = CLAMP_D_TO_U8(turbulence(2, p)*255.0);
+            guint32 a = CLAMP_D_TO_U8(turbulence(3, p)*255.0);
+            r = premul_alpha(r, a);
+            g = premul_alpha(g, a);
+            b = premul_alpha(b, a);
+            ASSEMBLE_ARGB32(pxout, a,r,g,b);
+            return pxout;
+        } else {
+            guint32 r = CLAMP_D_TO_U8((turbulence(0, p)*255.0 + 255.0) / 2);
+            guint32 g = CLAMP_D_TO_U8((turbulence(1, p)*255.0 + 255.0) / 2);
+            guint32 b = CLAMP_D_TO_U8((turbulence(2, p)*255.0 + 255.0) / 2);
+            guint32 a = CLAMP_D_TO_U8((turbulence(3, p)*255.0 + 255.0) / 2);
+            r = premul_alpha(r, a);
+            g = premul_alpha(g, a);
+            b = premul_alpha(b, a);
+            ASSEMBLE_ARGB32(pxout, a,r,g,b);
+            return pxout;
+        }
+    }*/
+
+    bool ready() const { return _inited; }
+    void dirty() { _inited = false; }
+
+private:
+    void _setupSeed(long seed) {
+        _seed = seed;
+        if (_seed <= 0) _seed = -(_seed % (RAND_m - 1)) + 1;
+        if (_seed > RAND_m - 1) _seed = RAND_m - 1;
+    }
+    long _random() {
+        /* Produces results in the range [1, 2**31 - 2].
+         * Algorithm is: r = (a * r) mod m
+         * where a = 16807 and m = 2**31 - 1 = 2147483647
+         * See [Park & Miller], CACM vol. 31 no. 10 p. 1195, Oct. 1988
+         * To test: the algorithm should produce the result 1043618065
+         * as the 10,000th generated number if the original seed is 1. */
+        _seed = RAND_a * (_seed % RAND_q) - RAND_r * (_seed / RAND_q);
+        if (_seed <= 0) _seed += RAND_m;
+        return _seed;
+    }
+    static inline double _scurve(double t) {
+        return t * t * (3.0 - 2.0*t);
+    }
+    static inline double _lerp(double t, double a, double b) {
+        return a + t * (b-a);
+    }
+    // Same as floor(), for the range of int.
+    static inline int _floor(double t) {
+        int i = t;
+        return i > t ? i - 1 : i;
+    }
+
+    /// The gradients around a point and its position in the lattice cell, for one octave.
+    struct Lattice {
+        double const (*q00)[4], (*q01)[4], (*q10)[4], (*q11)[4];
+        double rx0, rx1, ry0, ry1, sx, sy;
+        double scale;
+    };
+
+    /// Sums of the noise of the four channels over the octaves, computed one channel at a time.
+    struct ScalarChannels {
+        void add(Lattice const &l, bool fractalnoise) {
+            // channel numbering: R=0, G=1, B=2, A=3
+            for (int k = 0; k < 4; ++k) {
+                double a = _lerp(l.sx, l.rx0 * l.q00[0][k] + l.ry0 * l.q00[1][k],
+                                       l.rx1 * l.q10[0][k] + l.ry0 * l.q10[1][k]);
+                double b = _lerp(l.sx, l.rx0 * l.q01[0][k] + l.ry1 * l.q01[1][k],
+                                       l.rx1 * l.q11[0][k] + l.ry1 * l.q11[1][k]);
+                double result = _lerp(l.sy, a, b);
+                _sum[k] += (fractalnoise ? result : fabs(result)) * l.scale;
+            }
+        }
+        void get(double *sum) const {
+            std::copy(_sum, _sum + 4, sum);
+        }
+    private:
+        double _sum[4] = {0.0, 0.0, 0.0, 0.0};
+    };
+
+#if INK_TURBULENCE_AVX2
+    /// Same as ScalarChannels, with the four channels in one vector.
+    struct VectorChannels {
+        typedef double V4 __attribute__((vector_size(32)));
+        typedef long long L4 __attribute__((vector_size(32)));
+
+        INK_TURBULENCE_INLINE void add(Lattice const &l, bool fractalnoise) {
+            V4 a0 = l.rx0 * _load(l.q00[0]) + l.ry0 * _load(l.q00[1]);
+            V4 a1 = l.rx1 * _load(l.q10[0]) + l.ry0 * _load(l.q10[1]);
+            V4 a = a0 + l.sx * (a1 - a0);
+            V4 b0 = l.rx0 * _load(l.q01[0]) + l.ry1 * _load(l.q01[1]);
+            V4 b1 = l.rx1 * _load(l.q11[0]) + l.ry1 * _load(l.q11[1]);
+            V4 b = b0 + l.sx * (b1 - b0);
+            V4 result = a + l.sy * (b - a);
+            if (!fractalnoise) {
+                // fabs(), by clearing the sign bits
+                L4 const mask = {~0ULL >> 1, ~0ULL >> 1, ~0ULL >> 1, ~0ULL >> 1};
+                result = (V4)((L4)result & mask);
+            }
+            _sum += result * l.scale;
+        }
+        INK_TURBULENCE_INLINE void get(double *sum) const {
+            std::memcpy(sum, &_sum, sizeof(_sum));
+        }
+    private:
+        static INK_TURBULENCE_INLINE V4 _load(double const *p) {
+            V4 v;
+            std::memcpy(&v, p, sizeof(v));
+            return v;
+        }
+        V4 _sum = {0.0, 0.0, 0.0, 0.0};
+    };
+
+    __attribute__((target("avx2")))
+    guint32 _turbulencePixelAVX2(Geom::Point const &p) const {
+        return _turbulencePixel<VectorChannels>(p);
+    }
+#endif
+
+    template <typename Channels>
+    INK_TURBULENCE_INLINE guint32 _turbulencePixel(Geom::Point const &p) const {
         int wrapx = _wrapx, wrapy = _wrapy, wrapw = _wrapw, wraph = _wraph;
 
-        double pixel[4];
+        Channels channels;
         double x = p[Geom::X] * _baseFreq[Geom::X];
         double y = p[Geom::Y] * _baseFreq[Geom::Y];
         double ratio = 1.0;
 
-        for (double & k : pixel)
-            k = 0.0;
-
         for(int octave = 0; octave < _octaves; ++octave)
         {
+            Lattice l;
+
             double tx = x + PerlinOffset;
-            double bx = floor(tx);
-            double rx0 = tx - bx, rx1 = rx0 - 1.0;
-            int bx0 = bx, bx1 = bx0 + 1;
+            int bx0 = _floor(tx), bx1 = bx0 + 1;
+            l.rx0 = tx - bx0;
+            l.rx1 = l.rx0 - 1.0;
 
             double ty = y + PerlinOffset;
-            double by = floor(ty);
-            double ry0 = ty - by, ry1 = ry0 - 1.0;
-            int by0 = by, by1 = by0 + 1;
+            int by0 = _floor(ty), by1 = by0 + 1;
+            l.ry0 = ty - by0;
+            l.ry1 = l.ry0 - 1.0;
 
             if (_stitchTiles) {
                 if (bx0 >= wrapx) bx0 -= wrapw;
@@ -156,35 +307,16 @@ public:
 
             int i = _latticeSelector[bx0];
             int j = _latticeSelector[bx1];
-            int b00 = _latticeSelector[i + by0];
-            int b01 = _latticeSelector[i + by1];
-            int b10 = _latticeSelector[j + by0];
-            int b11 = _latticeSelector[j + by1];
+            l.q00 = _gradient[_latticeSelector[i + by0]];
+            l.q01 = _gradient[_latticeSelector[i + by1]];
+            l.q10 = _gradient[_latticeSelector[j + by0]];
+            l.q11 = _gradient[_latticeSelector[j + by1]];
 
-            double sx = _scurve(rx0);
-            double sy = _scurve(ry0);
-
-            double result[4];
-            // channel numbering: R=0, G=1, B=2, A=3
-            for (int k = 0; k < 4; ++k) {
-                double const *qxa = _gradient[b00][k];
-                double const *qxb = _gradient[b10][k];
-                double a = _lerp(sx, rx0 * qxa[0] + ry0 * qxa[1],
-                                     rx1 * qxb[0] + ry0 * qxb[1]);
-                double const *qya = _gradient[b01][k];
-                double const *qyb = _gradient[b11][k];
-                double b = _lerp(sx, rx0 * qya[0] + ry1 * qya[1],
-                                     rx1 * qyb[0] + ry1 * qyb[1]);
-                result[k] = _lerp(sy, a, b);
-            }
+            l.sx = _scurve(l.rx0);
+            l.sy = _scurve(l.ry0);
+            l.scale = 1.0 / ratio; // exact, since ratio is a power of 2
 
-            if (_fractalnoise) {
-                for (int k = 0; k < 4; ++k)
-                    pixel[k] += result[k] / ratio;
-            } else {
-                for (int k = 0; k < 4; ++k)
-                    pixel[k] += fabs(result[k]) / ratio;
-            }
+            channels.add(l, _fractalnoise);
 
             x *= 2;
             y *= 2;
@@ -201,6 +333,8 @@ public:
             }
         }
 
+        double pixel[4];
+        channels.get(pixel);
         if (_fractalnoise) {
             guint32 r = CLAMP_D_TO_U8((pixel[0]*255.0 + 255.0) / 2);
             guint32 g = CLAMP_D_TO_U8((pixel[1]*255.0 + 255.0) / 2);
@@ -224,58 +358,6 @@ public:
         }
     }
 
-    //G_GNUC_PURE
-    /*guint32 turbulencePixel(Geom::Point const &p) const {
-        if (!_fractalnoise) {
-            guint32 r = CLAMP_D_TO_U8(turbulence(0, p)*255.0);
-            guint32 g = CLAMP_D_TO_U8(turbulence(1, p)*255.0);
-            guint32 b = CLAMP_D_TO_U8(turbulence(2, p)*255.0);
-            guint32 a = CLAMP_D_TO_U8(turbulence(3, p)*255.0);
-            r = premul_alpha(r, a);
-            g = premul_alpha(g, a);
-            b = premul_alpha(b, a);
-            ASSEMBLE_ARGB32(pxout, a,r,g,b);
-            return pxout;
-        } else {
-            guint32 r = CLAMP_D_TO_U8((turbulence(0, p)*255.0 + 255.0) / 2);
-            guint32 g = CLAMP_D_TO_U8((turbulence(1, p)*255.0 + 255.0) / 2);
-            guint32 b = CLAMP_D_TO_U8((turbulence(2, p)*255.0 + 255.0) / 2);
-            guint32 a = CLAMP_D_TO_U8((turbulence(3, p)*255.0 + 255.0) / 2);
-            r = premul_alpha(r, a);
-            g = premul_alpha(g, a);
-            b = premul_alpha(b, a);
-            ASSEMBLE_ARGB32(pxout, a,r,g,b);
-            return pxout;
-        }
-    }*/
-
-    bool ready() const { return _inited; }
-    void dirty() { _inited = false; }
-
-private:
-    void _setupSeed(long seed) {
-        _seed = seed;
-        if (_seed <= 0) _seed = -(_seed % (RAND_m - 1)) + 1;
-        if (_seed > RAND_m - 1) _seed = RAND_m - 1;
-    }
-    long _random() {
-        /* Produces results in the range [1, 2**31 - 2].
-         * Algorithm is: r = (a * r) mod m
-         * where a = 16807 and m = 2**31 - 1 = 2147483647
-         * See [Park & Miller], CACM vol. 31 no. 10 p. 1195, Oct. 1988
-         * To test: the algorithm should produce the result 1043618065
-         * as the 10,000th generated number if the original seed is 1. */
-        _seed = RAND_a * (_seed % RAND_q) - RAND_r * (_seed / RAND_q);
-        if (_seed <= 0) _seed += RAND_m;
-        return _seed;
-    }
-    static inline double _scurve(double t) {
-        return t * t * (3.0 - 2.0*t);
-    }
-    static inline double _lerp(double t, double a, double b) {
-        return a + t * (b-a);
-    }
-
     // random number generator constants
     static long const
         RAND_m = 2147483647, // 2**31 - 1
@@ -292,7 +374,7 @@ private:
     Geom::Rect _tile;
     Geom::Point _baseFreq;
     int _latticeSelector[2*BSize + 2];
-    double _gradient[2*BSize + 2][4][2];
+    double _gradient[2*BSize + 2][2][4]; // x and y components of the four channels
     long _seed;
     int _octaves;
     bool _stitchTiles;
@@ -302,6 +384,9 @@ private:
     int _wraph;
     bool _inited;
     bool _fractalnoise;
+#if INK_TURBULENCE_AVX2
+    bool _avx2;
+#endif
 };
 
 FilterTurbulence::FilterTurbulence()
@@ -324,9 +409,38 @@ FilterPrimitive * FilterTurbulence::create() {
 
 FilterTurbulence::~FilterTurbulence()
 {
+    _clearCache();
     delete gen;
 }
 
+void FilterTurbulence::_addToCache(Geom::Affine const &trans, int x0, int y0, int width, int height,
+                                   cairo_surface_t *surface)
+{
+    std::size_t size = std::size_t(width) * height;
+    if (size > CACHE_PIXELS) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _cache.push_front({trans, x0, y0, width, height, cairo_surface_reference(surface)});
+    _cache_size += size;
+    while (_cache_size > CACHE_PIXELS) {
+        auto &last = _cache.back();
+        _cache_size -= std::size_t(last.width) * last.height;
+        cairo_surface_destroy(last.surface);
+        _cache.pop_back();
+    }
+}
+
+void FilterTurbulence::_clearCache()
+{
+    for (auto &tile : _cache) {
+        cairo_surface_destroy(tile.surface);
+    }
+    _cache.clear();
+    _cache_size = 0;
+}
+
 void FilterTurbulence::set_baseFrequency(int axis, double freq){
     if (axis==0) XbaseFrequency=freq;
     if (axis==1) YbaseFrequency=freq;
@@ -389,27 +503,47 @@ void FilterTurbulence::render_cairo(FilterSlot &slot)
     cairo_surface_get_device_scale(input, &x_scale, &y_scale);
     int width  = ceil(cairo_image_surface_get_width( input)/x_scale/x_scale);
     int height = ceil(cairo_image_surface_get_height(input)/y_scale/y_scale);
-    cairo_surface_t *temp = cairo_surface_create_similar (input, CAIRO_CONTENT_COLOR_ALPHA, width, height);
-    cairo_surface_set_device_scale( temp, 1, 1 );
 
     // color_interpolation_filter is determined by CSS value (see spec. Turbulence).
     if( _style ) {
         set_cairo_surface_ci(out, (SPColorInterpolation)_style->color_interpolation_filters.computed );
     }
 
-    if (!gen->ready()) {
-        Geom::Point ta(fTileX, fTileY);
-        Geom::Point tb(fTileX + fTileWidth, fTileY + fTileHeight);
-        gen->init(seed, Geom::Rect(ta, tb),
-            Geom::Point(XbaseFrequency, YbaseFrequency), stitchTiles,
-            type == TURBULENCE_FRACTALNOISE, numOctaves);
-    }
-
     Geom::Affine unit_trans = slot.get_units().get_matrix_primitiveunits2pb().inverse();
     Geom::Rect slot_area = slot.get_slot_area();
-    double x0 = slot_area.min()[Geom::X];
-    double y0 = slot_area.min()[Geom::Y];
-    ink_cairo_surface_synthesize(temp, Turbulence(*gen, unit_trans, x0, y0));
+    int x0 = slot_area.min()[Geom::X];
+    int y0 = slot_area.min()[Geom::Y];
+
+    cairo_surface_t *temp = nullptr;
+    {
+        // Tiles of the canvas may be rendered on several threads at once.
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!gen->ready()) {
+            Geom::Point ta(fTileX, fTileY);
+            Geom::Point tb(fTileX + fTileWidth, fTileY + fTileHeight);
+            gen->init(seed, Geom::Rect(ta, tb),
+                Geom::Point(XbaseFrequency, YbaseFrequency), stitchTiles,
+                type == TURBULENCE_FRACTALNOISE, numOctaves);
+            _clearCache();
+        }
+
+        for (auto it = _cache.begin(); it != _cache.end(); ++it) {
+            if (it->trans == unit_trans && it->x0 == x0 && it->y0 == y0 &&
+                it->width == width && it->height == height)
+            {
+                temp = cairo_surface_reference(it->surface);
+                _cache.splice(_cache.begin(), _cache, it);
+                break;
+            }
+        }
+    }
+
+    if (!temp) {
+        temp = cairo_surface_create_similar (input, CAIRO_CONTENT_COLOR_ALPHA, width, height);
+        cairo_surface_set_device_scale( temp, 1, 1 );
+        ink_cairo_surface_synthesize(temp, Turbulence(*gen, unit_trans, x0, y0));
+        _addToCache(unit_trans, x0, y0, width, height, temp);
+    }
 
     // cairo_surface_write_to_png( temp, "turbulence0.png" );
 
@@ -22,6 +22,10 @@
  * Released under GNU GPL v2+, read the file 'COPYING' for more information.
  */
 
+#include <cstddef>
+#include <list>
+#include <mutex>
+#include <2geom/affine.h>
 #include <2geom/point.h>
 
 #include "display/nr-filter-primitive.h"
@@ -78,6 +82,21 @@ private:
     double fTileX;
     double fTileY;
 
+    /// Noise already computed for an area of the slot, at the current parameters.
+    struct CachedTile {
+        Geom::Affine trans;
+        int x0, y0;
+        int width, height;
+        cairo_surface_t *surface;
+    };
+    static constexpr std::size_t CACHE_PIXELS = 1 << 22;
+    std::list<CachedTile> _cache; // most recently used first
+    std::size_t _cache_size = 0;  // in pixels
+    std::mutex _mutex;
+
+    void _addToCache(Geom::Affine const &trans, int x0, int y0, int width, int height,
+                     cairo_surface_t *surface);
+    void _clearCache();
 };
 
 } /* namespace Filters */
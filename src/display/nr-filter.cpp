@@ -14,9 +14,11 @@
 #include <cmath>
 #include <cstring>
 #include <string>
+#include <utility>
 #include <cairo.h>
 
 #include "display/nr-filter.h"
+#include "display/nr-filter-cache.h"
 #include "display/nr-filter-primitive.h"
 #include "display/nr-filter-slot.h"
 #include "display/nr-filter-types.h"
@@ -152,21 +154,51 @@ int Filter::render(Inkscape::DrawingItem const *item, DrawingContext &graphic, D
         }
     }
 
+    Geom::Point origin = graphic.targetLogicalBounds().min();
+    int const device_scale = graphic.surface()->device_scale();
+
+    // Reuse the result of an earlier rendering of the same area from the same source graphic.
+    // The source is copied before the primitives run, since they may convert it in place.
+    FilterCache &cache = item->drawing().filterCache();
+    cairo_surface_t *source = graphic.rawTarget();
+    cairo_surface_t *snapshot = nullptr;
+    FilterCache::Key key{item, _signature, trans, graphic.targetLogicalBounds().roundOutwards(),
+                         item->itemBounds(), device_scale, filterquality, blurquality};
+    if (!_signature.empty() && !uses_background()) {
+        if (cairo_surface_t *cached = cache.lookup(key, source)) {
+            graphic.setSource(cached, origin[Geom::X], origin[Geom::Y]);
+            graphic.setOperator(CAIRO_OPERATOR_SOURCE);
+            graphic.paint();
+            graphic.setOperator(CAIRO_OPERATOR_OVER);
+            cairo_surface_destroy(cached);
+            return 0;
+        }
+        snapshot = cache.snapshot(source);
+    }
+
     FilterSlot slot(const_cast<Inkscape::DrawingItem*>(item), bgdc, graphic, units);
     slot.set_quality(filterquality);
     slot.set_blurquality(blurquality);
-    slot.set_device_scale(graphic.surface()->device_scale());
+    slot.set_device_scale(device_scale);
 
     for (auto & i : _primitive) {
         i->render_cairo(slot);
     }
 
-    Geom::Point origin = graphic.targetLogicalBounds().min();
     cairo_surface_t *result = slot.get_result(_output_slot);
 
     // Assume for the moment that we paint the filter in sRGB
     set_cairo_surface_ci( result, SP_CSS_COLOR_INTERPOLATION_SRGB );
 
+    if (snapshot) {
+        if (result != source) {
+            cache.insert(std::move(key), snapshot, result);
+        } else {
+            // the filter passes the source graphic through, which is painted over below
+            cairo_surface_destroy(snapshot);
+        }
+    }
+
     graphic.setSource(result, origin[Geom::X], origin[Geom::Y]);
     graphic.setOperator(CAIRO_OPERATOR_SOURCE);
     graphic.paint();
@@ -184,6 +216,10 @@ void Filter::set_primitive_units(SPFilterUnits unit) {
     _primitive_units = unit;
 }
 
+void Filter::set_signature(std::string signature) {
+    _signature = std::move(signature);
+}
+
 void Filter::area_enlarge(Geom::IntRect &bbox, Inkscape::DrawingItem const *item) const {
     for (auto i : _primitive) {
         if (i) i->area_enlarge(bbox, item->ctm());
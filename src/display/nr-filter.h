@@ -15,6 +15,7 @@
 
 //#include "display/nr-arena-item.h"
 #include <cairo.h>
+#include <string>
 #include "display/nr-filter-primitive.h"
 #include "display/nr-filter-types.h"
 #include "svg/svg-length.h"
@@ -143,6 +144,14 @@ public:
      */
     void set_primitive_units(SPFilterUnits unit);
 
+    /**
+     * Sets a description of everything the filter was built from, i.e. its region, resolution,
+     * units and primitives. While it stays the same, results rendered from the same source graphic
+     * are reused (see FilterCache). An empty signature means that the filter also depends on
+     * something else, and its results are never reused.
+     */
+    void set_signature(std::string signature);
+
     /** 
      * Modifies the given area to accommodate for filters needing pixels
      * outside the rendered area.
@@ -198,6 +207,8 @@ private:
     SPFilterUnits _filter_units;
     SPFilterUnits _primitive_units;
 
+    std::string _signature;
+
     void _create_constructor_table();
     void _common_init();
     int _resolution_limit(FilterQuality const quality) const;
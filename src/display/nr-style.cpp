@@ -305,6 +305,9 @@ NRStyle::CairoPatternUniqPtr NRStyle::preparePaint(Inkscape::DrawingContext &dc,
             if (pattern) {
                 return CairoPatternUniqPtr(pattern->renderPattern(paint.opacity));
             } else {
+                // Paint servers live in the object tree, which must only be touched by one thread at a time.
+                static std::mutex server_mutex;
+                std::lock_guard<std::mutex> lock(server_mutex);
                 return CairoPatternUniqPtr(paint.server->pattern_new(dc.raw(), paintbox, paint.opacity));
             }
         case PAINT_COLOR: {
@@ -318,24 +321,28 @@ NRStyle::CairoPatternUniqPtr NRStyle::preparePaint(Inkscape::DrawingContext &dc,
 
 bool NRStyle::prepareFill(Inkscape::DrawingContext &dc, Geom::OptRect const &paintbox, Inkscape::DrawingPattern *pattern)
 {
+    std::lock_guard<std::mutex> lock(pattern_mutex);
     if (!fill_pattern) fill_pattern = preparePaint(dc, paintbox, pattern, fill);
     return (bool)fill_pattern;
 }
 
 bool NRStyle::prepareStroke(Inkscape::DrawingContext &dc, Geom::OptRect const &paintbox, Inkscape::DrawingPattern *pattern)
 {
+    std::lock_guard<std::mutex> lock(pattern_mutex);
     if (!stroke_pattern) stroke_pattern = preparePaint(dc, paintbox, pattern, stroke);
     return (bool)stroke_pattern;
 }
 
 bool NRStyle::prepareTextDecorationFill(Inkscape::DrawingContext &dc, Geom::OptRect const &paintbox, Inkscape::DrawingPattern *pattern)
 {
+    std::lock_guard<std::mutex> lock(pattern_mutex);
     if (!text_decoration_fill_pattern) text_decoration_fill_pattern = preparePaint(dc, paintbox, pattern, text_decoration_fill);
     return (bool)text_decoration_fill_pattern;
 }
 
 bool NRStyle::prepareTextDecorationStroke(Inkscape::DrawingContext &dc, Geom::OptRect const &paintbox, Inkscape::DrawingPattern *pattern)
 {
+    std::lock_guard<std::mutex> lock(pattern_mutex);
     if (!text_decoration_stroke_pattern) text_decoration_stroke_pattern = preparePaint(dc, paintbox, pattern, text_decoration_stroke);
     return (bool)text_decoration_stroke_pattern;
 }
@@ -15,6 +15,7 @@
 #define INKSCAPE_DISPLAY_NR_STYLE_H
 
 #include <memory>
+#include <mutex>
 #include <array>
 #include <cairo.h>
 #include <2geom/rect.h>
@@ -87,6 +88,9 @@ struct NRStyle
     CairoPatternUniqPtr text_decoration_fill_pattern;
     CairoPatternUniqPtr text_decoration_stroke_pattern;
 
+    /// Serialises the lazy creation of the patterns above when rendering on several threads.
+    std::mutex pattern_mutex;
+
     enum PaintOrderType
     {
         PAINT_ORDER_NORMAL,
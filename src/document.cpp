@@ -40,6 +40,7 @@
 #include <vector>
 #include <string>
 #include <cstring>
+#include <unordered_map>
 
 #include <2geom/transforms.h>
 
@@ -73,11 +74,14 @@
 #include "object/persp3d.h"
 #include "object/sp-defs.h"
 #include "object/sp-factory.h"
+#include "object/sp-object-pool.h"
 #include "object/sp-namedview.h"
 #include "object/sp-root.h"
 #include "object/sp-symbol.h"
 #include "object/sp-page.h"
 
+#include "util/rect-tree.h"
+
 #include "widgets/desktop-widget.h"
 
 #include "xml/croco-node-iface.h"
@@ -121,6 +125,7 @@ SPDocument::SPDocument() :
     current_persp3d_impl(nullptr),
     _parent_document(nullptr),
     _node_cache_valid(false),
+    _object_pool(new SPObjectPool()),
     _activexmltree(nullptr)
 {
     // This is kept here so that members are not accessed before they are initialized
@@ -228,6 +233,9 @@ SPDocument::~SPDocument() {
 
     // This is at the end of the destructor, because preceding code adds new orphans to the queue
     collectOrphans();
+
+    // Freed along with the last object, which may outlive the document
+    _object_pool->release();
 }
 
 Inkscape::XML::Node *SPDocument::getReprNamedView()
@@ -380,7 +388,11 @@ SPDocument *SPDocument::createDoc(Inkscape::XML::Document *rdoc,
 
     // Create SPRoot element
     const std::string typeString = NodeTraits::get_type_string(*rroot);
-    SPObject* rootObj = SPFactory::createObject(typeString);
+    SPObject *rootObj;
+    {
+        SPObjectPool::Scope scope(document->objectPool());
+        rootObj = SPFactory::createObject(typeString);
+    }
     document->root = dynamic_cast<SPRoot*>(rootObj);
 
     if (document->root == nullptr) {
@@ -1401,45 +1413,180 @@ static bool overlaps(Geom::Rect const &area, Geom::Rect const &box)
 }
 
 /**
- * @param area Area in document coordinates
+ * Spatial index of the document visual bounds of the items that can be found by area, which are
+ * the items whose ancestors below the root are all groups.
+ *
+ * The items are stored in post-order: descendants before their group and siblings in z-order,
+ * which is the order in which the area queries report them. The entries of a group's subtree thus
+ * form a contiguous range ending at the group itself.
  */
-static std::vector<SPItem*> &find_items_in_area(std::vector<SPItem*> &s,
-                                                SPGroup *group, unsigned int dkey,
-                                                Geom::Rect const &area,
-                                                bool (*test)(Geom::Rect const &, Geom::Rect const &),
-                                                bool take_hidden = false,
-                                                bool take_insensitive = false,
-                                                bool take_groups = true,
-                                                bool enter_groups = false)
+struct SPDocument::ItemIndex
 {
-    g_return_val_if_fail(SP_IS_GROUP(group), s);
+    Inkscape::Util::RectTree<SPItem *> tree;
+    std::unordered_map<SPObject const *, std::size_t> position; ///< Index of each item in the tree.
+    std::vector<std::size_t> subtree_begin;                     ///< First index of each item's subtree.
+    std::vector<std::size_t> dirty;                             ///< Changed items, each listed once.
+    std::vector<bool> stale;                                    ///< Whether each item is listed in dirty.
+    std::vector<bool> stale_subtree;                            ///< Whether each item's whole subtree is.
+    bool valid = false;
 
-    for (auto& o: group->children) {
-        if (SPItem *item = dynamic_cast<SPItem *>(&o)) {
-            if (!take_insensitive && item->isLocked()) {
-                continue;
+    void build(SPGroup *root)
+    {
+        std::vector<Inkscape::Util::RectTree<SPItem *>::Entry> entries;
+        position.clear();
+        subtree_begin.clear();
+        dirty.clear();
+        _add_children(root, entries);
+        stale.assign(entries.size(), false);
+        stale_subtree.assign(entries.size(), false);
+        tree.build(std::move(entries));
+        valid = true;
+    }
+
+    void mark(std::size_t i, bool subtree)
+    {
+        if (subtree) {
+            if (stale_subtree[i]) {
+                return;
             }
-
-            if (!take_hidden && item->isHidden()) {
-                continue;
+            stale_subtree[i] = true;
+            for (auto j = subtree_begin[i]; j < i; j++) {
+                _mark(j);
             }
+        }
+        _mark(i);
+    }
 
-            if (SPGroup * childgroup = dynamic_cast<SPGroup *>(item)) {
-                bool is_layer = childgroup->effectiveLayerMode(dkey) == SPGroup::LAYER;
-                if (is_layer || (enter_groups)) {
-                    s = find_items_in_area(s, childgroup, dkey, area, test, take_hidden, take_insensitive, take_groups, enter_groups);
-                }
-                if (!take_groups || is_layer) {
-                    continue;
+    void refresh()
+    {
+        for (auto i : dirty) {
+            tree.update(i, tree.value(i)->documentVisualBounds());
+            stale[i] = false;
+            stale_subtree[i] = false;
+        }
+        dirty.clear();
+    }
+
+private:
+    void _mark(std::size_t i)
+    {
+        if (!stale[i]) {
+            stale[i] = true;
+            dirty.push_back(i);
+        }
+    }
+
+    void _add_children(SPGroup *group, std::vector<Inkscape::Util::RectTree<SPItem *>::Entry> &entries)
+    {
+        for (auto &o : group->children) {
+            if (auto item = dynamic_cast<SPItem *>(&o)) {
+                auto const begin = entries.size();
+                if (auto childgroup = dynamic_cast<SPGroup *>(item)) {
+                    _add_children(childgroup, entries);
                 }
+                position[item] = entries.size();
+                subtree_begin.push_back(begin);
+                entries.emplace_back(item->documentVisualBounds(), item);
             }
-            Geom::OptRect box = item->documentVisualBounds();
-            if (box && test(area, *box)) {
-                s.push_back(item);
+        }
+    }
+};
+
+SPDocument::ItemIndex &SPDocument::_getItemIndex() const
+{
+    if (!_item_index) {
+        _item_index = std::make_unique<ItemIndex>();
+    }
+    // Changes that are still waiting for the document to be updated have not been reported to
+    // the index yet, so it can't be trusted until they are.
+    if (!_item_index->valid || root->uflags || root->mflags) {
+        _item_index->build(root);
+    } else {
+        _item_index->refresh();
+    }
+    return *_item_index;
+}
+
+void SPDocument::objectBoundsChanged(SPObject *object, bool subtree)
+{
+    if (!_item_index || !_item_index->valid) {
+        return;
+    }
+    auto it = _item_index->position.find(object);
+    if (it != _item_index->position.end()) {
+        _item_index->mark(it->second, subtree);
+    }
+}
+
+void SPDocument::objectChildrenChanged(SPObject *parent)
+{
+    if (!_item_index || !_item_index->valid) {
+        return;
+    }
+    if (parent == root || _item_index->position.count(parent)) {
+        _item_index->valid = false;
+    }
+}
+
+/**
+ * Find the items whose bounds pass test against area. Only layers are entered, or all groups if
+ * enter_groups is set, and hidden and locked items and their descendants are skipped unless asked
+ * otherwise. The result is in post-order: items in z-order, with groups after their children.
+ *
+ * @param area Area in document coordinates
+ */
+std::vector<SPItem*> SPDocument::_findItemsInArea(unsigned int dkey, Geom::Rect const &area,
+                                                  bool (*test)(Geom::Rect const &, Geom::Rect const &),
+                                                  bool take_hidden, bool take_insensitive,
+                                                  bool take_groups, bool enter_groups) const
+{
+    auto const &index = _getItemIndex();
+
+    auto accepted = [&] (SPItem const *item) {
+        return (take_insensitive || !item->isLocked()) && (take_hidden || !item->isHidden());
+    };
+
+    // Whether each group seen so far is entered. Candidates typically share most of their
+    // ancestors, so this avoids testing them over and over.
+    std::unordered_map<SPObject const *, bool> entered;
+    auto is_entered = [&] (SPObject *object) {
+        std::vector<SPObject *> chain;
+        bool result = true;
+        for (; object != root; object = object->parent) {
+            auto it = entered.find(object);
+            if (it != entered.end()) {
+                result = it->second;
+                break;
             }
+            chain.push_back(object);
+        }
+        for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+            if (result) {
+                auto group = static_cast<SPGroup *>(*it);
+                result = accepted(group) && (enter_groups || group->effectiveLayerMode(dkey) == SPGroup::LAYER);
+            }
+            entered[*it] = result;
+        }
+        return result;
+    };
+
+    std::vector<SPItem*> result;
+    for (auto i : index.tree.query(area)) {
+        SPItem *item = index.tree.value(i);
+        if (!accepted(item) || !is_entered(item->parent)) {
+            continue;
+        }
+        if (auto group = dynamic_cast<SPGroup *>(item)) {
+            if (!take_groups || group->effectiveLayerMode(dkey) == SPGroup::LAYER) {
+                continue;
+            }
+        }
+        auto const &box = index.tree.rect(i);
+        if (box && test(area, *box)) {
+            result.push_back(item);
         }
     }
-    return s;
+    return result;
 }
 
 SPItem *SPDocument::getItemFromListAtPointBottom(unsigned int dkey, SPGroup *group, std::vector<SPItem*> const &list,Geom::Point const &p, bool take_insensitive)
@@ -1595,8 +1742,7 @@ static SPItem *find_group_at_point(unsigned int dkey, SPGroup *group, Geom::Poin
 
 std::vector<SPItem*> SPDocument::getItemsInBox(unsigned int dkey, Geom::Rect const &box, bool take_hidden, bool take_insensitive, bool take_groups, bool enter_groups) const
 {
-    std::vector<SPItem*> x;
-    return find_items_in_area(x, this->root, dkey, box, is_within, take_hidden, take_insensitive, take_groups, enter_groups);
+    return _findItemsInArea(dkey, box, is_within, take_hidden, take_insensitive, take_groups, enter_groups);
 }
 
 /**
@@ -1612,8 +1758,7 @@ std::vector<SPItem*> SPDocument::getItemsInBox(unsigned int dkey, Geom::Rect con
 
 std::vector<SPItem*> SPDocument::getItemsPartiallyInBox(unsigned int dkey, Geom::Rect const &box, bool take_hidden, bool take_insensitive, bool take_groups, bool enter_groups) const
 {
-    std::vector<SPItem*> x;
-    return find_items_in_area(x, this->root, dkey, box, overlaps, take_hidden, take_insensitive, take_groups, enter_groups);
+    return _findItemsInArea(dkey, box, overlaps, take_hidden, take_insensitive, take_groups, enter_groups);
 }
 
 std::vector<SPItem*> SPDocument::getItemsAtPoints(unsigned const key, std::vector<Geom::Point> points, bool all_layers, bool topmost_only, size_t limit) const
@@ -96,6 +96,7 @@ class SPDefs;
 class Persp3D;
 class Persp3DImpl;
 class SPItemCtx;
+class SPObjectPool;
 
 namespace Proj {
     class TransfMat3x4;
@@ -119,6 +120,9 @@ public:
     SPDocument(SPDocument const &) = delete; // no copy
     void operator=(SPDocument const &) = delete; // no assign
 
+    /// Storage of the objects of the document; see SPObjectPool::Scope.
+    SPObjectPool *objectPool() const { return _object_pool; }
+
 
     // Document creation ------------------
     static SPDocument *createDoc(Inkscape::XML::Document *rdoc, char const *filename,
@@ -321,6 +325,18 @@ public:
     std::vector<SPItem*> getItemsAtPoints(unsigned const key, std::vector<Geom::Point> points, bool all_layers = true, bool topmost_only = true, size_t limit = 0) const;
     SPItem *getGroupAtPoint(unsigned int key,  Geom::Point const &p) const;
 
+    /**
+     * Tell the item index that the bounds of an object, and if subtree is true also those of its
+     * descendants, may have changed. Called by SPObject::emitModified().
+     */
+    void objectBoundsChanged(SPObject *object, bool subtree);
+
+    /**
+     * Tell the item index that children were added to, removed from or reordered in an object.
+     * Called by SPObject::attach(), detach() and reorder().
+     */
+    void objectChildrenChanged(SPObject *parent);
+
     /**
      * Returns the bottommost item from the list which is at the point, or NULL if none.
      */
@@ -413,6 +429,16 @@ private:
     mutable std::deque<SPItem*> _node_cache; // Used to speed up search.
     mutable bool _node_cache_valid;
 
+    SPObjectPool *_object_pool; // Storage of the objects, released at the end of the destructor.
+
+    struct ItemIndex;
+    mutable std::unique_ptr<ItemIndex> _item_index; // Spatial index of item bounds, built on demand.
+    ItemIndex &_getItemIndex() const;
+    std::vector<SPItem*> _findItemsInArea(unsigned int dkey, Geom::Rect const &area,
+                                          bool (*test)(Geom::Rect const &, Geom::Rect const &),
+                                          bool take_hidden, bool take_insensitive,
+                                          bool take_groups, bool enter_groups) const;
+
     // Box tool ----------------------------
     Persp3D *current_persp3d; /**< Currently 'active' perspective (to which, e.g., newly created boxes are attached) */
     Persp3DImpl *current_persp3d_impl;
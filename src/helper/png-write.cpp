@@ -14,11 +14,25 @@
  * Released under GNU GPL v2+, read the file 'COPYING' for more information.
  */
 
+#ifdef HAVE_CONFIG_H
+# include "config.h"  // only include where actually required!
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <future>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <utility>
 
 #include <2geom/rect.h>
 #include <2geom/transforms.h>
 
 #include <png.h>
+#if HAVE_OPENMP
+#include <omp.h>
+#endif
 
 #include "document.h"
 #include "inkscape.h"
@@ -54,8 +68,9 @@
 struct SPEBP {
     unsigned long int width, height, sheight;
     guint32 background;
-    Inkscape::Drawing *drawing; // it is assumed that all unneeded items are hidden
-    guchar *px;
+    Inkscape::Drawing *drawing; // it is assumed that all unneeded items are hidden and that it is up to date
+    Geom::IntPoint origin;      // drawing coordinates of the top left pixel
+    int threads;                // number of threads rendering each stripe
     unsigned (*status)(float, void *);
     void *data;
 };
@@ -67,6 +82,42 @@ struct SPPNGBD {
     int rowstride;
 };
 
+/**
+ * Rows returned by one call to get_rows.
+ */
+struct SPPNGStripe {
+    std::vector<png_bytep> rows;
+    void *to_free = nullptr;
+    int count = 0;
+};
+
+/**
+ * The stripe being written, and the next one being rendered meanwhile on another thread.
+ */
+struct SPPNGPipeline {
+    SPPNGStripe writing;
+    std::future<SPPNGStripe> rendering;
+
+    /// Waits for the stripe being rendered, and makes it the one to write.
+    void advance()
+    {
+        g_free(writing.to_free);
+        writing = rendering.get();
+    }
+
+    /// Waits for rendering to finish, and drops both stripes.
+    void clear()
+    {
+        if (rendering.valid()) {
+            advance();
+        }
+        g_free(writing.to_free);
+        writing = SPPNGStripe();
+    }
+
+    ~SPPNGPipeline() { clear(); }
+};
+
 /**
  * A simple wrapper to list png_text.
  */
@@ -123,8 +174,54 @@ void PngTextList::add(gchar const* key, gchar const* text)
     }
 }
 
+typedef std::vector<std::pair<std::string, std::string>> PngMetadata;
+
+/**
+ * The text chunks written to PNG files exported from the document.
+ */
+static PngMetadata sp_png_metadata(SPDocument *doc)
+{
+    PngMetadata metadata;
+
+    metadata.emplace_back("Software", "www.inkscape.org"); // Made by Inkscape comment
+    const gchar* pngToDc[] = {"Title", "title",
+                           "Author", "creator",
+                           "Description", "description",
+                           //"Copyright", "",
+                           "Creation Time", "date",
+                           //"Disclaimer", "",
+                           //"Warning", "",
+                           "Source", "source"
+                           //"Comment", ""
+    };
+    for (size_t i = 0; i < G_N_ELEMENTS(pngToDc); i += 2) {
+        struct rdf_work_entity_t * entity = rdf_find_entity ( pngToDc[i + 1] );
+        if (entity) {
+            gchar const* data = rdf_get_work_entity(doc, entity);
+            if (data && *data) {
+                metadata.emplace_back(pngToDc[i], data);
+            }
+        } else {
+            g_warning("Unable to find entity [%s]", pngToDc[i + 1]);
+        }
+    }
+
+
+    struct rdf_license_t *license =  rdf_get_license(doc);
+    if (license) {
+        if (license->name && license->uri) {
+            metadata.emplace_back("Copyright", std::string(license->name) + " " + license->uri);
+        } else if (license->name) {
+            metadata.emplace_back("Copyright", license->name);
+        } else if (license->uri) {
+            metadata.emplace_back("Copyright", license->uri);
+        }
+    }
+    return metadata;
+}
+
 static bool
-sp_png_write_rgba_striped(SPDocument *doc,
+sp_png_write_rgba_striped(PngMetadata const &metadata,
                           gchar const *filename, unsigned long int width, unsigned long int height, double xdpi, double ydpi,
                           int (* get_rows)(guchar const **rows, void **to_free, int row, int num_rows, void *data, int color_type, int bit_depth, int antialias),
                           void *data, bool interlace, int color_type, int bit_depth, int zlib, int antialiasing)
@@ -139,6 +236,9 @@ sp_png_write_rgba_striped(SPDocument *doc,
     png_color_8 sig_bit;
     png_uint_32 r;
 
+    // Allocated before setjmp(), so that it is cleaned up when libpng jumps back on an error.
+    auto const pipeline = std::make_unique<SPPNGPipeline>();
+
     /* open the file */
 
     Inkscape::IO::dump_fopen_call(filename, "M");
@@ -211,44 +311,8 @@ sp_png_write_rgba_striped(SPDocument *doc,
     }
 
     PngTextList textList;
-
-    textList.add("Software", "www.inkscape.org"); // Made by Inkscape comment
-    {
-        const gchar* pngToDc[] = {"Title", "title",
-                               "Author", "creator",
-                               "Description", "description",
-                               //"Copyright", "",
-                               "Creation Time", "date",
-                               //"Disclaimer", "",
-                               //"Warning", "",
-                               "Source", "source"
-                               //"Comment", ""
-        };
-        for (size_t i = 0; i < G_N_ELEMENTS(pngToDc); i += 2) {
-            struct rdf_work_entity_t * entity = rdf_find_entity ( pngToDc[i + 1] );
-            if (entity) {
-                gchar const* data = rdf_get_work_entity(doc, entity);
-                if (data && *data) {
-                    textList.add(pngToDc[i], data);
-                }
-            } else {
-                g_warning("Unable to find entity [%s]", pngToDc[i + 1]);
-            }
-        }
-
-
-        struct rdf_license_t *license =  rdf_get_license(doc);
-        if (license) {
-            if (license->name && license->uri) {
-                gchar* tmp = g_strdup_printf("%s %s", license->name, license->uri);
-                textList.add("Copyright", tmp);
-                g_free(tmp);
-            } else if (license->name) {
-                textList.add("Copyright", license->name);
-            } else if (license->uri) {
-                textList.add("Copyright", license->uri);
-            }
-        }
+    for (auto const &text : metadata) {
+        textList.add(text.first.c_str(), text.second.c_str());
     }
     if (textList.getCount() > 0) {
         png_set_text(png_ptr, info_ptr, textList.getPtext(), textList.getCount());
@@ -282,23 +346,36 @@ sp_png_write_rgba_striped(SPDocument *doc,
      * use the first method if you aren't handling interlacing yourself.
      */
 
-    png_bytep* row_pointers = new png_bytep[ebp->sheight];
+    // Each stripe is rendered on another thread while libpng compresses the previous one. The
+    // progress callback may run the main loop, which can change the drawing, so it is only called
+    // while no stripe is being rendered.
+    auto render_stripe = [=] (png_uint_32 row) {
+        SPPNGStripe rendered;
+        rendered.rows.resize(ebp->sheight);
+        rendered.count = get_rows((unsigned char const **) rendered.rows.data(), &rendered.to_free, row, height - row,
+                                  data, color_type, bit_depth, antialiasing);
+        return rendered;
+    };
+
     int number_of_passes = interlace ? png_set_interlace_handling(png_ptr) : 1;
 
     for(int i=0;i<number_of_passes; ++i){
         r = 0;
-        while (r < static_cast<png_uint_32>(height)) {
-            void *to_free;
-            int n = get_rows((unsigned char const **) row_pointers, &to_free, r, height-r, data, color_type, bit_depth, antialiasing);
+        pipeline->rendering = std::async(std::launch::async, render_stripe, r);
+        while (pipeline->rendering.valid()) {
+            pipeline->advance();
+            int const n = pipeline->writing.count;
             if (!n) break;
-            png_write_rows(png_ptr, row_pointers, n);
-            g_free(to_free);
+            if (ebp->status && !ebp->status((float) r / height, ebp->data)) break;
+            if (r + n < static_cast<png_uint_32>(height)) {
+                pipeline->rendering = std::async(std::launch::async, render_stripe, r + n);
+            }
+            png_write_rows(png_ptr, pipeline->writing.rows.data(), n);
             r += n;
         }
+        pipeline->clear();
     }
 
-    delete[] row_pointers;
-
     /* You can write optional chunks like tEXt, zTXt, and tIME at the end
      * as well.
      */
@@ -327,10 +404,6 @@ sp_export_get_rows(guchar const **rows, void **to_free, int row, int num_rows, v
 {
     struct SPEBP *ebp = (struct SPEBP *) data;
 
-    if (ebp->status) {
-        if (!ebp->status((float) row / ebp->height, ebp->data)) return 0;
-    }
-
     num_rows = MIN(num_rows, static_cast<int>(ebp->sheight));
     num_rows = MIN(num_rows, static_cast<int>(ebp->height - row));
 
@@ -338,25 +411,32 @@ sp_export_get_rows(guchar const **rows, void **to_free, int row, int num_rows, v
     // bbox is now set to the entire image to prevent discontinuities
     // in the image when blur is used (the borders may still be a bit
     // off, but that's less noticeable).
-    Geom::IntRect bbox = Geom::IntRect::from_xywh(0, row, ebp->width, num_rows);
-
-    /* Update to renderable state */
-    ebp->drawing->update(bbox);
+    Geom::IntRect bbox = Geom::IntRect::from_xywh(ebp->origin + Geom::IntPoint(0, row), ebp->width, num_rows);
 
     int stride = cairo_format_stride_for_width(CAIRO_FORMAT_ARGB32, ebp->width);
     unsigned char *px = g_new(guchar, num_rows * stride);
 
-    cairo_surface_t *s = cairo_image_surface_create_for_data(
-        px, CAIRO_FORMAT_ARGB32, ebp->width, num_rows, stride);
-    Inkscape::DrawingContext dc(s, bbox.min());
-    dc.setSource(ebp->background);
-    dc.setOperator(CAIRO_OPERATOR_SOURCE);
-    dc.paint();
-    dc.setOperator(CAIRO_OPERATOR_OVER);
-
-    /* Render */
-    ebp->drawing->render(dc, bbox, 0, antialiasing);
-    cairo_surface_destroy(s);
+    /* Render, in bands of rows spread over threads */
+    int const bands = std::min(num_rows, ebp->threads);
+#if HAVE_OPENMP
+    #pragma omp parallel for schedule(dynamic, 1) num_threads(bands)
+#endif
+    for (int i = 0; i < bands; ++i) {
+        int const y0 = num_rows * i / bands;
+        int const y1 = num_rows * (i + 1) / bands;
+        Geom::IntRect const band = Geom::IntRect::from_xywh(bbox.left(), bbox.top() + y0, ebp->width, y1 - y0);
+
+        cairo_surface_t *s = cairo_image_surface_create_for_data(
+            px + y0 * stride, CAIRO_FORMAT_ARGB32, ebp->width, y1 - y0, stride);
+        Inkscape::DrawingContext dc(s, band.min());
+        dc.setSource(ebp->background);
+        dc.setOperator(CAIRO_OPERATOR_SOURCE);
+        dc.paint();
+        dc.setOperator(CAIRO_OPERATOR_OVER);
+
+        ebp->drawing->render(dc, band, 0, antialiasing);
+        cairo_surface_destroy(s);
+    }
 
     // PNG stores data as unpremultiplied big-endian RGBA, which means
     // it's identical to the GdkPixbuf format.
@@ -371,22 +451,78 @@ sp_export_get_rows(guchar const **rows, void **to_free, int row, int num_rows, v
     return num_rows;
 }
 
+/**
+ * The number of rows to render at once, so that the two stripes in flight, both as rendered and
+ * as converted for libpng, fit in the memory limit.
+ */
+static unsigned long sp_export_stripe_height(unsigned long width, unsigned long height, int color_type, int bit_depth, std::size_t memory_limit)
+{
+    if (memory_limit == 0) {
+        memory_limit = 64 << 20;
+    }
+    int const n_fields = 1 + (color_type & 2) + (color_type & 4) / 4;
+    std::size_t const row_size = 4 * width + (n_fields * bit_depth * width + 7) / 8;
+    return std::clamp<std::size_t>(memory_limit / (2 * row_size), 1, height);
+}
+
+/**
+ * The transform from document to drawing coordinates for exporting an area at a size in pixels.
+ *
+ * Only the fraction of a pixel of the translation goes into the affine; the whole pixels are
+ * returned as the drawing coordinates of the top left pixel. Areas exported at the same scale and
+ * pixel alignment can thus be rendered from the same drawing.
+ */
+static std::pair<Geom::Affine, Geom::IntPoint> sp_export_transform(Geom::Rect const &area, unsigned long width, unsigned long height)
+{
+    /*  This calculation is only valid when assumed that (x0,y0)= area.corner(0) and (x1,y1) = area.corner(2)
+     * 1) a[0] * x0 + a[2] * y1 + a[4] = 0.0
+     * 2) a[1] * x0 + a[3] * y1 + a[5] = 0.0
+     * 3) a[0] * x1 + a[2] * y1 + a[4] = width
+     * 4) a[1] * x0 + a[3] * y0 + a[5] = height
+     * 5) a[1] = 0.0;
+     * 6) a[2] = 0.0;
+     *
+     * (1,3) a[0] * x1 - a[0] * x0 = width
+     * a[0] = width / (x1 - x0)
+     * (2,4) a[3] * y0 - a[3] * y1 = height
+     * a[3] = height / (y0 - y1)
+     * (1) a[4] = -a[0] * x0
+     * (2) a[5] = -a[3] * y1
+     */
+
+    Geom::Affine affine(Geom::Translate(-area.min())
+                      * Geom::Scale(width / area.width(),
+                                    height / area.height()));
+
+    double const x = std::floor(affine[4]);
+    double const y = std::floor(affine[5]);
+    affine[4] -= x;
+    affine[5] -= y;
+    return {affine, Geom::IntPoint(int(-x), int(-y))};
+}
+
 ExportResult sp_export_png_file(SPDocument *doc, gchar const *filename,
                                 double x0, double y0, double x1, double y1,
                                 unsigned long int width, unsigned long int height, double xdpi, double ydpi,
                                 unsigned long bgcolor,
                                 unsigned int (*status) (float, void *),
                                 void *data, bool force_overwrite,
-                                const std::vector<SPItem*> &items_only, bool interlace, int color_type, int bit_depth, int zlib, int antialiasing)
+                                const std::vector<SPItem*> &items_only, bool interlace, int color_type, int bit_depth, int zlib, int antialiasing,
+                                std::size_t memory_limit)
 {
     return sp_export_png_file(doc, filename, Geom::Rect(Geom::Point(x0,y0),Geom::Point(x1,y1)),
-                              width, height, xdpi, ydpi, bgcolor, status, data, force_overwrite, items_only, interlace, color_type, bit_depth, zlib, antialiasing);
+                              width, height, xdpi, ydpi, bgcolor, status, data, force_overwrite, items_only, interlace, color_type, bit_depth, zlib, antialiasing,
+                              memory_limit);
 }
 
 /**
  * Export an area to a PNG file
  *
+ * The drawing is brought up to date once; then each stripe of rows is rendered by several threads
+ * while libpng compresses the previous one.
+ *
  * @param area Area in document coordinates
+ * @param memory_limit Bytes of pixels that the stripes in flight may use; 0 for 64 MiB
  */
 ExportResult sp_export_png_file(SPDocument *doc, gchar const *filename,
                                 Geom::Rect const &area,
@@ -394,7 +530,8 @@ ExportResult sp_export_png_file(SPDocument *doc, gchar const *filename,
                                 unsigned long bgcolor,
                                 unsigned (*status)(float, void *),
                                 void *data, bool force_overwrite,
-                                const std::vector<SPItem*> &items_only, bool interlace, int color_type, int bit_depth, int zlib, int antialiasing)
+                                const std::vector<SPItem*> &items_only, bool interlace, int color_type, int bit_depth, int zlib, int antialiasing,
+                                std::size_t memory_limit)
 {
     g_return_val_if_fail(doc != nullptr, EXPORT_ERROR);
     g_return_val_if_fail(filename != nullptr, EXPORT_ERROR);
@@ -409,28 +546,7 @@ ExportResult sp_export_png_file(SPDocument *doc, gchar const *filename,
 
     doc->ensureUpToDate();
 
-    /* Calculate translation by transforming to document coordinates (flipping Y)*/
-    Geom::Point translation = -area.min();
-
-    /*  This calculation is only valid when assumed that (x0,y0)= area.corner(0) and (x1,y1) = area.corner(2)
-     * 1) a[0] * x0 + a[2] * y1 + a[4] = 0.0
-     * 2) a[1] * x0 + a[3] * y1 + a[5] = 0.0
-     * 3) a[0] * x1 + a[2] * y1 + a[4] = width
-     * 4) a[1] * x0 + a[3] * y0 + a[5] = height
-     * 5) a[1] = 0.0;
-     * 6) a[2] = 0.0;
-     *
-     * (1,3) a[0] * x1 - a[0] * x0 = width
-     * a[0] = width / (x1 - x0)
-     * (2,4) a[3] * y0 - a[3] * y1 = height
-     * a[3] = height / (y0 - y1)
-     * (1) a[4] = -a[0] * x0
-     * (2) a[5] = -a[3] * y1
-     */
-
-    Geom::Affine const affine(Geom::Translate(translation)
-                            * Geom::Scale(width / area.width(),
-                                        height / area.height()));
+    auto const transform = sp_export_transform(area, width, height);
 
     struct SPEBP ebp;
     ebp.width  = width;
@@ -444,8 +560,9 @@ ExportResult sp_export_png_file(SPDocument *doc, gchar const *filename,
 
     // Create ArenaItems and set transform
     drawing.setRoot(doc->getRoot()->invoke_show(drawing, dkey, SP_ITEM_SHOW_DISPLAY));
-    drawing.root()->setTransform(affine);
+    drawing.root()->setTransform(transform.first);
     ebp.drawing = &drawing;
+    ebp.origin = transform.second;
 
     // We show all and then hide all items we don't want, instead of showing only requested items,
     // because that would not work if the shown item references something in defs
@@ -453,18 +570,20 @@ ExportResult sp_export_png_file(SPDocument *doc, gchar const *filename,
         doc->getRoot()->invoke_hide_except(dkey, items_only);
     }
 
+    /* Update to renderable state, once for all stripes */
+    drawing.update();
+
     ebp.status = status;
     ebp.data   = data;
+    ebp.sheight = sp_export_stripe_height(width, height, color_type, bit_depth, memory_limit);
+#if HAVE_OPENMP
+    Inkscape::Preferences *prefs = Inkscape::Preferences::get();
+    ebp.threads = prefs->getIntLimited("/options/threading/numthreads", omp_get_num_procs(), 1, 256);
+#else
+    ebp.threads = 1;
+#endif
 
-    bool write_status = false;;
-
-    ebp.sheight = 64;
-    ebp.px = g_try_new(guchar, 4 * ebp.sheight * width);
-
-    if (ebp.px) {
-        write_status = sp_png_write_rgba_striped(doc, filename, width, height, xdpi, ydpi, sp_export_get_rows, &ebp, interlace, color_type, bit_depth, zlib, antialiasing);
-        g_free(ebp.px);
-    }
+    bool write_status = sp_png_write_rgba_striped(sp_png_metadata(doc), filename, width, height, xdpi, ydpi, sp_export_get_rows, &ebp, interlace, color_type, bit_depth, zlib, antialiasing);
 
     // Hide items, this releases arenaitem
     doc->getRoot()->invoke_hide(dkey);
@@ -472,6 +591,92 @@ ExportResult sp_export_png_file(SPDocument *doc, gchar const *filename,
     return write_status ? EXPORT_OK : EXPORT_ERROR;
 }
 
+std::vector<ExportResult> sp_export_png_files(SPDocument *doc, std::vector<PngExportJob> const &jobs,
+                                              unsigned long bgcolor, int num_threads,
+                                              bool interlace, int zlib, int antialiasing, std::size_t memory_limit)
+{
+    std::vector<ExportResult> results(jobs.size(), EXPORT_ERROR);
+    g_return_val_if_fail(doc != nullptr, results);
+
+    doc->ensureUpToDate();
+    PngMetadata const metadata = sp_png_metadata(doc);
+    num_threads = std::max(num_threads, 1);
+
+    // Order the jobs by transform, so that those sharing a drawing come together.
+    std::vector<std::pair<Geom::Affine, Geom::IntPoint>> transforms(jobs.size());
+    std::vector<std::size_t> order;
+    for (std::size_t i = 0; i < jobs.size(); ++i) {
+        auto const &job = jobs[i];
+        if (job.width < 1 || job.height < 1 || job.area.hasZeroArea()) {
+            g_warning("sp_export_png_files: Invalid area or size for %s", job.filename.c_str());
+            continue;
+        }
+        transforms[i] = sp_export_transform(job.area, job.width, job.height);
+        order.push_back(i);
+    }
+    auto const key = [&] (std::size_t i) {
+        auto const &a = transforms[i].first;
+        return std::make_tuple(a[0], a[1], a[2], a[3], a[4], a[5]);
+    };
+    std::stable_sort(order.begin(), order.end(), [&] (std::size_t a, std::size_t b) { return key(a) < key(b); });
+
+    // Work in batches, so that the drawings shown at once stay few even if no two jobs share one.
+    std::size_t const batch_size = 4 * num_threads;
+    for (std::size_t begin = 0; begin < order.size(); begin += batch_size) {
+        int const count = std::min(batch_size, order.size() - begin);
+
+        // Show and update the drawings on this thread, as the workers must not modify them.
+        std::vector<std::unique_ptr<Inkscape::Drawing>> drawings;
+        std::vector<unsigned> dkeys;
+        std::vector<Inkscape::Drawing *> job_drawings;
+        for (int i = 0; i < count; ++i) {
+            auto const &affine = transforms[order[begin + i]].first;
+            if (drawings.empty() || drawings.back()->root()->transform() != affine) {
+                auto drawing = std::make_unique<Inkscape::Drawing>();
+                drawing->setExact(true); // export with maximum blur rendering quality
+                unsigned const dkey = SPItem::display_key_new(1);
+                drawing->setRoot(doc->getRoot()->invoke_show(*drawing, dkey, SP_ITEM_SHOW_DISPLAY));
+                drawing->root()->setTransform(affine);
+                drawing->update();
+                drawings.push_back(std::move(drawing));
+                dkeys.push_back(dkey);
+            }
+            job_drawings.push_back(drawings.back().get());
+        }
+
+#if HAVE_OPENMP
+        #pragma omp parallel for schedule(dynamic, 1) num_threads(num_threads)
+#endif
+        for (int i = 0; i < count; ++i) {
+            std::size_t const index = order[begin + i];
+            auto const &job = jobs[index];
+
+            struct SPEBP ebp;
+            ebp.width  = job.width;
+            ebp.height = job.height;
+            ebp.sheight = sp_export_stripe_height(job.width, job.height, job.color_type, job.bit_depth, memory_limit);
+            ebp.background = bgcolor;
+            ebp.drawing = job_drawings[i];
+            ebp.origin = transforms[index].second;
+            ebp.threads = 1; // the jobs already keep the threads busy
+            ebp.status = nullptr;
+            ebp.data = nullptr;
+
+            bool const write_status = sp_png_write_rgba_striped(metadata, job.filename.c_str(), job.width, job.height,
+                                                                job.xdpi, job.ydpi, sp_export_get_rows, &ebp, interlace,
+                                                                job.color_type, job.bit_depth, zlib, antialiasing);
+            results[index] = write_status ? EXPORT_OK : EXPORT_ERROR;
+        }
+
+        // Hide items, this releases arenaitem
+        for (auto dkey : dkeys) {
+            doc->getRoot()->invoke_hide(dkey);
+        }
+    }
+
+    return results;
+}
+
 
 /*
   Local Variables:
@@ -16,9 +16,11 @@
  */
 
 #include <glib.h> // Only for gchar.
+#include <cstddef>
+#include <string>
 #include <vector>
 
-#include <2geom/forward.h>
+#include <2geom/rect.h>
 
 class SPDocument;
 class SPItem;
@@ -32,6 +34,9 @@ enum ExportResult {
 /**
  * Export the given document as a Portable Network Graphics (PNG) file.
  *
+ * Rows are rendered and written in stripes, whose height is chosen so that the pixels in flight
+ * stay within memory_limit bytes (64 MiB if 0), whatever the size of the image.
+ *
  * @return EXPORT_OK if succeeded, EXPORT_ABORTED if no action was taken, EXPORT_ERROR (false) if an error occurred.
  */
 ExportResult sp_export_png_file(SPDocument *doc, gchar const *filename,
@@ -39,13 +44,41 @@ ExportResult sp_export_png_file(SPDocument *doc, gchar const *filename,
 				unsigned long int width, unsigned long int height, double xdpi, double ydpi,
 				unsigned long bgcolor,
 				unsigned int (*status) (float, void *), void *data, bool force_overwrite = false, const std::vector<SPItem*> &items_only = std::vector<SPItem*>(), 
-                                bool interlace = false, int color_type = 6, int bit_depth = 8, int zlib = 6, int antialiasing = 2);
+                                bool interlace = false, int color_type = 6, int bit_depth = 8, int zlib = 6, int antialiasing = 2,
+                                std::size_t memory_limit = 0);
 
 ExportResult sp_export_png_file(SPDocument *doc, gchar const *filename,
 				Geom::Rect const &area,
 				unsigned long int width, unsigned long int height, double xdpi, double ydpi,
 				unsigned long bgcolor,
 				unsigned int (*status) (float, void *), void *data, bool force_overwrite = false, const std::vector<SPItem*> &items_only = std::vector<SPItem*>(), 
-                                bool interlace = false, int color_type = 6, int bit_depth = 8, int zlib = 6, int antialiasing = 2);
+                                bool interlace = false, int color_type = 6, int bit_depth = 8, int zlib = 6, int antialiasing = 2,
+                                std::size_t memory_limit = 0);
+
+/**
+ * An area of the document to be written to a PNG file by sp_export_png_files().
+ */
+struct PngExportJob {
+    std::string filename;
+    Geom::Rect area;
+    unsigned long int width, height;
+    double xdpi, ydpi;
+    int color_type = 6;
+    int bit_depth = 8;
+};
+
+/**
+ * Export several areas of the whole document to PNG files, overwriting existing files.
+ *
+ * The document is shown once for all areas exported at the same scale and pixel alignment, and the
+ * areas are rendered and encoded concurrently on up to num_threads threads, each within
+ * memory_limit as for sp_export_png_file().
+ *
+ * @return The result of each job, in the order of the jobs.
+ */
+std::vector<ExportResult> sp_export_png_files(SPDocument *doc, std::vector<PngExportJob> const &jobs,
+                                              unsigned long bgcolor, int num_threads,
+                                              bool interlace = false, int zlib = 6, int antialiasing = 2,
+                                              std::size_t memory_limit = 0);
 
 #endif // SEEN_SP_PNG_WRITE_H
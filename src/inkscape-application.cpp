@@ -63,6 +63,7 @@
 #include "desktop.h"                // Access to window
 #include "file.h"                   // sp_file_convert_dpi
 #include "inkscape.h"               // Inkscape::Application
+#include "message-stack.h"          // Progress of opening files
 #include "path-prefix.h"            // Data directory
 
 #include "include/glibmm_version.h"
@@ -76,6 +77,8 @@
 #include "io/resource.h"            // TEMPLATE
 #include "io/fix-broken-links.h"    // Fix up references.
 
+#include "xml/repr.h"               // Progress of opening files
+
 #include "object/sp-root.h"         // Inkscape version.
 
 #include "ui/interface.h"                 // sp_ui_error_dialog
@@ -177,9 +180,29 @@ InkscapeApplication::document_new(const std::string &Template)
 SPDocument*
 InkscapeApplication::document_open(const Glib::RefPtr<Gio::File>& file, bool *cancelled)
 {
+    // Show the progress of reading large files in the status bar of the active window. The main
+    // loop is not run meanwhile, so the window can not be closed and no other file can be opened;
+    // the message stack is held in case the desktop goes away anyway.
+    SPDesktop *desktop = _with_gui && _active_window ? _active_window->get_desktop() : nullptr;
+    auto stack = desktop ? desktop->messageStack() : nullptr;
+    auto message = std::make_shared<Inkscape::MessageId>(0);
+    std::function<void (double)> show_progress;
+    if (stack) {
+        show_progress = [stack, message, basename = file->get_basename()](double fraction) {
+            stack->cancel(*message);
+            *message = stack->pushF(Inkscape::NORMAL_MESSAGE, _("Loading %s: %d%%"), basename.c_str(),
+                                    static_cast<int>(fraction * 100));
+        };
+    }
+    Inkscape::XML::ReadProgress progress(std::move(show_progress));
+
     // Open file
     SPDocument *document = ink_file_open(file, cancelled);
 
+    if (*message) {
+        stack->cancel(*message);
+    }
+
     if (document) {
         document->setVirgin(false); // Prevents replacing document in same window during file open.
 
@@ -732,6 +755,8 @@ InkscapeApplication::InkscapeApplication()
     gapp->add_main_option_entry(T::OPTION_TYPE_STRING,   "export-background-opacity", 'y', N_("Background opacity for exported bitmaps (0.0 to 1.0, or 1 to 255)"), N_("VALUE")); // Bxx
     gapp->add_main_option_entry(T::OPTION_TYPE_STRING,   "export-png-color-mode", '\0', N_("Color mode (bit depth and color type) for exported bitmaps (Gray_1/Gray_2/Gray_4/Gray_8/Gray_16/RGB_8/RGB_16/GrayAlpha_8/GrayAlpha_16/RGBA_8/RGBA_16)"), N_("COLOR-MODE")); // Bxx
     gapp->add_main_option_entry(T::OPTION_TYPE_STRING,      "export-png-use-dithering", '\0', N_("Force dithering or disables it"), "false|true"); // Bxx
+    gapp->add_main_option_entry(T::OPTION_TYPE_INT,      "export-png-threads",    '\0', N_("Number of objects given by --export-id to render and write to PNG files at once; default is 1"), N_("THREADS")); // Bxx
+    gapp->add_main_option_entry(T::OPTION_TYPE_INT,      "export-png-memory-limit", '\0', N_("Memory in MiB for the pixels of each PNG file being rendered and written; default is 64"), N_("MEGABYTES")); // Bxx
 
     // Query - Geometry
     _start_main_option_section(_("Query object/document geometry"));
@@ -1643,6 +1668,18 @@ InkscapeApplication::on_handle_local_options(const Glib::RefPtr<Glib::VariantDic
         else std::cerr << "invalid value for export-png-use-dithering. Ignoring." << std::endl;
     } else _file_export.export_png_use_dithering = prefs->getBool("/options/dithering/value", true);
 
+    if (options->contains("export-png-threads")) {
+        options->lookup_value("export-png-threads", _file_export.export_png_threads);
+    }
+
+    if (options->contains("export-png-memory-limit")) {
+        options->lookup_value("export-png-memory-limit", _file_export.export_png_memory_limit);
+        if (_file_export.export_png_memory_limit < 1) {
+            std::cerr << "invalid value for export-png-memory-limit. Ignoring." << std::endl;
+            _file_export.export_png_memory_limit = 0;
+        }
+    }
+
 
     GVariantDict *options_copy = options->gobj_copy();
     GVariant *options_var = g_variant_dict_end(options_copy);
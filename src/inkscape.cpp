@@ -43,6 +43,7 @@
 #include "io/resource.h"
 #include "io/sys.h"
 
+#include "libnrtype/font-catalogue.h"
 #include "libnrtype/font-factory.h"
 
 #include "object/sp-item-group.h"
@@ -299,6 +300,7 @@ Application::~Application()
     }
 
     Inkscape::Preferences::unload();
+    Inkscape::Text::FontCatalogue::get().save();
 
     _S_inst = nullptr; // this will probably break things
 
@@ -834,6 +836,7 @@ Application::exit ()
     signal_shut_down.emit();
 
     Inkscape::Preferences::unload();
+    Inkscape::Text::FontCatalogue::get().save();
     //gtk_main_quit ();
 }
 
@@ -69,6 +69,8 @@ InkFileExportCmd::InkFileExportCmd()
     , export_id_only(false)
     , export_background_opacity(-1) // default is unset != actively set to 0
     , export_plain_svg(false)
+    , export_png_threads(1)
+    , export_png_memory_limit(0)
 {
 }
 
@@ -459,6 +461,11 @@ InkFileExportCmd::do_export_png(SPDocument *doc, std::string const &filename_in)
         objects.emplace_back(); // So we do loop at least once for root.
     }
 
+    // Objects exported with all others shown can share one rendering of the document, and be
+    // written concurrently once all of them are known.
+    bool const batch = export_png_threads > 1 && !export_id_only && objects.size() > 1;
+    std::vector<PngExportJob> jobs;
+
     for (auto object_id : objects) {
 
         std::string filename_out = get_filename_out(filename_in, Glib::filename_from_utf8(object_id));
@@ -693,15 +700,31 @@ InkFileExportCmd::do_export_png(SPDocument *doc, std::string const &filename_in)
 
         reverse(items.begin(),items.end()); // But there was only one item!
 
+        if (batch) {
+            jobs.push_back({filename_out, area, width, height, xdpi, ydpi, color_type, bit_depth});
+            continue;
+        }
+
         if( sp_export_png_file(doc, filename_out.c_str(), area, width, height, xdpi, ydpi,
                                bgcolor, nullptr, nullptr, true, export_id_only ? items : std::vector<SPItem*>(),
-                               false, color_type, bit_depth) == 1 ) {
+                               false, color_type, bit_depth, 6, 2, std::size_t(export_png_memory_limit) << 20) == 1 ) {
         } else {
             std::cerr << "InkFileExport::do_export_png: Failed to export to " << filename_out << std::endl;
             continue;
         }
 
     } // End loop over objects.
+
+    if (!jobs.empty()) {
+        auto const results = sp_export_png_files(doc, jobs, bgcolor, export_png_threads, false, 6, 2,
+                                                 std::size_t(export_png_memory_limit) << 20);
+        for (std::size_t i = 0; i < jobs.size(); ++i) {
+            if (results[i] != EXPORT_OK) {
+                std::cerr << "InkFileExport::do_export_png: Failed to export to " << jobs[i].filename << std::endl;
+            }
+        }
+    }
+
     prefs->setBool("/options/dithering/value", old_dither);
     return 0;
 }
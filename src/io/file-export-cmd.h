@@ -73,6 +73,8 @@ public:
     Glib::ustring export_png_color_mode;
     bool          export_plain_svg;
     bool          export_png_use_dithering;
+    int           export_png_threads;
+    int           export_png_memory_limit;
 };
 
 #endif // INK_FILE_EXPORT_CMD_H
@@ -10,12 +10,16 @@
  * Released under GNU GPL v2+, read the file 'COPYING' for more information.
  */
 
+#include <cstdint>
 #include <iomanip>
+#include <string_view>
+#include <type_traits>
 
 #include "Layout-TNG.h"
 #include "style.h"
 #include "font-instance.h"
 #include "font-factory.h"
+#include "shaping-cache.h"
 #include "svg/svg-length.h"
 #include "object/sp-object.h"
 #include "Layout-TNG-Scanline-Maker.h"
@@ -176,6 +180,7 @@ class Layout::Calculator
         std::vector<PangoItemInfo> pango_items;
         std::vector<PangoLogAttr> char_attributes;    ///< For every character in the paragraph.
         std::vector<UnbrokenSpan> unbroken_spans;
+        std::shared_ptr<ShapingCache::Paragraph> shaping; ///< Where Pango's results are kept for reuse, if anywhere.
 
         template<typename T> static void free_sequence(T &seq)
         {
@@ -191,6 +196,7 @@ class Layout::Calculator
             free_sequence(input_items);
             free_sequence(pango_items);
             free_sequence(unbroken_spans);
+            shaping.reset();
         }
     };
 
@@ -247,6 +253,13 @@ class Layout::Calculator
     bool _goToNextWrapShape();
     void _createFirstScanlineMaker();
 
+    std::string _flowInput() const;
+    std::string _paragraphInput(unsigned first_input_index, unsigned *end_input_index,
+                                std::vector<std::shared_ptr<FontInstance>> *fonts) const;
+    bool _describeParagraphs();
+    void _reuseParagraphs(Relayout const &previous, unsigned first, unsigned last);
+    void _resumeScanlineMaker(ParagraphRecord const &record);
+
     bool _findChunksForLine(ParagraphInfo const &para,
                             UnbrokenSpanPosition *start_span_pos,
                             std::vector<ChunkInfo> *chunk_info,
@@ -719,6 +732,7 @@ void Layout::Calculator::_outputLine(ParagraphInfo const &para,
             }
 
             Layout::Span new_span;
+            std::pair<int, unsigned> span_text(-1, 0);
 
             new_span.in_chunk = _flow._chunks.size() - 1;
             new_span.line_height = unbroken_span.line_height;
@@ -730,6 +744,8 @@ void Layout::Calculator::_outputLine(ParagraphInfo const &para,
                 new_span.font_size = unbroken_span.font_size;
                 new_span.direction = para.pango_items[unbroken_span.pango_item_index].item->analysis.level & 1 ? RIGHT_TO_LEFT : LEFT_TO_RIGHT;
                 new_span.input_stream_first_character = Glib::ustring::const_iterator(unbroken_span.input_stream_first_character.base() + it_span->start.char_byte);
+                span_text.first = unbroken_span.input_index;
+                span_text.second = new_span.input_stream_first_character.base() - static_cast<InputStreamTextSource const *>(_flow._input_stream[unbroken_span.input_index])->text_begin.base();
             } else {  // a control code
                 new_span.font = nullptr;
                 new_span.font_size = new_span.line_height.emSize();
@@ -1167,6 +1183,7 @@ void Layout::Calculator::_outputLine(ParagraphInfo const &para,
 
             new_span.x_end = new_span.x_start + x_in_span_last;
             _flow._spans.push_back(new_span);
+            _flow._relayout.span_text.push_back(span_text);
             previous_direction = new_span.direction;
         }
         // end adding spans to the list, on to the next chunk...
@@ -1314,13 +1331,54 @@ void Layout::Calculator::BrokenSpan::setZero()
 //    }
 //}
 
+namespace {
+
+/// Appends a field to a key of the shaping cache, prefixed by its length so that fields cannot run together.
+void append_shaping_key(std::string &key, std::string_view field)
+{
+    key += std::to_string(field.size());
+    key += ':';
+    key += field;
+}
+
+void append_shaping_key(std::string &key, std::uintmax_t value)
+{
+    append_shaping_key(key, std::to_string(value));
+}
+
+/// Appends the bytes of a value of fixed size to the input recorded for reusing the output.
+template <typename T>
+void append_input(std::string &input, T value)
+{
+    static_assert(std::is_trivially_copyable<T>::value, "only plain values can be recorded");
+    input.append(reinterpret_cast<char const *>(&value), sizeof(value));
+}
+
+void append_input(std::string &input, SVGLength const &length)
+{
+    append_input(input, length._set);
+    append_input(input, length.computed);
+}
+
+void append_input(std::string &input, std::vector<SVGLength> const &lengths)
+{
+    append_input(input, lengths.size());
+    for (auto const &length : lengths) {
+        append_input(input, length);
+    }
+}
+
+} // namespace
+
 /**
  * Take all the text from \a _para.first_input_index to the end of the
  * paragraph and stitch it together so that pango_itemize() can be called on
- * the whole thing.
+ * the whole thing. If the same text has been itemized with the same fonts,
+ * features, language, direction and gravity before, Pango's results are
+ * taken from the shaping cache instead.
  *
  * Input: para.first_input_index.
- * Output: para.direction, para.pango_items, para.char_attributes.
+ * Output: para.direction, para.pango_items, para.char_attributes, para.shaping.
  * Returns: the number of spans created by pango_itemize
  */
 void  Layout::Calculator::_buildPangoItemizationForPara(ParagraphInfo *para) const
@@ -1330,7 +1388,17 @@ void  Layout::Calculator::_buildPangoItemizationForPara(ParagraphInfo *para) con
 
     TRACE(("itemizing para, first input %d\n", para->first_input_index));
 
-    PangoAttrList *attributes_list = pango_attr_list_new();
+    // The attributes of each run of text, applied once we know that Pango has to be called.
+    struct Run {
+        unsigned start_index;
+        unsigned end_index;
+        std::shared_ptr<FontInstance> font;
+        std::string features;
+        Glib::ustring lang;
+    };
+    std::vector<Run> runs;
+    std::string key;
+
     for (unsigned input_index = para->first_input_index ; input_index < _flow._input_stream.size() ; input_index++) {
         if (_flow._input_stream[input_index]->Type() == CONTROL_CODE) {
             Layout::InputStreamControlCode const *control_code = static_cast<Layout::InputStreamControlCode const *>(_flow._input_stream[input_index]);
@@ -1348,41 +1416,81 @@ void  Layout::Calculator::_buildPangoItemizationForPara(ParagraphInfo *para) con
                 continue;  // bad news: we'll have to ignore all this text because we know of no font to render it
             }
 
-            PangoAttribute *attribute_font_description = pango_attr_font_desc_new(font->get_descr());
-            attribute_font_description->start_index = para->text.bytes();
-
-            PangoAttribute *attribute_font_features =
-                pango_attr_font_features_new( text_source->style->getFontFeatureString().c_str());
-            attribute_font_features->start_index = para->text.bytes();
+            Run run;
+            run.start_index = para->text.bytes();
             para->text.append(&*text_source->text_begin.base(), text_source->text_length);     // build the combined text
-
-            attribute_font_description->end_index = para->text.bytes();
-            pango_attr_list_insert(attributes_list, attribute_font_description);
-
-            attribute_font_features->end_index = para->text.bytes();
-            pango_attr_list_insert(attributes_list, attribute_font_features);
-
-            // Set language
-            SPObject * object = text_source->source;
-            if (!object->lang.empty()) {
-                PangoLanguage* language = pango_language_from_string(object->lang.c_str());
-                PangoAttribute *attribute_language = pango_attr_language_new( language );
-                pango_attr_list_insert(attributes_list, attribute_language);
-            }
+            run.end_index = para->text.bytes();
+            run.font = std::move(font);
+            run.features = text_source->style->getFontFeatureString();
+            run.lang = text_source->source->lang;
+
+            // Fonts are identified by address, which is unique while the cached paragraph holds them.
+            append_shaping_key(key, run.start_index);
+            append_shaping_key(key, run.end_index);
+            append_shaping_key(key, reinterpret_cast<std::uintptr_t>(run.font.get()));
+            append_shaping_key(key, run.features);
+            append_shaping_key(key, run.lang.raw());
+            runs.push_back(std::move(run));
         }
     }
 
     TRACE(("whole para: \"%s\"\n", para->text.data()));
 //    TRACE(("%d input sources used\n", input_index - para->first_input_index));
 
-    // Pango Itemize
-    GList *pango_items_glist = nullptr;
     para->direction = LEFT_TO_RIGHT; // CSS default
+    bool has_base_dir = false;
+    PangoDirection pango_direction = PANGO_DIRECTION_LTR;
     if (_flow._input_stream[para->first_input_index]->Type() == TEXT_SOURCE) {
         Layout::InputStreamTextSource const *text_source = static_cast<Layout::InputStreamTextSource *>(_flow._input_stream[para->first_input_index]);
 
         para->direction =                (text_source->style->direction.computed == SP_CSS_DIRECTION_LTR) ? LEFT_TO_RIGHT : RIGHT_TO_LEFT;
-        PangoDirection pango_direction = (text_source->style->direction.computed == SP_CSS_DIRECTION_LTR) ? PANGO_DIRECTION_LTR : PANGO_DIRECTION_RTL;
+        pango_direction = (text_source->style->direction.computed == SP_CSS_DIRECTION_LTR) ? PANGO_DIRECTION_LTR : PANGO_DIRECTION_RTL;
+        has_base_dir = true;
+    }
+
+    append_shaping_key(key, para->text.raw());
+    append_shaping_key(key, has_base_dir ? pango_direction + 1 : 0);
+    append_shaping_key(key, pango_context_get_base_gravity(_pango_context));
+    append_shaping_key(key, pango_context_get_gravity_hint(_pango_context));
+
+    auto &cache = ShapingCache::get();
+    para->shaping = cache.lookup(key);
+    if (para->shaping) {
+        TRACE(("para found in shaping cache\n"));
+        para->pango_items.reserve(para->shaping->items.size());
+        for (unsigned i = 0; i < para->shaping->items.size(); i++) {
+            PangoItemInfo new_item;
+            new_item.item = pango_item_copy(para->shaping->items[i]);
+            new_item.font = para->shaping->fonts[i];
+            para->pango_items.push_back(new_item);
+        }
+        para->char_attributes = para->shaping->char_attributes;
+        return;
+    }
+
+    PangoAttrList *attributes_list = pango_attr_list_new();
+    for (auto const &run : runs) {
+        PangoAttribute *attribute_font_description = pango_attr_font_desc_new(run.font->get_descr());
+        attribute_font_description->start_index = run.start_index;
+        attribute_font_description->end_index = run.end_index;
+        pango_attr_list_insert(attributes_list, attribute_font_description);
+
+        PangoAttribute *attribute_font_features = pango_attr_font_features_new(run.features.c_str());
+        attribute_font_features->start_index = run.start_index;
+        attribute_font_features->end_index = run.end_index;
+        pango_attr_list_insert(attributes_list, attribute_font_features);
+
+        // Set language
+        if (!run.lang.empty()) {
+            PangoLanguage* language = pango_language_from_string(run.lang.c_str());
+            PangoAttribute *attribute_language = pango_attr_language_new( language );
+            pango_attr_list_insert(attributes_list, attribute_language);
+        }
+    }
+
+    // Pango Itemize
+    GList *pango_items_glist = nullptr;
+    if (has_base_dir) {
         pango_items_glist = pango_itemize_with_base_dir(_pango_context, pango_direction, para->text.data(), 0, para->text.bytes(), attributes_list, nullptr);
     }
 
@@ -1414,6 +1522,18 @@ void  Layout::Calculator::_buildPangoItemizationForPara(ParagraphInfo *para) con
     // This breaks Inkscape's multiline text (i.e. sodipodi:role line).
     para->char_attributes[para->text.length()].is_mandatory_break = 0;
 
+    // Keep the results for the next time the paragraph is laid out
+    para->shaping = std::make_shared<ShapingCache::Paragraph>();
+    for (auto const &item : para->pango_items) {
+        para->shaping->items.push_back(pango_item_copy(item.item));
+        para->shaping->fonts.push_back(item.font);
+    }
+    para->shaping->char_attributes = para->char_attributes;
+    for (auto &run : runs) {
+        para->shaping->key_fonts.push_back(std::move(run.font));
+    }
+    cache.insert(std::move(key), para->shaping);
+
     TRACE(("end para itemize, direction = %d\n", para->direction));
 }
 
@@ -1581,7 +1701,6 @@ unsigned Layout::Calculator::_buildSpansForPara(ParagraphInfo *para) const
                 // now we know the length, do some final calculations and add the UnbrokenSpan to the list
                 new_span.font_size = text_source->style->font_size.computed * _flow.getTextLengthMultiplierDue();
                 if (new_span.text_bytes) {
-                    new_span.glyph_string = pango_glyph_string_new();
                     /* Some assertions intended to help diagnose bug #1277746. */
                     g_assert( 0 < new_span.text_bytes );
                     g_assert( span_start_byte_in_source < text_source->text->bytes() );
@@ -1602,54 +1721,67 @@ unsigned Layout::Calculator::_buildSpansForPara(ParagraphInfo *para) const
                     auto gnew = std::string_view(para->text.data()         + para_text_index,           new_span.text_bytes);
                     assert (gold == gnew);
 
-                    // Convert characters to glyphs
-                    pango_shape_full(para->text.data() + para_text_index,
-                                     new_span.text_bytes,
-                                     para->text.data(),
-                                     -1,
-                                     &para->pango_items[pango_item_index].item->analysis,
-                                     new_span.glyph_string);
-
-                    if (para->pango_items[pango_item_index].item->analysis.level & 1) {
-                        // Right to left text (Arabic, Hebrew, etc.)
-
-                        // pango_shape() will reorder glyphs in rtl sections into visual order
-                        // (start offsets in accending order) which messes us up because the svg
-                        // spec requires us to draw glyphs in logical order so let's reverse the
-                        // glyphstring.
-
-                        const unsigned nglyphs = new_span.glyph_string->num_glyphs;
-                        std::vector<PangoGlyphInfo> infos(nglyphs);
-                        std::vector<gint>           clusters(nglyphs);
-
-                        for (int i = 0; i < nglyphs; ++i) {
-                            std::copy(&new_span.glyph_string->glyphs[i],       &new_span.glyph_string->glyphs[i+1],       infos.end() - i - 1);
-                            std::copy(&new_span.glyph_string->log_clusters[i], &new_span.glyph_string->log_clusters[i+1], clusters.end() - i - 1);
-                        }
+                    // Reuse the glyphs from the last layout of the paragraph, if it was shaped the same
+                    auto &cache = ShapingCache::get();
+                    if (para->shaping) {
+                        new_span.glyph_string = cache.glyphs(*para->shaping, para_text_index, new_span.text_bytes, pango_item_index);
+                    }
+                    if (!new_span.glyph_string) {
+                        new_span.glyph_string = pango_glyph_string_new();
+
+                        // Convert characters to glyphs
+                        pango_shape_full(para->text.data() + para_text_index,
+                                         new_span.text_bytes,
+                                         para->text.data(),
+                                         -1,
+                                         &para->pango_items[pango_item_index].item->analysis,
+                                         new_span.glyph_string);
+
+                        if (para->pango_items[pango_item_index].item->analysis.level & 1) {
+                            // Right to left text (Arabic, Hebrew, etc.)
+
+                            // pango_shape() will reorder glyphs in rtl sections into visual order
+                            // (start offsets in accending order) which messes us up because the svg
+                            // spec requires us to draw glyphs in logical order so let's reverse the
+                            // glyphstring.
+
+                            const unsigned nglyphs = new_span.glyph_string->num_glyphs;
+                            std::vector<PangoGlyphInfo> infos(nglyphs);
+                            std::vector<gint>           clusters(nglyphs);
+
+                            for (int i = 0; i < nglyphs; ++i) {
+                                std::copy(&new_span.glyph_string->glyphs[i],       &new_span.glyph_string->glyphs[i+1],       infos.end() - i - 1);
+                                std::copy(&new_span.glyph_string->log_clusters[i], &new_span.glyph_string->log_clusters[i+1], clusters.end() - i - 1);
+                            }
 
-                        std::copy(infos.begin(), infos.end(), new_span.glyph_string->glyphs);
-                        std::copy(clusters.begin(), clusters.end(), new_span.glyph_string->log_clusters);
+                            std::copy(infos.begin(), infos.end(), new_span.glyph_string->glyphs);
+                            std::copy(clusters.begin(), clusters.end(), new_span.glyph_string->log_clusters);
 
-                        // We've messed up the flag that tells a glyph it is first in a cluster.
-                        for (int i = 0; i < nglyphs; ++i) {
+                            // We've messed up the flag that tells a glyph it is first in a cluster.
+                            for (int i = 0; i < nglyphs; ++i) {
 
-                            // Set flag for start of cluster, we skip all other glyphs in cluster below.
-                            new_span.glyph_string->glyphs[i].attr.is_cluster_start = 1;
+                                // Set flag for start of cluster, we skip all other glyphs in cluster below.
+                                new_span.glyph_string->glyphs[i].attr.is_cluster_start = 1;
 
-                            // Find index of first glyph in next cluster
-                            int j = i + 1;
-                            while( (j < nglyphs) &&
-                                   (new_span.glyph_string->log_clusters[j] == new_span.glyph_string->log_clusters[i])
-                                ) {
-                                new_span.glyph_string->glyphs[j].attr.is_cluster_start = 0; // Zero
-                                j++;
+                                // Find index of first glyph in next cluster
+                                int j = i + 1;
+                                while( (j < nglyphs) &&
+                                       (new_span.glyph_string->log_clusters[j] == new_span.glyph_string->log_clusters[i])
+                                    ) {
+                                    new_span.glyph_string->glyphs[j].attr.is_cluster_start = 0; // Zero
+                                    j++;
+                                }
+
+                                // Move on to next cluster.
+                                i = j;
                             }
 
-                            // Move on to next cluster.
-                            i = j;
-                        }
+                        } // End right to left text.
 
-                    } // End right to left text.
+                        if (para->shaping) {
+                            cache.addGlyphs(*para->shaping, para_text_index, new_span.text_bytes, pango_item_index, new_span.glyph_string);
+                        }
+                    }
 
                     //  The following sorting doesn't seem to be necessary, and causes
                     //  https://gitlab.com/inkscape/inkscape/-/issues/394 ...
@@ -1802,6 +1934,246 @@ bool Layout::Calculator::_goToNextWrapShape()
     // Shouldn't reach
 }
 
+/**
+ * Describes the input that affects the layout of every paragraph: the wrap shapes, the strut and
+ * the direction of the text as a whole.
+ */
+std::string Layout::Calculator::_flowInput() const
+{
+    std::string input;
+    append_input(input, _flow.wrap_mode);
+    append_input(input, _block_progression);
+    append_input(input, _flow._blockTextOrientation());
+    append_input(input, _font_factory_size_multiplier);
+    append_input(input, _flow.getTextLengthMultiplierDue());
+    append_input(input, _flow.getTextLengthIncrementDue());
+    append_input(input, _flow.lengthAdjust);
+    for (double metric : {_flow.strut.ascent, _flow.strut.descent, _flow.strut.xheight, _flow.strut.ascent_max, _flow.strut.descent_max}) {
+        append_input(input, metric);
+    }
+
+    // The shapes are rebuilt by the owner with each change, so their geometry is compared.
+    append_input(input, _flow._input_wrap_shapes.size());
+    for (auto const &wrap_shape : _flow._input_wrap_shapes) {
+        Shape const *shape = wrap_shape.shape;
+        append_input(input, wrap_shape.display_align);
+        append_input(input, shape->numberOfPoints());
+        for (int i = 0; i < shape->numberOfPoints(); i++) {
+            append_input(input, shape->getPoint(i).x[Geom::X]);
+            append_input(input, shape->getPoint(i).x[Geom::Y]);
+        }
+        append_input(input, shape->numberOfEdges());
+        for (int i = 0; i < shape->numberOfEdges(); i++) {
+            append_input(input, shape->getEdge(i).st);
+            append_input(input, shape->getEdge(i).en);
+        }
+    }
+    return input;
+}
+
+/**
+ * Describes everything in the input stream items of the paragraph starting at
+ * \a first_input_index that its layout depends on, apart from where it starts. Sets
+ * \a end_input_index to the index of the break at its end, or the size of the input stream. Fonts
+ * are described by address, so they are added to \a fonts to keep them alive.
+ */
+std::string Layout::Calculator::_paragraphInput(unsigned first_input_index, unsigned *end_input_index,
+                                                std::vector<std::shared_ptr<FontInstance>> *fonts) const
+{
+    std::string input;
+    unsigned input_index;
+    for (input_index = first_input_index ; input_index < _flow._input_stream.size() ; input_index++) {
+        if (_flow._input_stream[input_index]->Type() == CONTROL_CODE) {
+            auto control_code = static_cast<InputStreamControlCode const *>(_flow._input_stream[input_index]);
+            append_input(input, CONTROL_CODE);
+            append_input(input, control_code->code);
+            append_input(input, control_code->width);
+            append_input(input, control_code->ascent);
+            append_input(input, control_code->descent);
+            // breaks take the height of blank lines from the style of their source
+            SPStyle const *style = control_code->source ? control_code->source->style : nullptr;
+            if (style) {
+                auto font = FontFactory::get().FaceFromStyle(style);
+                append_input(input, reinterpret_cast<std::uintptr_t>(font.get()));
+                append_input(input, style->font_size.computed);
+                append_input(input, style->line_height.normal);
+                append_input(input, int(style->line_height.unit));
+                append_input(input, style->line_height.computed);
+                fonts->push_back(std::move(font));
+            }
+            if (control_code->code == SHAPE_BREAK || control_code->code == PARAGRAPH_BREAK) {
+                break;
+            }
+        } else {
+            auto text_source = static_cast<InputStreamTextSource const *>(_flow._input_stream[input_index]);
+            SPStyle *style = text_source->style;
+            auto font = text_source->styleGetFontInstance();
+            append_input(input, TEXT_SOURCE);
+            append_input(input, text_source->text_end.base() - text_source->text_begin.base());
+            input.append(text_source->text_begin.base(), text_source->text_end.base());
+            append_input(input, text_source->x);
+            append_input(input, text_source->y);
+            append_input(input, text_source->dx);
+            append_input(input, text_source->dy);
+            append_input(input, text_source->rotate);
+            append_input(input, text_source->textLength);
+            append_input(input, text_source->lengthAdjust);
+            append_input(input, reinterpret_cast<std::uintptr_t>(font.get()));
+            std::string const features = style->getFontFeatureString();
+            append_input(input, features.size());
+            input += features;
+            Glib::ustring const &lang = text_source->source->lang;
+            append_input(input, lang.bytes());
+            input += lang.raw();
+            append_input(input, style->font_size.computed);
+            append_input(input, style->letter_spacing.computed);
+            append_input(input, style->word_spacing.computed);
+            append_input(input, style->line_height.normal);
+            append_input(input, int(style->line_height.unit));
+            append_input(input, style->line_height.computed);
+            append_input(input, style->baseline_shift.computed);
+            append_input(input, int(style->direction.computed));
+            append_input(input, int(style->writing_mode.computed));
+            append_input(input, int(style->text_orientation.computed));
+            append_input(input, int(style->dominant_baseline.computed));
+            append_input(input, style->text_align.set);
+            append_input(input, int(style->text_align.computed));
+            append_input(input, style->text_anchor.set);
+            append_input(input, int(style->text_anchor.computed));
+            fonts->push_back(std::move(font));
+        }
+    }
+    *end_input_index = input_index;
+    // The last paragraph ends differently from the others.
+    append_input(input, input_index + 1 >= _flow._input_stream.size());
+    return input;
+}
+
+/**
+ * Starts the records of the calculation with the input of each paragraph, in the order in which
+ * calculate() lays them out. Returns false if the input cannot be divided into paragraphs
+ * independently of the layout.
+ */
+bool Layout::Calculator::_describeParagraphs()
+{
+    Relayout &relayout = _flow._relayout;
+    relayout.flow = _flowInput();
+    unsigned first_input_index = 0;
+    while (first_input_index < _flow._input_stream.size()) {
+        auto first_item = _flow._input_stream[first_input_index];
+        if (first_item->Type() == CONTROL_CODE && static_cast<InputStreamControlCode const *>(first_item)->code == SHAPE_BREAK) {
+            return false;
+        }
+        unsigned end_input_index;
+        relayout.records.emplace_back();
+        relayout.records.back().input = _paragraphInput(first_input_index, &end_input_index, &relayout.fonts);
+        relayout.records.back().first_input_index = first_input_index;
+        first_input_index = end_input_index + 1;
+    }
+    relayout.records.emplace_back();  // for the end of the output
+    relayout.records.back().first_input_index = _flow._input_stream.size();
+    return true;
+}
+
+/**
+ * Appends the output of paragraphs \a first to \a last (exclusive) of the previous calculation,
+ * and their records, to those of this one. Their input must be unchanged, and they must start
+ * where they did before.
+ */
+void Layout::Calculator::_reuseParagraphs(Relayout const &previous, unsigned first, unsigned last)
+{
+    Relayout &relayout = _flow._relayout;
+    unsigned const index = _flow._paragraphs.size();
+    ParagraphRecord const &from = previous.records[first];
+    ParagraphRecord const &to = previous.records[last];
+
+    // The output refers to itself and to the input by index, which moves with the changes before it.
+    int const paragraph_shift = int(index) - int(first);
+    int const line_shift = int(_flow._lines.size()) - int(from.lines);
+    int const chunk_shift = int(_flow._chunks.size()) - int(from.chunks);
+    int const span_shift = int(_flow._spans.size()) - int(from.spans);
+    int const character_shift = int(_flow._characters.size()) - int(from.characters);
+    int const glyph_shift = int(_flow._glyphs.size()) - int(from.glyphs);
+    int const input_shift = int(relayout.records[index].first_input_index) - int(from.first_input_index);
+
+    for (unsigned i = first ; i <= last ; i++) {
+        ParagraphRecord const &previous_record = previous.records[i];
+        ParagraphRecord &paragraph_record = relayout.records[index + i - first];
+        paragraph_record.lines = previous_record.lines + line_shift;
+        paragraph_record.chunks = previous_record.chunks + chunk_shift;
+        paragraph_record.spans = previous_record.spans + span_shift;
+        paragraph_record.characters = previous_record.characters + character_shift;
+        paragraph_record.glyphs = previous_record.glyphs + glyph_shift;
+        paragraph_record.y = previous_record.y;
+        paragraph_record.shape_index = previous_record.shape_index;
+        paragraph_record.y_offset = previous_record.y_offset;
+        paragraph_record.flowed = previous_record.flowed;
+        paragraph_record.empty = previous_record.empty;
+    }
+
+    _flow._paragraphs.insert(_flow._paragraphs.end(), previous.paragraphs.begin() + first, previous.paragraphs.begin() + last);
+    for (unsigned i = from.lines ; i < to.lines ; i++) {
+        _flow._lines.push_back(previous.lines[i]);
+        _flow._lines.back().in_paragraph += paragraph_shift;
+    }
+    for (unsigned i = from.chunks ; i < to.chunks ; i++) {
+        _flow._chunks.push_back(previous.chunks[i]);
+        _flow._chunks.back().in_line += line_shift;
+    }
+    for (unsigned i = from.spans ; i < to.spans ; i++) {
+        _flow._spans.push_back(previous.spans[i]);
+        Layout::Span &span = _flow._spans.back();
+        span.in_chunk += chunk_shift;
+        span.in_input_stream_item += input_shift;
+        // the text itself may have been reallocated by its owner
+        std::pair<int, unsigned> span_text = previous.span_text[i];
+        if (span_text.first < 0) {
+            span.input_stream_first_character = Glib::ustring::const_iterator();
+        } else {
+            span_text.first += input_shift;
+            auto text_source = static_cast<InputStreamTextSource const *>(_flow._input_stream[span_text.first]);
+            span.input_stream_first_character = Glib::ustring::const_iterator(text_source->text_begin.base() + span_text.second);
+        }
+        relayout.span_text.push_back(span_text);
+    }
+    for (unsigned i = from.characters ; i < to.characters ; i++) {
+        _flow._characters.push_back(previous.characters[i]);
+        Layout::Character &character = _flow._characters.back();
+        character.in_span += span_shift;
+        if (character.in_glyph != -1) {
+            character.in_glyph += glyph_shift;
+        }
+    }
+    for (unsigned i = from.glyphs ; i < to.glyphs ; i++) {
+        _flow._glyphs.push_back(previous.glyphs[i]);
+        _flow._glyphs.back().in_character += character_shift;
+    }
+}
+
+/**
+ * Replaces the scanline maker with one that continues from where the previous calculation was at
+ * the start of a paragraph.
+ */
+void Layout::Calculator::_resumeScanlineMaker(ParagraphRecord const &record)
+{
+    delete _scanline_maker;
+    _scanline_maker = nullptr;
+
+    if (_flow._input_wrap_shapes.empty()) {
+        _createFirstScanlineMaker();
+    } else if (record.shape_index < _flow._input_wrap_shapes.size()) {
+        _current_shape_index = record.shape_index;
+        _scanline_maker = new ShapeScanlineMaker(_flow._input_wrap_shapes[_current_shape_index].shape, _block_progression);
+    } else {
+        // the overflow, see _goToNextWrapShape()
+        _current_shape_index = record.shape_index;
+        Shape const *shape = _flow._input_wrap_shapes.back().shape;
+        _scanline_maker = new InfiniteScanlineMaker(shape->leftX, shape->bottomY, _block_progression);
+    }
+    _scanline_maker->setNewYCoordinate(record.y);
+    _y_offset = record.y_offset;
+}
+
 /**
  * Given \a para filled in and \a start_span_pos set, keeps trying to
  * find somewhere it can fit the next line of text. The process of finding
@@ -2109,6 +2481,9 @@ bool Layout::Calculator::calculate()
     }
     TRACE(("begin calculate()\n"));
 
+    _flow._keepOutputForRelayout();
+    Relayout previous = std::move(_flow._relayout);
+    _flow._relayout = Relayout();
     _flow._clearOutputObjects();
 
     _pango_context = FontFactory::get().get_font_context();
@@ -2148,7 +2523,71 @@ bool Layout::Calculator::calculate()
     ParagraphInfo para;
     FontMetrics line_box_height; // Current value of line box height for line.
     bool keep_going = true; // Set false if we ran out of space and had to stash overflow.
-    for(para.first_input_index = 0 ; para.first_input_index < _flow._input_stream.size() ; ) {
+    para.first_input_index = 0;
+
+    // Find the paragraphs whose input is unchanged since the last calculation, at the start and
+    // at the end. The output of those at the start is copied. Those at the end are laid out
+    // until one of them starts where it did before; from there on the old output is copied too.
+    // (The second pass for textLength depends on the length of all the text, so is not recorded.)
+    auto &records = _flow._relayout.records;
+    bool const record = !_flow.textLength._set && _describeParagraphs();
+    bool const reuse = record && previous.kept && previous.flow == _flow._relayout.flow;
+    unsigned const count = record ? records.size() - 1 : 0;
+    unsigned const previous_count = reuse ? previous.records.size() - 1 : 0;
+    unsigned unchanged_before = 0;
+    unsigned unchanged_after = 0;
+    if (reuse) {
+        while (unchanged_before < count && unchanged_before < previous_count
+               && records[unchanged_before].input == previous.records[unchanged_before].input) {
+            unchanged_before++;
+        }
+        while (unchanged_after < count - unchanged_before && unchanged_after < previous_count - unchanged_before
+               && records[count - 1 - unchanged_after].input == previous.records[previous_count - 1 - unchanged_after].input) {
+            unchanged_after++;
+        }
+    }
+    if (unchanged_before > 0) {
+        TRACE(("reusing the first %u paragraphs\n", unchanged_before));
+        _reuseParagraphs(previous, 0, unchanged_before);
+        _resumeScanlineMaker(previous.records[unchanged_before]);
+        keep_going = previous.records[unchanged_before].flowed;
+        para.first_input_index = records[unchanged_before].first_input_index;
+    }
+
+    bool converged = false;
+    while (para.first_input_index < _flow._input_stream.size()) {
+
+        if (record) {
+            unsigned const index = _flow._paragraphs.size();
+            ParagraphRecord &paragraph_record = records[index];
+            paragraph_record.lines = _flow._lines.size();
+            paragraph_record.chunks = _flow._chunks.size();
+            paragraph_record.spans = _flow._spans.size();
+            paragraph_record.characters = _flow._characters.size();
+            paragraph_record.glyphs = _flow._glyphs.size();
+            paragraph_record.y = _scanline_maker->yCoordinate();
+            paragraph_record.shape_index = _current_shape_index;
+            paragraph_record.y_offset = _y_offset;
+            paragraph_record.flowed = keep_going;
+
+            // The old output of an unchanged paragraph that starts in the same place can be used
+            // as it is, apart from its indices, unless it is empty and so copied a span from the
+            // paragraph before. The first paragraph is placed differently, see below.
+            if (index > 0 && index >= count - unchanged_after && index + previous_count > count) {
+                ParagraphRecord const &previous_record = previous.records[index + previous_count - count];
+                if (!previous_record.empty
+                    && previous_record.y == paragraph_record.y
+                    && previous_record.shape_index == paragraph_record.shape_index
+                    && previous_record.y_offset == paragraph_record.y_offset
+                    && previous_record.flowed == paragraph_record.flowed) {
+                    TRACE(("layout converged at paragraph %u, reusing the rest\n", index));
+                    _reuseParagraphs(previous, index + previous_count - count, previous_count);
+                    keep_going = previous.records[previous_count].flowed;
+                    converged = true;
+                    break;
+                }
+            }
+        }
 
         // jump to the next wrap shape if this is a SHAPE_BREAK control code
         if (_flow._input_stream[para.first_input_index]->Type() == CONTROL_CODE) {
@@ -2202,6 +2641,7 @@ bool Layout::Calculator::calculate()
             if (line_box_height.emSize() < 0.001 && line_chunk_info.empty()) {
                 // We need to avoid an infinite (or semi-infinite) loop.
                 std::cerr << "Layout::Calculator::calculate: No room for text and line advance is very small" << std::endl;
+                _flow._relayout = Relayout();
                 return false; // For the moment
             }
 
@@ -2241,9 +2681,12 @@ bool Layout::Calculator::calculate()
         } while (span_pos.iter_span != para.unbroken_spans.end());
 
         TRACE(("para %lu end\n\n", _flow._paragraphs.size() - 1));
+        bool is_empty_para = _flow._characters.empty() || _flow._characters.back().line(&_flow).in_paragraph != _flow._paragraphs.size() - 1;
+        if (record) {
+            records[_flow._paragraphs.size() - 1].empty = is_empty_para;
+        }
         if (keep_going) {
             // We have more to do, setup next section.
-            bool is_empty_para = _flow._characters.empty() || _flow._characters.back().line(&_flow).in_paragraph != _flow._paragraphs.size() - 1;
             if ((is_empty_para && para_end_input_index + 1 >= _flow._input_stream.size())
                 || para_end_input_index + 1 < _flow._input_stream.size()) {
                 // we need a span just for the para if it's either an empty last para or a break in the middle
@@ -2268,6 +2711,11 @@ bool Layout::Calculator::calculate()
                 else
                     new_span.in_input_stream_item = para_end_input_index;
                 _flow._spans.push_back(new_span);
+                if (_flow._relayout.span_text.empty()) {
+                    _flow._relayout.span_text.emplace_back(-1, 0);
+                } else {
+                    _flow._relayout.span_text.push_back(_flow._relayout.span_text.back());
+                }
             }
             if (para_end_input_index + 1 < _flow._input_stream.size()) {
                 // we've got to add an invisible character between paragraphs so that we can position iterators
@@ -2299,6 +2747,22 @@ bool Layout::Calculator::calculate()
     } // Loop over paras
 
     para.free();
+    if (record && !converged) {
+        ParagraphRecord &end_record = records.back();
+        end_record.lines = _flow._lines.size();
+        end_record.chunks = _flow._chunks.size();
+        end_record.spans = _flow._spans.size();
+        end_record.characters = _flow._characters.size();
+        end_record.glyphs = _flow._glyphs.size();
+        end_record.y = _scanline_maker->yCoordinate();
+        end_record.shape_index = _current_shape_index;
+        end_record.y_offset = _y_offset;
+        end_record.flowed = keep_going;
+        end_record.empty = true;
+    }
+    if (!record) {
+        _flow._relayout = Relayout();
+    }
     if (_scanline_maker) {
         delete _scanline_maker;
     }
@@ -86,6 +86,25 @@ void Layout::_clearOutputObjects()
     _path_fitted = nullptr;
 }
 
+void Layout::_keepOutputForRelayout()
+{
+    if (_relayout.kept) {
+        return;
+    }
+    if (_relayout.records.empty() || _path_fitted) {
+        // fitToPathAlign() moved the glyphs after the output was recorded
+        _relayout = Relayout();
+        return;
+    }
+    _relayout.paragraphs = std::move(_paragraphs);
+    _relayout.lines = std::move(_lines);
+    _relayout.chunks = std::move(_chunks);
+    _relayout.spans = std::move(_spans);
+    _relayout.characters = std::move(_characters);
+    _relayout.glyphs = std::move(_glyphs);
+    _relayout.kept = true;
+}
+
 void Layout::FontMetrics::set(FontInstance const *font)
 {
     if (font) {
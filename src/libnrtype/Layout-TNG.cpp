@@ -26,6 +26,7 @@ Layout::~Layout()
 
 void Layout::clear()
 {
+    _keepOutputForRelayout();
     _clearInputObjects();
     _clearOutputObjects();
 
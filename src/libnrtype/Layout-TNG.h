@@ -22,6 +22,8 @@
 #include <algorithm>
 #include <vector>
 #include <optional>
+#include <string>
+#include <utility>
 #include <svg/svg-length.h>
 #include "style-enums.h"
 #include "display/curve.h"
@@ -679,6 +681,10 @@ private:
     /** Erases all the stuff output by computeFlow(). Glyphs and things. */
     void _clearOutputObjects();
 
+    /** Moves the output out of the way of the next calculation, which can reuse the parts of it
+    whose input is unchanged. See #_relayout. */
+    void _keepOutputForRelayout();
+
     static const gunichar UNICODE_SOFT_HYPHEN;
 
     // ******************* input flow
@@ -882,6 +888,38 @@ private:
     std::vector<Character> _characters;
     std::vector<Glyph> _glyphs;
 
+    // ******************* reuse of output
+
+    /** Where one paragraph starts in the output, and what it was laid out from. */
+    struct ParagraphRecord {
+        std::string input;          /// the paragraph's input stream items, see Calculator::_paragraphInput()
+        unsigned first_input_index;
+        unsigned lines, chunks, spans, characters, glyphs;  /// sizes of the output before the paragraph
+        double y;                   /// of the scanline maker before the paragraph
+        unsigned shape_index;
+        double y_offset;
+        bool flowed;                /// no text before the paragraph was stashed as overflow
+        bool empty;                 /// the paragraph has no characters of its own
+    };
+
+    /** Recorded by Calculator::calculate() so that the next calculation can copy the output of
+    the paragraphs before the first one whose input changed, and stop as soon as an unchanged
+    paragraph after it starts in the same place as before. */
+    struct Relayout {
+        std::string flow;           /// the input that affects all paragraphs, see Calculator::_flowInput()
+        std::vector<ParagraphRecord> records;    /// one per paragraph and one for the end of the output
+        /// Input stream item and byte offset from its text_begin of the first character of each span, -1 if none.
+        std::vector<std::pair<int, unsigned>> span_text;
+        std::vector<std::shared_ptr<FontInstance>> fonts;  /// identified by address in the records
+        bool kept = false;          /// the output below is the one described by the records
+        std::vector<Paragraph> paragraphs;
+        std::vector<Line> lines;
+        std::vector<Chunk> chunks;
+        std::vector<Span> spans;
+        std::vector<Character> characters;
+        std::vector<Glyph> glyphs;
+    } _relayout;
+
     /** gets the overall matrix that transforms the given glyph from local
     space to world space. */
     void _getGlyphTransformMatrix(int glyph_index, Geom::Affine *matrix) const;
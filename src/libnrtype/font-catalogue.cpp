@@ -0,0 +1,429 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Font information that is slow to gather, kept in the profile directory between sessions.
+ *//*
+ * Authors: see git history
+ *
+ * Copyright (C) 2022 Authors
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#ifndef PANGO_ENABLE_ENGINE
+#define PANGO_ENABLE_ENGINE
+#endif
+
+#include "font-catalogue.h"
+
+#include <cstring>
+#include <iostream>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <fontconfig/fontconfig.h>
+#include <pango/pangofc-font.h>
+
+#include "io/resource.h"
+
+namespace Inkscape {
+namespace Text {
+
+namespace {
+
+char const MAGIC[8] = {'I', 'N', 'K', 'F', 'O', 'N', 'T', 'S'};
+
+// Increase whenever the layout of the file, or the way its contents are gathered, changes.
+std::uint32_t const VERSION = 1;
+
+class Writer
+{
+public:
+    void raw(void const *data, std::size_t size) { _data.append(static_cast<char const *>(data), size); }
+    template <typename T>
+    void value(T v) { raw(&v, sizeof(v)); }
+    void string(std::string const &s)
+    {
+        value<std::uint32_t>(s.size());
+        raw(s.data(), s.size());
+    }
+
+    std::string const &data() const { return _data; }
+
+private:
+    std::string _data;
+};
+
+class Reader
+{
+public:
+    Reader(char const *data, std::size_t size) : _pos(data), _end(data + size) {}
+
+    bool raw(void *data, std::size_t size)
+    {
+        if (!_ok || std::size_t(_end - _pos) < size) {
+            return _ok = false;
+        }
+        std::memcpy(data, _pos, size);
+        _pos += size;
+        return true;
+    }
+    template <typename T>
+    T value()
+    {
+        T v{};
+        raw(&v, sizeof(v));
+        return v;
+    }
+    std::string string()
+    {
+        auto const size = value<std::uint32_t>();
+        if (!_ok || std::size_t(_end - _pos) < size) {
+            _ok = false;
+            return {};
+        }
+        std::string s(_pos, size);
+        _pos += size;
+        return s;
+    }
+
+    bool ok() const { return _ok; }
+    bool atEnd() const { return _pos == _end; }
+
+private:
+    char const *_pos;
+    char const *_end;
+    bool _ok = true;
+};
+
+/// Adds the modification times of a list of fontconfig files or directories to a checksum.
+void add_mtimes(GChecksum *checksum, FcStrList *list)
+{
+    if (!list) {
+        return;
+    }
+    while (FcChar8 *path = FcStrListNext(list)) {
+        GStatBuf st;
+        std::int64_t mtime = g_stat((char const *)path, &st) == 0 ? st.st_mtime : -1;
+        g_checksum_update(checksum, path, -1);
+        g_checksum_update(checksum, (guchar const *)&mtime, sizeof(mtime));
+    }
+    FcStrListDone(list);
+}
+
+} // namespace
+
+FontCatalogue &FontCatalogue::get()
+{
+    static FontCatalogue catalogue;
+    return catalogue;
+}
+
+FontCatalogue::FontCatalogue()
+{
+    char *filename = Inkscape::IO::Resource::profile_path("fontcatalogue.bin");
+    _filename = filename;
+    g_free(filename);
+    _pending = std::async(std::launch::async, _read, _filename);
+}
+
+std::optional<FontCatalogue::FaceId> FontCatalogue::identify(PangoFont *font)
+{
+    if (!PANGO_IS_FC_FONT(font)) {
+        return {};
+    }
+#if PANGO_VERSION_CHECK(1,48,0)
+    FcPattern *pattern = pango_fc_font_get_pattern(PANGO_FC_FONT(font));
+#else
+    FcPattern *pattern = PANGO_FC_FONT(font)->font_pattern;
+#endif
+    FcChar8 *file = nullptr;
+    int index = 0;
+    if (!pattern || FcPatternGetString(pattern, FC_FILE, 0, &file) != FcResultMatch) {
+        return {};
+    }
+    FcPatternGetInteger(pattern, FC_INDEX, 0, &index);
+
+    GStatBuf st;
+    if (g_stat((char const *)file, &st) != 0) {
+        return {};
+    }
+    return FaceId{(char const *)file, index, std::int64_t(st.st_mtime), std::int64_t(st.st_size)};
+}
+
+bool FontCatalogue::lookupStyles(std::string const &family, Styles &styles)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _adopt();
+    auto it = _contents.styles.find(family);
+    if (it == _contents.styles.end()) {
+        return false;
+    }
+    styles = it->second;
+    return true;
+}
+
+void FontCatalogue::insertStyles(std::string const &family, Styles styles)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _adopt();
+    if (_keep_styles) {
+        _contents.styles[family] = std::move(styles);
+        _dirty = true;
+    }
+}
+
+bool FontCatalogue::lookupAxes(FaceId const &id, std::map<Glib::ustring, OTVarAxis> &axes)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _adopt();
+    auto face = _face(id);
+    if (!face || !face->axes) {
+        return false;
+    }
+    axes = *face->axes;
+    return true;
+}
+
+void FontCatalogue::insertAxes(FaceId const &id, std::map<Glib::ustring, OTVarAxis> const &axes)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _adopt();
+    _insertFace(id).axes = axes;
+}
+
+bool FontCatalogue::lookupTables(FaceId const &id, std::map<Glib::ustring, OTSubstitution> &tables)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _adopt();
+    auto face = _face(id);
+    if (!face || !face->tables) {
+        return false;
+    }
+    tables = *face->tables;
+    return true;
+}
+
+void FontCatalogue::insertTables(FaceId const &id, std::map<Glib::ustring, OTSubstitution> const &tables)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _adopt();
+    _insertFace(id).tables = tables;
+}
+
+void FontCatalogue::fontsChanged()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_pending.valid()) {
+        // Not in use yet: fonts added at startup are covered by the stamp.
+        return;
+    }
+    // The families may now include fonts that will be gone in the next session.
+    _contents.styles.clear();
+    _keep_styles = false;
+}
+
+void FontCatalogue::save()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_dirty) {
+        return;
+    }
+
+    Writer out;
+    out.raw(MAGIC, sizeof(MAGIC));
+    out.value(VERSION);
+    out.string(_stamp());
+
+    out.value<std::uint32_t>(_contents.styles.size());
+    for (auto const &[family, styles] : _contents.styles) {
+        out.string(family);
+        out.value<std::uint32_t>(styles.size());
+        for (auto const &style : styles) {
+            out.string(style.first);
+            out.string(style.second);
+        }
+    }
+
+    out.value<std::uint32_t>(_contents.faces.size());
+    for (auto const &[key, face] : _contents.faces) {
+        out.string(key.first);
+        out.value<std::int32_t>(key.second);
+        out.value(face.mtime);
+        out.value(face.size);
+        out.value<std::uint8_t>(bool(face.axes));
+        if (face.axes) {
+            out.value<std::uint32_t>(face.axes->size());
+            for (auto const &[name, axis] : *face.axes) {
+                out.string(name.raw());
+                out.value(axis.minimum);
+                out.value(axis.def);
+                out.value(axis.maximum);
+                out.value(axis.set_val);
+                out.value<std::int32_t>(axis.index);
+            }
+        }
+        out.value<std::uint8_t>(bool(face.tables));
+        if (face.tables) {
+            out.value<std::uint32_t>(face.tables->size());
+            for (auto const &[name, table] : *face.tables) {
+                out.string(name.raw());
+                out.string(table.before.raw());
+                out.string(table.input.raw());
+                out.string(table.after.raw());
+                out.string(table.output.raw());
+            }
+        }
+    }
+
+    GError *error = nullptr;
+    if (!g_file_set_contents(_filename.c_str(), out.data().data(), out.data().size(), &error)) {
+        std::cerr << "FontCatalogue::save: " << error->message << std::endl;
+        g_error_free(error);
+        return;
+    }
+    _dirty = false;
+}
+
+std::optional<FontCatalogue::Contents> FontCatalogue::_read(std::string const &filename)
+{
+    gchar *data = nullptr;
+    gsize length = 0;
+    if (!g_file_get_contents(filename.c_str(), &data, &length, nullptr)) {
+        return {};
+    }
+
+    Contents contents;
+    Reader in(data, length);
+
+    char magic[sizeof(MAGIC)];
+    if (!in.raw(magic, sizeof(magic)) || std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0 ||
+        in.value<std::uint32_t>() != VERSION) {
+        g_free(data);
+        return {};
+    }
+    contents.stamp = in.string();
+
+    for (auto n = in.value<std::uint32_t>(); in.ok() && n > 0; --n) {
+        auto family = in.string();
+        Styles styles;
+        for (auto m = in.value<std::uint32_t>(); in.ok() && m > 0; --m) {
+            auto css = in.string();
+            auto display = in.string();
+            styles.emplace_back(std::move(css), std::move(display));
+        }
+        contents.styles.emplace(std::move(family), std::move(styles));
+    }
+
+    for (auto n = in.value<std::uint32_t>(); in.ok() && n > 0; --n) {
+        auto file = in.string();
+        auto index = in.value<std::int32_t>();
+        Face face;
+        face.mtime = in.value<std::int64_t>();
+        face.size = in.value<std::int64_t>();
+        if (in.value<std::uint8_t>()) {
+            face.axes.emplace();
+            for (auto m = in.value<std::uint32_t>(); in.ok() && m > 0; --m) {
+                auto name = in.string();
+                OTVarAxis axis;
+                axis.minimum = in.value<double>();
+                axis.def = in.value<double>();
+                axis.maximum = in.value<double>();
+                axis.set_val = in.value<double>();
+                axis.index = in.value<std::int32_t>();
+                face.axes->emplace(std::move(name), axis);
+            }
+        }
+        if (in.value<std::uint8_t>()) {
+            face.tables.emplace();
+            for (auto m = in.value<std::uint32_t>(); in.ok() && m > 0; --m) {
+                auto name = in.string();
+                OTSubstitution table;
+                table.before = in.string();
+                table.input = in.string();
+                table.after = in.string();
+                table.output = in.string();
+                face.tables->emplace(std::move(name), std::move(table));
+            }
+        }
+        contents.faces.emplace(std::make_pair(std::move(file), index), std::move(face));
+    }
+
+    bool const valid = in.ok() && in.atEnd();
+    g_free(data);
+    if (!valid) {
+        std::cerr << "FontCatalogue: ignoring damaged file " << filename << std::endl;
+        return {};
+    }
+    return contents;
+}
+
+/**
+ * Returns a checksum of everything that decides which fonts fontconfig offers: its configuration
+ * files, the directories with its caches and the font directories, including those added by
+ * FontFactory::AddFontsDir(), together with the version of Pango that describes the faces.
+ */
+std::string FontCatalogue::_stamp()
+{
+    GChecksum *checksum = g_checksum_new(G_CHECKSUM_SHA1);
+    g_checksum_update(checksum, (guchar const *)pango_version_string(), -1);
+    FcConfig *config = FcConfigGetCurrent();
+    add_mtimes(checksum, FcConfigGetConfigFiles(config));
+    add_mtimes(checksum, FcConfigGetCacheDirs(config));
+    add_mtimes(checksum, FcConfigGetFontDirs(config));
+    std::string stamp = g_checksum_get_string(checksum);
+    g_checksum_free(checksum);
+    return stamp;
+}
+
+/// Takes over the contents of the file once they are first needed, if they are still valid.
+void FontCatalogue::_adopt()
+{
+    if (!_pending.valid()) {
+        return;
+    }
+    auto contents = _pending.get();
+    if (!contents) {
+        return;
+    }
+    if (contents->stamp != _stamp()) {
+        // Fonts were installed or removed; the families must be listed again, while the faces
+        // are still checked one by one.
+        contents->styles.clear();
+        _dirty = true;
+    }
+    _contents = std::move(*contents);
+}
+
+FontCatalogue::Face *FontCatalogue::_face(FaceId const &id)
+{
+    auto it = _contents.faces.find({id.file, id.index});
+    if (it == _contents.faces.end() || it->second.mtime != id.mtime || it->second.size != id.size) {
+        return nullptr;
+    }
+    return &it->second;
+}
+
+FontCatalogue::Face &FontCatalogue::_insertFace(FaceId const &id)
+{
+    auto &face = _contents.faces[{id.file, id.index}];
+    if (face.mtime != id.mtime || face.size != id.size) {
+        face = Face();
+        face.mtime = id.mtime;
+        face.size = id.size;
+    }
+    _dirty = true;
+    return face;
+}
+
+} // namespace Text
+} // namespace Inkscape
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
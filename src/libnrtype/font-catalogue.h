@@ -0,0 +1,127 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Font information that is slow to gather, kept in the profile directory between sessions.
+ *//*
+ * Authors: see git history
+ *
+ * Copyright (C) 2022 Authors
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+#ifndef LIBNRTYPE_FONT_CATALOGUE_H
+#define LIBNRTYPE_FONT_CATALOGUE_H
+
+#include <cstdint>
+#include <future>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <glibmm/ustring.h>
+#include <pango/pango.h>
+
+#include "OpenTypeUtil.h"
+
+namespace Inkscape {
+namespace Text {
+
+/**
+ * A persistent catalogue of the installed fonts.
+ *
+ * Holds the style list of each font family, as made by FontFactory::GetUIStyles(), and for each
+ * font file the variation axes and GSUB substitutions read by FontInstance. The catalogue file is
+ * read on a background thread as soon as the catalogue is created. Its contents are only used if
+ * it was written by the same version of the format and Pango, and if no fontconfig configuration
+ * file, cache directory or font directory has been modified since.
+ */
+class FontCatalogue
+{
+public:
+    /// Style names of a family: CSS name and display name, in display order.
+    using Styles = std::vector<std::pair<std::string, std::string>>;
+
+    /// Identifies one face of a font file in the state it was read.
+    struct FaceId
+    {
+        std::string file;
+        int index = 0;
+        std::int64_t mtime = 0;
+        std::int64_t size = 0;
+    };
+
+    static FontCatalogue &get();
+
+    FontCatalogue(FontCatalogue const &) = delete;
+    FontCatalogue &operator=(FontCatalogue const &) = delete;
+
+    /// Returns the file and face index of a font loaded by a fontconfig based font map.
+    static std::optional<FaceId> identify(PangoFont *font);
+
+    /// Retrieves the style list stored for a family. Returns false if there is none.
+    bool lookupStyles(std::string const &family, Styles &styles);
+    void insertStyles(std::string const &family, Styles styles);
+
+    /// Retrieves the variation axes stored for a face. Returns false if there are none.
+    bool lookupAxes(FaceId const &id, std::map<Glib::ustring, OTVarAxis> &axes);
+    void insertAxes(FaceId const &id, std::map<Glib::ustring, OTVarAxis> const &axes);
+
+    /// Retrieves the GSUB substitutions stored for a face. Returns false if there are none.
+    bool lookupTables(FaceId const &id, std::map<Glib::ustring, OTSubstitution> &tables);
+    void insertTables(FaceId const &id, std::map<Glib::ustring, OTSubstitution> const &tables);
+
+    /// Forgets the style lists, because fonts were added for this session only.
+    void fontsChanged();
+
+    /// Writes the catalogue back to its file, if anything was added.
+    void save();
+
+private:
+    struct Face
+    {
+        std::int64_t mtime = 0;
+        std::int64_t size = 0;
+        std::optional<std::map<Glib::ustring, OTVarAxis>> axes;
+        std::optional<std::map<Glib::ustring, OTSubstitution>> tables;
+    };
+
+    struct Contents
+    {
+        std::string stamp;
+        std::unordered_map<std::string, Styles> styles;
+        std::map<std::pair<std::string, int>, Face> faces;
+    };
+
+    FontCatalogue();
+
+    static std::optional<Contents> _read(std::string const &filename);
+    static std::string _stamp();
+    void _adopt();
+    Face *_face(FaceId const &id);
+    Face &_insertFace(FaceId const &id);
+
+    std::string _filename;
+    std::future<std::optional<Contents>> _pending; ///< the file being read, until first used
+    Contents _contents;
+    bool _keep_styles = true;
+    bool _dirty = false;
+    std::mutex _mutex;
+};
+
+} // namespace Text
+} // namespace Inkscape
+
+#endif // LIBNRTYPE_FONT_CATALOGUE_H
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -31,9 +31,11 @@
 #include "io/sys.h"
 #include "io/resource.h"
 
+#include "libnrtype/font-catalogue.h"
 #include "libnrtype/font-factory.h"
 #include "libnrtype/font-instance.h"
 #include "libnrtype/OpenTypeUtil.h"
+#include "libnrtype/shaping-cache.h"
 
 #ifdef _WIN32
 #include <glibmm.h>
@@ -208,6 +210,9 @@ FontFactory::FontFactory()
 #else
     pango_ft2_font_map_set_default_substitute(PANGO_FT2_FONT_MAP(fontServer), FactorySubstituteFunc, this, nullptr);
 #endif
+
+    // Start reading the font catalogue of the last session.
+    Inkscape::Text::FontCatalogue::get();
 }
 
 FontFactory::~FontFactory()
@@ -396,6 +401,18 @@ GList *FontFactory::GetUIStyles(PangoFontFamily *in)
         return ret;
     }
 
+    // Listing the faces is slow with many fonts installed; reuse the list of an earlier session.
+    auto &catalogue = Inkscape::Text::FontCatalogue::get();
+    char const *familyName = pango_font_family_get_name(in);
+    std::string const family = familyName ? familyName : "";
+    Inkscape::Text::FontCatalogue::Styles styles;
+    if (catalogue.lookupStyles(family, styles)) {
+        for (auto &style : styles) {
+            ret = g_list_prepend(ret, new StyleNames(std::move(style.first), std::move(style.second)));
+        }
+        return g_list_reverse(ret);
+    }
+
     pango_font_family_list_faces(in, &faces, &numFaces);
 
     for (int currentFace = 0; currentFace < numFaces; currentFace++) {
@@ -478,6 +495,12 @@ GList *FontFactory::GetUIStyles(PangoFontFamily *in)
 
     // Sort the style lists
     ret = g_list_sort( ret, StyleNameCompareInternalGlib );
+
+    for (GList *l = ret; l; l = l->next) {
+        auto names = (StyleNames *)l->data;
+        styles.emplace_back(names->CssName.raw(), names->DisplayName.raw());
+    }
+    catalogue.insertStyles(family, std::move(styles));
     return ret;
 }
 
@@ -655,6 +678,8 @@ void FontFactory::AddFontsDir(char const *utf8dir)
     if (res == FcTrue) {
         g_info("Fonts dir '%s' added successfully.", utf8dir);
         pango_fc_font_map_config_changed(PANGO_FC_FONT_MAP(fontServer));
+        Inkscape::Text::ShapingCache::get().clear();
+        Inkscape::Text::FontCatalogue::get().fontsChanged();
     } else {
         g_warning("Could not add fonts dir '%s'.", utf8dir);
     }
@@ -682,6 +707,8 @@ void FontFactory::AddFontFile(char const *utf8file)
     if (res == FcTrue) {
         g_info("Font file '%s' added successfully.", utf8file);
         pango_fc_font_map_config_changed(PANGO_FC_FONT_MAP(fontServer));
+        Inkscape::Text::ShapingCache::get().clear();
+        Inkscape::Text::FontCatalogue::get().fontsChanged();
     } else {
         g_warning("Could not add font file '%s'.", utf8file);
     }
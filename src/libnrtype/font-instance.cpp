@@ -194,7 +194,15 @@ void FontInstance::init_face()
     FT_Select_Charmap(face, ft_encoding_symbol);
 
     readOpenTypeSVGTable(hb_font, openTypeSVGGlyphs);
-    readOpenTypeFvarAxes(face, openTypeVarAxes);
+
+    auto &catalogue = Inkscape::Text::FontCatalogue::get();
+    face_id = catalogue.identify(p_font);
+    if (!face_id || !catalogue.lookupAxes(*face_id, openTypeVarAxes)) {
+        readOpenTypeFvarAxes(face, openTypeVarAxes);
+        if (face_id) {
+            catalogue.insertAxes(*face_id, openTypeVarAxes);
+        }
+    }
 
 #if FREETYPE_MAJOR == 2 && FREETYPE_MINOR >= 8  // 2.8 does not seem to work even though it has some support.
 
@@ -654,7 +662,13 @@ std::map<Glib::ustring, OTSubstitution> const &FontInstance::get_opentype_tables
         assert(hb_font);
 
         openTypeTables.emplace();
-        readOpenTypeGsubTable(hb_font, *openTypeTables);
+        auto &catalogue = Inkscape::Text::FontCatalogue::get();
+        if (!face_id || !catalogue.lookupTables(*face_id, *openTypeTables)) {
+            readOpenTypeGsubTable(hb_font, *openTypeTables);
+            if (face_id) {
+                catalogue.insertTables(*face_id, *openTypeTables);
+            }
+        }
     }
 
     return *openTypeTables;
@@ -19,6 +19,7 @@
 #include <pango/pango-types.h>
 #include <pango/pango-font.h>
 
+#include "font-catalogue.h"
 #include "font-glyph.h"
 #include "OpenTypeUtil.h"
 #include "style-enums.h"
@@ -154,6 +155,9 @@ private:
     // Map of OpenType tables found in font. Transparently lazy-loaded.
     std::optional<std::map<Glib::ustring, OTSubstitution>> openTypeTables;
 
+    // The font file, under which the tables are kept in the font catalogue.
+    std::optional<Inkscape::Text::FontCatalogue::FaceId> face_id;
+
     /*
      * Glyphs
      */
@@ -0,0 +1,147 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Results of itemizing and shaping text paragraphs with Pango, shared by all text layouts.
+ *//*
+ * Authors: see git history
+ *
+ * Copyright (C) 2022 Authors
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include "shaping-cache.h"
+
+#include <iterator>
+#include <utility>
+
+#include "font-instance.h"
+
+namespace Inkscape {
+namespace Text {
+
+namespace {
+
+std::size_t glyphs_size(PangoGlyphString const *glyphs)
+{
+    return sizeof(PangoGlyphString) + glyphs->num_glyphs * (sizeof(PangoGlyphInfo) + sizeof(gint));
+}
+
+} // namespace
+
+ShapingCache::Paragraph::~Paragraph()
+{
+    for (auto item : items) {
+        pango_item_free(item);
+    }
+    for (auto &glyphs : _glyphs) {
+        pango_glyph_string_free(glyphs.second);
+    }
+}
+
+std::size_t ShapingCache::Paragraph::_size() const
+{
+    return sizeof(Paragraph) + items.size() * (sizeof(PangoItem) + sizeof(std::shared_ptr<FontInstance>))
+         + char_attributes.size() * sizeof(PangoLogAttr) + _glyphs_size;
+}
+
+ShapingCache &ShapingCache::get()
+{
+    static ShapingCache cache;
+    return cache;
+}
+
+void ShapingCache::setBudget(std::size_t bytes)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _budget = bytes;
+    _trim();
+}
+
+void ShapingCache::clear()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    while (!_entries.empty()) {
+        _erase(_entries.begin());
+    }
+}
+
+std::shared_ptr<ShapingCache::Paragraph> ShapingCache::lookup(std::string const &key)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto found = _index.find(key);
+    if (found == _index.end()) {
+        return nullptr;
+    }
+    _entries.splice(_entries.begin(), _entries, found->second);
+    return found->second->paragraph;
+}
+
+void ShapingCache::insert(std::string key, std::shared_ptr<Paragraph> paragraph)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_budget == 0 || _index.count(key)) {
+        return;
+    }
+
+    _entries.push_front({std::move(key), std::move(paragraph)});
+    auto it = _entries.begin();
+    _index.emplace(it->key, it);
+    it->paragraph->_stored = true;
+    _size += it->key.size() + it->paragraph->_size();
+    _trim();
+}
+
+PangoGlyphString *ShapingCache::glyphs(Paragraph const &paragraph, unsigned offset, unsigned length, unsigned item)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto found = paragraph._glyphs.find({offset, length, item});
+    if (found == paragraph._glyphs.end()) {
+        return nullptr;
+    }
+    return pango_glyph_string_copy(found->second);
+}
+
+void ShapingCache::addGlyphs(Paragraph &paragraph, unsigned offset, unsigned length, unsigned item, PangoGlyphString *glyphs)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!paragraph._stored) {
+        return;
+    }
+    auto inserted = paragraph._glyphs.emplace(std::make_tuple(offset, length, item), nullptr);
+    if (!inserted.second) {
+        return;
+    }
+    inserted.first->second = pango_glyph_string_copy(glyphs);
+    std::size_t const size = glyphs_size(glyphs);
+    paragraph._glyphs_size += size;
+    _size += size;
+    _trim();
+}
+
+void ShapingCache::_erase(std::list<Entry>::iterator it)
+{
+    _size -= it->key.size() + it->paragraph->_size();
+    it->paragraph->_stored = false;
+    _index.erase(it->key);
+    _entries.erase(it);
+}
+
+void ShapingCache::_trim()
+{
+    while (_size > _budget && !_entries.empty()) {
+        _erase(std::prev(_entries.end()));
+    }
+}
+
+} // namespace Text
+} // namespace Inkscape
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,123 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Results of itemizing and shaping text paragraphs with Pango, shared by all text layouts.
+ *//*
+ * Authors: see git history
+ *
+ * Copyright (C) 2022 Authors
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+#ifndef LIBNRTYPE_SHAPING_CACHE_H
+#define LIBNRTYPE_SHAPING_CACHE_H
+
+#include <cstddef>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#include <pango/pango.h>
+
+class FontInstance;
+
+namespace Inkscape {
+namespace Text {
+
+/**
+ * Least recently used results of Pango for text paragraphs.
+ *
+ * A paragraph is found by a key describing everything Pango is given to itemize it: the text, the
+ * font, OpenType features and language of each run, and the base direction and gravity. The glyphs
+ * of its spans are added to the paragraph as they are shaped, so that laying out the paragraph
+ * again, after a change that does not affect shaping, does not call Pango at all.
+ */
+class ShapingCache
+{
+public:
+    /// Itemization and shaping of one paragraph. Immutable once stored, apart from its glyphs.
+    class Paragraph
+    {
+    public:
+        Paragraph() = default;
+        Paragraph(Paragraph const &) = delete;
+        Paragraph &operator=(Paragraph const &) = delete;
+        ~Paragraph();
+
+        std::vector<PangoItem *> items;                    ///< owned
+        std::vector<std::shared_ptr<FontInstance>> fonts;  ///< font of each item
+        std::vector<PangoLogAttr> char_attributes;
+        /// The fonts named in the key, which must stay alive for their addresses to identify them.
+        std::vector<std::shared_ptr<FontInstance>> key_fonts;
+
+    private:
+        friend class ShapingCache;
+        std::size_t _size() const;
+
+        /// Glyphs by byte offset and length of the span, and index of its item.
+        std::map<std::tuple<unsigned, unsigned, unsigned>, PangoGlyphString *> _glyphs;
+        std::size_t _glyphs_size = 0;
+        bool _stored = false;
+    };
+
+    static ShapingCache &get();
+
+    ShapingCache(ShapingCache const &) = delete;
+    ShapingCache &operator=(ShapingCache const &) = delete;
+
+    /// Sets the memory that the stored paragraphs may use. Zero disables the cache.
+    void setBudget(std::size_t bytes);
+
+    /// Drops all paragraphs, for example because the available fonts changed.
+    void clear();
+
+    /// Returns the paragraph stored under the key, or nullptr.
+    std::shared_ptr<Paragraph> lookup(std::string const &key);
+
+    /// Stores a newly itemized paragraph under the key.
+    void insert(std::string key, std::shared_ptr<Paragraph> paragraph);
+
+    /// Returns a copy of the glyphs stored for a span of the paragraph, or nullptr.
+    PangoGlyphString *glyphs(Paragraph const &paragraph, unsigned offset, unsigned length, unsigned item);
+
+    /// Stores a copy of the glyphs of a span of the paragraph.
+    void addGlyphs(Paragraph &paragraph, unsigned offset, unsigned length, unsigned item, PangoGlyphString *glyphs);
+
+private:
+    ShapingCache() = default;
+
+    struct Entry
+    {
+        std::string key;
+        std::shared_ptr<Paragraph> paragraph;
+    };
+
+    void _erase(std::list<Entry>::iterator it);
+    void _trim();
+
+    std::list<Entry> _entries; ///< most recently used first
+    std::unordered_map<std::string_view, std::list<Entry>::iterator> _index; ///< keys point into _entries
+    std::size_t _size = 0;
+    std::size_t _budget = 32 << 20;
+    std::mutex _mutex;
+};
+
+} // namespace Text
+} // namespace Inkscape
+
+#endif // LIBNRTYPE_SHAPING_CACHE_H
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -13,12 +13,19 @@
 //#define LPE_ENABLE_TEST_EFFECTS //uncomment for toy effects
 
 // include effects:
+#include <algorithm>
+#include <condition_variable>
 #include <cstdio>
 #include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <glibmm/dispatcher.h>
 #include <gtkmm/expander.h>
 #include <pangomm/layout.h>
 
 #include "display/curve.h"
+#include "document-undo.h"
 #include "inkscape.h"
 #include "live_effects/effect.h"
 #include "live_effects/lpe-angle_bisector.h"
@@ -81,6 +88,7 @@
 #include "live_effects/lpeobject.h"
 #include "message-stack.h"
 #include "object/sp-defs.h"
+#include "object/sp-item-group.h"
 #include "object/sp-root.h"
 #include "object/sp-shape.h"
 #include "path-chemistry.h"
@@ -1108,6 +1116,7 @@ Effect::Effect(LivePathEffectObject *lpeobject)
 Effect::~Effect()
 {
     _before_commit_connection.disconnect();
+    cancelAsyncEffect();
 }
 
 Glib::ustring
@@ -1532,6 +1541,235 @@ void Effect::doBeforeEffect_impl(SPLPEItem const* lpeitem)
     update_helperpath();
 }
 
+/**
+ * Collects the parameter values the result depends on. Returns false if the result depends on
+ * anything else that could change unnoticed: linked paths and items, groups, whose result
+ * depends on their children, and runs while the effect is loaded or applied.
+ */
+bool Effect::getResultKey(SPLPEItem const *lpeitem, Glib::ustring &params) const
+{
+    if (!result_cacheable || is_load || is_applied || !lpeitem || dynamic_cast<SPGroup const *>(lpeitem)) {
+        return false;
+    }
+    for (auto param : param_vector) {
+        switch (param->paramType()) {
+            case ORIGINAL_PATH:
+            case ORIGINAL_SATELLITE:
+            case PATH_ARRAY:
+            case PATH_REFERENCE:
+            case SATELLITE:
+            case SATELLITE_ARRAY:
+                return false;
+            default:
+                break;
+        }
+        Glib::ustring const value = param->param_getSVGValue();
+        if (param->paramType() == PATH && !value.empty() && value[0] == '#') {
+            // follows another path
+            return false;
+        }
+        params += param->param_key;
+        params += "=";
+        params += value;
+        params += ";";
+    }
+    return true;
+}
+
+bool Effect::makeResultKey(SPLPEItem const *lpeitem, Geom::PathVector const &path_in, ResultCache &entry) const
+{
+    if (!getResultKey(lpeitem, entry.params)) {
+        return false;
+    }
+    entry.item = lpeitem;
+    entry.i2doc = lpeitem->i2doc_affine();
+    entry.zoom = current_zoom;
+    entry.selected_nodes = selectedNodesPoints;
+    entry.path_in = path_in;
+    return true;
+}
+
+bool Effect::sameResultKey(ResultCache const &a, ResultCache const &b)
+{
+    // The input is compared in full rather than by a hash, so a hit is never a collision.
+    return a.item == b.item && a.params == b.params && a.zoom == b.zoom && a.selected_nodes == b.selected_nodes &&
+           a.i2doc == b.i2doc && a.path_in == b.path_in;
+}
+
+bool Effect::cachedResult(SPLPEItem const *lpeitem, Geom::PathVector const &path_in, Geom::PathVector &path_out)
+{
+    if (!result_cache.valid || result_cache.item != lpeitem) {
+        return false;
+    }
+    ResultCache current;
+    if (!makeResultKey(lpeitem, path_in, current) || !sameResultKey(result_cache, current)) {
+        return false;
+    }
+    // back to a computed state, a job for another one is no longer wanted
+    cancelAsyncEffect();
+    path_out = result_cache.path_out;
+    return true;
+}
+
+void Effect::storeResult(SPLPEItem const *lpeitem, Geom::PathVector const &path_in, Geom::PathVector const &path_out)
+{
+    ResultCache entry;
+    if (!makeResultKey(lpeitem, path_in, entry)) {
+        result_cache.valid = false;
+        return;
+    }
+    entry.path_out = path_out;
+    entry.valid = true;
+    result_cache = std::move(entry);
+}
+
+/**
+ * Runs the jobs of all effects, one after another on a single thread. A job is cancelled when
+ * a newer one of its effect starts, and cancelled jobs are dropped before they run, so only the
+ * newest job of each effect is ever waiting. Finished jobs are handed back to the main thread.
+ */
+class Effect::AsyncWorker
+{
+public:
+    // Created on the main thread, and never deleted, as a job may still be running at exit.
+    static AsyncWorker &get()
+    {
+        static auto worker = new AsyncWorker();
+        return *worker;
+    }
+
+    void push(std::shared_ptr<AsyncJob> job)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _pending.erase(std::remove_if(_pending.begin(), _pending.end(),
+                                      [](std::shared_ptr<AsyncJob> const &pending) { return pending->cancelled; }),
+                       _pending.end());
+        _pending.push_back(std::move(job));
+        _wakeup.notify_one();
+    }
+
+private:
+    AsyncWorker()
+    {
+        _dispatcher.connect(sigc::mem_fun(*this, &AsyncWorker::dispatch));
+        std::thread(&AsyncWorker::run, this).detach();
+    }
+
+    void run()
+    {
+        for (;;) {
+            std::shared_ptr<AsyncJob> job;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _wakeup.wait(lock, [this] { return !_pending.empty(); });
+                job = std::move(_pending.front());
+                _pending.pop_front();
+            }
+            if (job->cancelled) {
+                continue;
+            }
+            try {
+                job->entry.path_out = job->work(job->cancelled);
+            } catch (std::exception &e) {
+                g_warning("Exception during asynchronous LPE execution. \n %s", e.what());
+                job->cancelled = true;
+            }
+            job->work = nullptr;
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _finished.push_back(std::move(job));
+            }
+            _dispatcher.emit();
+        }
+    }
+
+    // On the main thread, where jobs are cancelled, so an effect is not deleted while in use here.
+    void dispatch()
+    {
+        std::vector<std::shared_ptr<AsyncJob>> finished;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            finished.swap(_finished);
+        }
+        for (auto const &job : finished) {
+            if (!job->cancelled) {
+                job->effect->finishAsyncEffect(job);
+            }
+        }
+    }
+
+    std::mutex _mutex;
+    std::condition_variable _wakeup;
+    std::deque<std::shared_ptr<AsyncJob>> _pending;
+    std::vector<std::shared_ptr<AsyncJob>> _finished;
+    Glib::Dispatcher _dispatcher;
+};
+
+bool Effect::startAsyncEffect(SPLPEItem const *lpeitem, Geom::PathVector const &path_in, Geom::PathVector &path_out)
+{
+    Inkscape::Preferences *prefs = Inkscape::Preferences::get();
+    // Without a desktop nobody waits for the result, and without a previous result nothing can
+    // be shown meanwhile: compute it right away.
+    if (!prefs->getBool("/live_effects/async", false) || !SP_ACTIVE_DESKTOP || !result_cache.valid ||
+        result_cache.item != lpeitem) {
+        return false;
+    }
+    auto job = std::make_shared<AsyncJob>();
+    if (!makeResultKey(lpeitem, path_in, job->entry)) {
+        return false;
+    }
+    if (_async_job && !_async_job->cancelled && sameResultKey(_async_job->entry, job->entry)) {
+        // already on its way
+        path_out = result_cache.path_out;
+        return true;
+    }
+    job->work = prepareAsyncEffect(path_in);
+    if (!job->work) {
+        return false;
+    }
+    cancelAsyncEffect();
+    job->effect = this;
+    _async_job = job;
+    AsyncWorker::get().push(std::move(job));
+    path_out = result_cache.path_out;
+    return true;
+}
+
+/**
+ * Called on the main thread once a job is done: its result is stored and the item updated,
+ * which then takes the result from the cache.
+ */
+void Effect::finishAsyncEffect(std::shared_ptr<AsyncJob> const &job)
+{
+    if (job != _async_job) {
+        return;
+    }
+    _async_job.reset();
+    // the item may be gone, or the effect changed in a way that does not update the item
+    auto lpeitem = const_cast<SPLPEItem *>(job->entry.item);
+    auto const lpeitems = getCurrrentLPEItems();
+    if (std::find(lpeitems.begin(), lpeitems.end(), lpeitem) == lpeitems.end()) {
+        return;
+    }
+    Glib::ustring params;
+    if (!getResultKey(lpeitem, params) || params != job->entry.params) {
+        return;
+    }
+    result_cache = std::move(job->entry);
+    result_cache.valid = true;
+    // The path data is derived from the original one, so it is not an undo step of its own.
+    DocumentUndo::ScopedInsensitive _no_undo(lpeitem->document);
+    sp_lpe_item_update_patheffect(lpeitem, false, true);
+}
+
+void Effect::cancelAsyncEffect()
+{
+    if (_async_job) {
+        _async_job->cancelled = true;
+        _async_job.reset();
+    }
+}
+
 void
 Effect::writeParamsToSVG() {
     std::vector<Inkscape::LivePathEffect::Parameter *>::iterator p;
@@ -1579,14 +1817,23 @@ Effect::doEffect (SPCurve * curve)
 
 Geom::PathVector
 Effect::doEffect_path (Geom::PathVector const & path_in)
+{
+    return applyPwd2Effect(path_in, concatenate_before_pwd2,
+                           [this](Geom::Piecewise<Geom::D2<Geom::SBasis>> const &pwd2_in) { return doEffect_pwd2(pwd2_in); });
+}
+
+Geom::PathVector
+Effect::applyPwd2Effect(Geom::PathVector const &path_in, bool concatenate,
+                        std::function<Geom::Piecewise<Geom::D2<Geom::SBasis>>(
+                            Geom::Piecewise<Geom::D2<Geom::SBasis>> const &)> const &effect)
 {
     Geom::PathVector path_out;
 
-    if ( !concatenate_before_pwd2 ) {
+    if ( !concatenate ) {
         // default behavior
         for (const auto & i : path_in) {
             Geom::Piecewise<Geom::D2<Geom::SBasis> > pwd2_in = i.toPwSb();
-            Geom::Piecewise<Geom::D2<Geom::SBasis> > pwd2_out = doEffect_pwd2(pwd2_in);
+            Geom::Piecewise<Geom::D2<Geom::SBasis> > pwd2_out = effect(pwd2_in);
             Geom::PathVector path = Geom::path_from_piecewise( pwd2_out, LPE_CONVERSION_TOLERANCE);
             // add the output path vector to the already accumulated vector:
             for (const auto & j : path) {
@@ -1599,7 +1846,7 @@ Effect::doEffect_path (Geom::PathVector const & path_in)
         for (const auto & i : path_in) {
             pwd2_in.concat( i.toPwSb() );
         }
-        Geom::Piecewise<Geom::D2<Geom::SBasis> > pwd2_out = doEffect_pwd2(pwd2_in);
+        Geom::Piecewise<Geom::D2<Geom::SBasis> > pwd2_out = effect(pwd2_in);
         path_out = Geom::path_from_piecewise( pwd2_out, LPE_CONVERSION_TOLERANCE);
     }
 
@@ -1613,6 +1860,12 @@ Effect::doEffect_pwd2 (Geom::Piecewise<Geom::D2<Geom::SBasis> > const & pwd2_in)
     return pwd2_in;
 }
 
+std::function<Geom::PathVector(std::atomic<bool> const &cancelled)>
+Effect::prepareAsyncEffect(Geom::PathVector const & /*path_in*/)
+{
+    return nullptr;
+}
+
 void
 Effect::readallParameters(Inkscape::XML::Node const* repr)
 {
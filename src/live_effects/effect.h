@@ -8,11 +8,17 @@
  * Released under GNU GPL v2+, read the file 'COPYING' for more information.
  */
 
+#include <atomic>
+#include <functional>
+#include <memory>
+
 #include "effect-enum.h"
 #include "parameter/bool.h"
 #include "parameter/hidden.h"
 #include "ui/widget/registry.h"
+#include <2geom/affine.h>
 #include <2geom/forward.h>
+#include <2geom/pathvector.h>
 #include <glibmm/ustring.h>
 #include <gtkmm/eventbox.h>
 #include <gtkmm/expander.h>
@@ -106,6 +112,22 @@ public:
 
     virtual void doEffect (SPCurve * curve);
 
+    /*
+     * The result of the last run is kept together with everything it was computed from, so an
+     * unchanged stage of an effect stack is not run again when an effect before or after it
+     * changes. cachedResult() returns true and sets path_out if nothing changed since storeResult().
+     */
+    bool cachedResult(SPLPEItem const *lpeitem, Geom::PathVector const &path_in, Geom::PathVector &path_out);
+    void storeResult(SPLPEItem const *lpeitem, Geom::PathVector const &path_in, Geom::PathVector const &path_out);
+    void clearCachedResult() { result_cache.valid = false; }
+    /*
+     * With "/live_effects/async" set, effects that provide prepareAsyncEffect() are computed on a
+     * worker thread. startAsyncEffect() returns true with the previous result in path_out while
+     * the job runs; the item is updated again when it is done. A newer job supersedes the last,
+     * and all effects share one worker, so superseded jobs do not pile up.
+     */
+    bool startAsyncEffect(SPLPEItem const *lpeitem, Geom::PathVector const &path_in, Geom::PathVector &path_out);
+
     virtual Gtk::Widget * newWidget();
     virtual Gtk::Widget * defaultParamSet();
     /**
@@ -173,6 +195,16 @@ protected:
             doEffect_path (Geom::PathVector const & path_in);
     virtual Geom::Piecewise<Geom::D2<Geom::SBasis> >
             doEffect_pwd2 (Geom::Piecewise<Geom::D2<Geom::SBasis> > const & pwd2_in);
+    // the conversion doEffect_path() does around doEffect_pwd2(), for any pwd2 function
+    static Geom::PathVector
+            applyPwd2Effect(Geom::PathVector const &path_in, bool concatenate,
+                            std::function<Geom::Piecewise<Geom::D2<Geom::SBasis>>(
+                                Geom::Piecewise<Geom::D2<Geom::SBasis>> const &)> const &effect);
+    // Returns a job computing doEffect() for path_in from copies of everything it needs, without
+    // touching the effect or the document, or nothing if the effect only runs on the main thread.
+    // Called after doBeforeEffect(). The job may give up early once cancelled is set.
+    virtual std::function<Geom::PathVector(std::atomic<bool> const &cancelled)>
+            prepareAsyncEffect(Geom::PathVector const &path_in);
 
     void registerParameter(Parameter * param);
     Parameter * getNextOncanvasEditableParam();
@@ -192,6 +224,10 @@ protected:
     double current_zoom;
     std::vector<Geom::Point> selectedNodesPoints;
     Inkscape::UI::Widget::Registry wr;
+    // set this in derived effects whose result depends on nothing but the input path, the
+    // parameters, the item transform, the zoom and the selected nodes; not on the style, the
+    // bounding box with clip or mask, the document units or other objects
+    bool result_cacheable = false;
     
 private:
     LivePathEffectObject *lpeobj;
@@ -211,6 +247,31 @@ private:
 
     bool is_ready;
     bool defaultsopen;
+
+    struct ResultCache {
+        bool valid = false;
+        SPLPEItem const *item = nullptr;
+        Geom::Affine i2doc;
+        double zoom = 0;
+        std::vector<Geom::Point> selected_nodes;
+        Glib::ustring params;
+        Geom::PathVector path_in;
+        Geom::PathVector path_out;
+    };
+    struct AsyncJob {
+        Effect *effect = nullptr;
+        ResultCache entry;
+        std::function<Geom::PathVector(std::atomic<bool> const &cancelled)> work;
+        std::atomic<bool> cancelled{false};
+    };
+    class AsyncWorker;
+    bool getResultKey(SPLPEItem const *lpeitem, Glib::ustring &params) const;
+    bool makeResultKey(SPLPEItem const *lpeitem, Geom::PathVector const &path_in, ResultCache &entry) const;
+    static bool sameResultKey(ResultCache const &a, ResultCache const &b);
+    void finishAsyncEffect(std::shared_ptr<AsyncJob> const &job);
+    void cancelAsyncEffect();
+    ResultCache result_cache;
+    std::shared_ptr<AsyncJob> _async_job;
 };
 
 } //namespace LivePathEffect
@@ -27,6 +27,7 @@ namespace LivePathEffect {
 LPECircle3Pts::LPECircle3Pts(LivePathEffectObject *lpeobject) :
     Effect(lpeobject)
 {
+    result_cacheable = true;
 }
 
 LPECircle3Pts::~LPECircle3Pts()
@@ -31,6 +31,7 @@ LPECircleWithRadius::LPECircleWithRadius(LivePathEffectObject *lpeobject) :
     // initialise your parameters here:
     //radius(_("Float parameter"), _("just a real number like 1.4!"), "svgname", &wr, this, 50)
 {
+    result_cacheable = true;
     // register all your parameters here, so Inkscape knows which parameters this effect has:
     //registerParameter( dynamic_cast<Parameter *>(&radius) );
 }
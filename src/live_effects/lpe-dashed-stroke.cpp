@@ -24,6 +24,7 @@ LPEDashedStroke::LPEDashedStroke(LivePathEffectObject *lpeobject)
     , message(_("Note"), _("Important messages"), "message", &wr, this,
               _("Add <b>\"Fill Between Many LPE\"</b> to add fill."))
 {
+    result_cacheable = true;
     registerParameter(&numberdashes);
     registerParameter(&holefactor);
     registerParameter(&splitsegments);
@@ -25,6 +25,7 @@ LPEExtrude::LPEExtrude(LivePathEffectObject *lpeobject) :
     Effect(lpeobject),
     extrude_vector(_("Direction"), _("Defines the direction and magnitude of the extrusion"), "extrude_vector", &wr, this, Geom::Point(-10,10))
 {
+    result_cacheable = true;
     show_orig_path = true;
     concatenate_before_pwd2 = false;
 
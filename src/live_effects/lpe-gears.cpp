@@ -207,6 +207,7 @@ LPEGears::LPEGears(LivePathEffectObject *lpeobject) :
     phi(_("_Phi:"), _("Tooth pressure angle (typically 20-25 deg).  The ratio of teeth not in contact."), "phi", &wr, this, 5),
     min_radius(_("Min Radius:"), _("Minimum radius, low values can be slow"), "min_radius", &wr, this, 5.0)
 {
+    result_cacheable = true;
     /* Tooth pressure angle: The angle between the tooth profile and a perpendicular to the pitch
      * circle, usually at the point where the pitch circle meets the tooth profile. Standard angles
      * are 20 and 25 degrees. The pressure angle affects the force that tends to separate mating
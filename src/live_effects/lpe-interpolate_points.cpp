@@ -37,6 +37,7 @@ LPEInterpolatePoints::LPEInterpolatePoints(LivePathEffectObject *lpeobject)
           _("Determines which kind of interpolator will be used to interpolate between stroke width along the path"),
           "interpolator_type", InterpolatorTypeConverter, &wr, this, Geom::Interpolate::INTERP_CENTRIPETAL_CATMULLROM)
 {
+    result_cacheable = true;
     show_orig_path = false;
 
     registerParameter( &interpolator_type );
@@ -98,6 +98,7 @@ LPEPatternAlongPath::LPEPatternAlongPath(LivePathEffectObject *lpeobject) :
     fuse_tolerance(_("_Fuse nearby ends:"), _("Fuse ends closer than this number. 0 means don't fuse."),
         "fuse_tolerance", &wr, this, 0)
 {
+    result_cacheable = true;
     registerParameter(&pattern);
     registerParameter(&copytype);
     registerParameter(&prop_scale);
@@ -158,13 +159,62 @@ LPEPatternAlongPath::doBeforeEffect (SPLPEItem const* lpeitem)
     }
 }
 
+/// Copies of the parameter values, so that the pattern can be applied away from the main thread.
+struct LPEPatternAlongPath::Settings {
+    Geom::Piecewise<Geom::D2<Geom::SBasis> > pattern;
+    PAPCopyType type;
+    bool vertical_pattern;
+    double spacing;
+    double normal_offset;
+    double tang_offset;
+    bool prop_units;
+    bool scale_y_rel;
+    double prop_scale;
+    double fuse_tolerance;
+};
+
+LPEPatternAlongPath::Settings LPEPatternAlongPath::getSettings()
+{
+    Settings settings;
+    // Don't allow empty path parameter:
+    if (!pattern.get_pathvector().empty()) {
+        settings.pattern = pattern.get_pwd2() * pattern.get_relative_affine();
+    }
+    settings.type = copytype.get_value();
+    settings.vertical_pattern = vertical_pattern.get_value();
+    settings.spacing = spacing;
+    settings.normal_offset = normal_offset;
+    settings.tang_offset = tang_offset;
+    settings.prop_units = prop_units.get_value();
+    settings.scale_y_rel = scale_y_rel.get_value();
+    settings.prop_scale = prop_scale;
+    settings.fuse_tolerance = fuse_tolerance;
+    return settings;
+}
+
 Geom::Piecewise<Geom::D2<Geom::SBasis> >
 LPEPatternAlongPath::doEffect_pwd2 (Geom::Piecewise<Geom::D2<Geom::SBasis> > const & pwd2_in)
+{
+    return patternAlongPath(pwd2_in, getSettings(), nullptr);
+}
+
+std::function<Geom::PathVector(std::atomic<bool> const &cancelled)>
+LPEPatternAlongPath::prepareAsyncEffect(Geom::PathVector const &path_in)
+{
+    return [path_in, settings = getSettings(), concatenate = concatenate_before_pwd2](std::atomic<bool> const &cancelled) {
+        return applyPwd2Effect(path_in, concatenate, [&](Geom::Piecewise<Geom::D2<Geom::SBasis> > const &pwd2_in) {
+            return patternAlongPath(pwd2_in, settings, &cancelled);
+        });
+    };
+}
+
+Geom::Piecewise<Geom::D2<Geom::SBasis> >
+LPEPatternAlongPath::patternAlongPath(Geom::Piecewise<Geom::D2<Geom::SBasis> > const &pwd2_in,
+                                      Settings const &settings, std::atomic<bool> const *cancelled)
 {
     using namespace Geom;
 
-    // Don't allow empty path parameter:
-    if ( pattern.get_pathvector().empty() ) {
+    if (settings.pattern.empty()) {
         return pwd2_in;
     }
 
@@ -172,21 +222,20 @@ LPEPatternAlongPath::doEffect_pwd2 (Geom::Piecewise<Geom::D2<Geom::SBasis> > con
     Piecewise<D2<SBasis> > output;
     std::vector<Geom::Piecewise<Geom::D2<Geom::SBasis> > > pre_output;
 
-    PAPCopyType type = copytype.get_value();
-    Geom::Affine affine = pattern.get_relative_affine();
-    D2<Piecewise<SBasis> > patternd2 = make_cuts_independent(pattern.get_pwd2() * affine);
-    Piecewise<SBasis> x0 = vertical_pattern.get_value() ? Piecewise<SBasis>(patternd2[1]) : Piecewise<SBasis>(patternd2[0]);
-    Piecewise<SBasis> y0 = vertical_pattern.get_value() ? Piecewise<SBasis>(patternd2[0]) : Piecewise<SBasis>(patternd2[1]);
+    PAPCopyType type = settings.type;
+    D2<Piecewise<SBasis> > patternd2 = make_cuts_independent(settings.pattern);
+    Piecewise<SBasis> x0 = settings.vertical_pattern ? Piecewise<SBasis>(patternd2[1]) : Piecewise<SBasis>(patternd2[0]);
+    Piecewise<SBasis> y0 = settings.vertical_pattern ? Piecewise<SBasis>(patternd2[0]) : Piecewise<SBasis>(patternd2[1]);
     OptInterval pattBndsX = bounds_exact(x0);
     OptInterval pattBndsY = bounds_exact(y0);
     if (pattBndsX && pattBndsY) {
         x0 -= pattBndsX->min();
         y0 -= pattBndsY->middle();
 
-        double xspace  = spacing;
-        double noffset = normal_offset;
-        double toffset = tang_offset;
-        if (prop_units.get_value()){
+        double xspace  = settings.spacing;
+        double noffset = settings.normal_offset;
+        double toffset = settings.tang_offset;
+        if (settings.prop_units){
             xspace  *= pattBndsX->extent();
             noffset *= pattBndsY->extent();
             toffset *= pattBndsX->extent();
@@ -209,6 +258,9 @@ LPEPatternAlongPath::doEffect_pwd2 (Geom::Piecewise<Geom::D2<Geom::SBasis> > con
         paths_in = split_at_discontinuities(pwd2_in);
 
         for (auto path_i : paths_in){
+            if (cancelled && *cancelled) {
+                return pwd2_in;
+            }
             Piecewise<SBasis> x = x0;
             Piecewise<SBasis> y = y0;
             Piecewise<D2<SBasis> > uskeleton = arc_length_parametrization(path_i,2, 0.1);
@@ -259,16 +311,19 @@ LPEPatternAlongPath::doEffect_pwd2 (Geom::Piecewise<Geom::D2<Geom::SBasis> > con
             double pattWidth = pattBndsX->extent() * scaling;
             
             x *= scaling;
-            if ( scale_y_rel.get_value() ) {
-                y *= prop_scale * scaling;
+            if ( settings.scale_y_rel ) {
+                y *= settings.prop_scale * scaling;
             } else {
-                y *= prop_scale;
+                y *= settings.prop_scale;
             }
             x += toffset;
 
             double offs = 0;
             for (int i=0; i<nbCopies; i++){
-                if (fuse_tolerance > 0){        
+                if (cancelled && *cancelled) {
+                    return pwd2_in;
+                }
+                if (settings.fuse_tolerance > 0){        
                     Geom::Piecewise<Geom::D2<Geom::SBasis> > output_piece = compose(uskeleton,x+offs)+y*compose(n,x+offs);
                     std::vector<Geom::Piecewise<Geom::D2<Geom::SBasis> > > splited_output_piece = split_at_discontinuities(output_piece);
                     pre_output.insert(pre_output.end(), splited_output_piece.begin(), splited_output_piece.end() );
@@ -278,8 +333,11 @@ LPEPatternAlongPath::doEffect_pwd2 (Geom::Piecewise<Geom::D2<Geom::SBasis> > con
                 offs+=pattWidth;
             }
         }
-        if (fuse_tolerance > 0){
-            pre_output = fuse_nearby_ends(pre_output, fuse_tolerance);
+        if (cancelled && *cancelled) {
+            return pwd2_in;
+        }
+        if (settings.fuse_tolerance > 0){
+            pre_output = fuse_nearby_ends(pre_output, settings.fuse_tolerance);
             for (const auto & i : pre_output){
                 output.concat(i);
             }
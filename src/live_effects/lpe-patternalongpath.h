@@ -43,6 +43,8 @@ public:
 
     void doBeforeEffect (SPLPEItem const* lpeitem) override;
     Geom::Piecewise<Geom::D2<Geom::SBasis> > doEffect_pwd2 (Geom::Piecewise<Geom::D2<Geom::SBasis> > const & pwd2_in) override;
+    std::function<Geom::PathVector(std::atomic<bool> const &cancelled)>
+    prepareAsyncEffect(Geom::PathVector const &path_in) override;
     bool doOnOpen(SPLPEItem const *lpeitem) override;
     void transform_multiply(Geom::Affine const &postmul, bool set) override;
     void addCanvasIndicators(SPLPEItem const */*lpeitem*/, std::vector<Geom::PathVector> &hp_vec) override;
@@ -68,6 +70,11 @@ private:
     KnotHolderEntity * _knot_entity;
     Geom::PathVector helper_path;
     void on_pattern_pasted();
+    struct Settings;
+    Settings getSettings();
+    static Geom::Piecewise<Geom::D2<Geom::SBasis> > patternAlongPath(Geom::Piecewise<Geom::D2<Geom::SBasis> > const &pwd2_in,
+                                                                     Settings const &settings,
+                                                                     std::atomic<bool> const *cancelled);
 
     LPEPatternAlongPath(const LPEPatternAlongPath&);
     LPEPatternAlongPath& operator=(const LPEPatternAlongPath&);
@@ -75,6 +75,7 @@ LPEPts2Ellipse::LPEPts2Ellipse(LivePathEffectObject *lpeobject)
     , rot_axes(_("Axes rotation"), _("Axes rotation angle [deg]"), "rot_axes", &wr, this, 0)
     , draw_ori_path(_("Source _path"), _("Show the original source path"), "draw_ori_path", &wr, this, false)
 {
+    result_cacheable = true;
     registerParameter(&method);
     registerParameter(&gen_arc);
     registerParameter(&other_arc);
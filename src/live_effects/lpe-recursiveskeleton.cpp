@@ -25,6 +25,7 @@ LPERecursiveSkeleton::LPERecursiveSkeleton(LivePathEffectObject *lpeobject) :
     Effect(lpeobject),
     iterations(_("Iterations:"), _("recursivity"), "iterations", &wr, this, 2)
 {
+    result_cacheable = true;
     show_orig_path = true;
     concatenate_before_pwd2 = true;
     iterations.param_make_integer(true);
@@ -32,6 +32,7 @@ LPESkeleton::LPESkeleton(LivePathEffectObject *lpeobject) :
     // initialise your parameters here:
     number(_("Float parameter"), _("just a real number like 1.4!"), "svgname", &wr, this, 1.2)
 {
+    result_cacheable = true;
     /* uncomment the following line to have the original path displayed while the item is selected */
     //show_orig_path = true;
     /* uncomment the following line to enable display of the effect-specific on-canvas handles (knotholder entities) */
@@ -24,6 +24,7 @@ namespace LivePathEffect {
 LPESpiro::LPESpiro(LivePathEffectObject *lpeobject) :
     Effect(lpeobject)
 {
+    result_cacheable = true;
 }
 
 LPESpiro::~LPESpiro()
@@ -17,6 +17,7 @@
 #include <2geom/line.h>
 #include <2geom/path-intersection.h>
 #include <2geom/path-sink.h>
+#include <algorithm>
 #include <memory>
 
 #include "desktop.h"
@@ -53,6 +54,7 @@ Inkscape::ObjectSnapper::ObjectSnapper(SnapManager *sm, Geom::Coord const d)
 
 Inkscape::ObjectSnapper::~ObjectSnapper()
 {
+    _clearCachedPoints();
     _points_to_snap_to->clear();
     _clear_paths();
 }
@@ -69,6 +71,16 @@ bool Inkscape::ObjectSnapper::getSnapperAlwaysSnap() const
     return _snapmanager->snapprefs.getObjectTolerance() == 10000; //TODO: Replace this threshold of 10000 by a constant; see also tolerance-slider.cpp
 }
 
+void Inkscape::ObjectSnapper::_clearCachedPoints() const
+{
+    for (auto &entry : _cached_points) {
+        entry.second.modified_connection.disconnect();
+        entry.second.release_connection.disconnect();
+    }
+    _cached_points.clear();
+    _collected_points_valid = false;
+}
+
 void Inkscape::ObjectSnapper::_collectNodes(SnapSourceType const &t,
                                             bool const &first_point) const
 {
@@ -76,8 +88,6 @@ void Inkscape::ObjectSnapper::_collectNodes(SnapSourceType const &t,
     // e.g. when translating an item using the selector tool, then we will only do this for the
     // first point and store the collection for later use. This significantly improves the performance
     if (first_point) {
-        _points_to_snap_to->clear();
-
          // Determine the type of bounding box we should snap to
         SPItem::BBoxType bbox_type = SPItem::GEOMETRIC_BBOX;
 
@@ -97,6 +107,81 @@ void Inkscape::ObjectSnapper::_collectNodes(SnapSourceType const &t,
                 SPItem::VISUAL_BBOX : SPItem::GEOMETRIC_BBOX;
         }
 
+        // The snap points of the items are kept from one drag to the next, as long as the items
+        // are not modified and the snap settings don't change. During a drag the candidates
+        // don't change either, so the collection and its index can be reused as a whole.
+        SPDesktop const *dt = _snapmanager->getDesktop();
+        CollectContext context{_snapmanager->snapprefs, p_is_a_node, p_is_a_bbox, p_is_other, bbox_type,
+                               dt ? dt->doc2dt() : Geom::identity(), _snapmanager->getRotationCenterSource()};
+        if (!_collect_context ||
+            !_collect_context->snapprefs.hasSameTargets(context.snapprefs) ||
+            _collect_context->p_is_a_node != context.p_is_a_node ||
+            _collect_context->p_is_a_bbox != context.p_is_a_bbox ||
+            _collect_context->p_is_other != context.p_is_other ||
+            _collect_context->bbox_type != context.bbox_type ||
+            _collect_context->doc2dt != context.doc2dt ||
+            _collect_context->rotation_center_source != context.rotation_center_source) {
+            _clearCachedPoints();
+            _collect_context = std::make_unique<CollectContext>(std::move(context));
+        }
+
+        auto const &candidates = *_snapmanager->_obj_snapper_candidates;
+        bool const same_candidates = std::equal(candidates.begin(), candidates.end(),
+                                                _collected_candidates.begin(), _collected_candidates.end(),
+                                                [] (SnapCandidateItem const &a, SnapCandidateItem const &b) {
+                                                    return a.item == b.item && a.clip_or_mask == b.clip_or_mask &&
+                                                           a.additional_affine == b.additional_affine;
+                                                });
+
+        if (!_collected_points_valid || !same_candidates) {
+            _points_to_snap_to->clear();
+
+            for (const auto & _candidate : candidates) {
+                SPItem *root_item = _candidate.item;
+
+                SPUse *use = dynamic_cast<SPUse *>(_candidate.item);
+                if (use) {
+                    root_item = use->root();
+                }
+                g_return_if_fail(root_item);
+
+                auto const key = std::make_pair(static_cast<SPItem const *>(root_item), _candidate.clip_or_mask);
+                auto cached = _cached_points.find(key);
+                if (cached == _cached_points.end()) {
+                    cached = _cached_points.emplace(key, CachedSnapPoints()).first;
+                    _collectItemNodes(_candidate, root_item, bbox_type, p_is_a_node, p_is_a_bbox, p_is_other, cached->second.points);
+
+                    auto forget = [this, key] (SPObject *) {
+                        auto it = _cached_points.find(key);
+                        if (it != _cached_points.end()) {
+                            it->second.modified_connection.disconnect();
+                            it->second.release_connection.disconnect();
+                            _cached_points.erase(it);
+                        }
+                        _collected_points_valid = false;
+                    };
+                    cached->second.modified_connection = root_item->connectModified([forget] (SPObject *object, unsigned) { forget(object); });
+                    cached->second.release_connection = root_item->connectRelease(forget);
+                }
+                _points_to_snap_to->insert(_points_to_snap_to->end(), cached->second.points.begin(), cached->second.points.end());
+            }
+
+            std::vector<Util::RectTree<std::size_t>::Entry> entries;
+            entries.reserve(_points_to_snap_to->size());
+            for (std::size_t k = 0; k < _points_to_snap_to->size(); k++) {
+                auto const &pt = (*_points_to_snap_to)[k].getPoint();
+                entries.emplace_back(Geom::Rect(pt, pt), k);
+            }
+            _item_points_index.build(std::move(entries));
+
+            _num_item_points = _points_to_snap_to->size();
+            _collected_candidates = candidates;
+            _collected_points_valid = true;
+        }
+
+        // The pages are few and cheap to look at, so their points are collected every time, after those of the items
+        _points_to_snap_to->erase(_points_to_snap_to->begin() + _num_item_points, _points_to_snap_to->end());
+
         // Consider the page border for snapping to
         if (_snapmanager->snapprefs.isTargetSnappable(SNAPTARGET_PAGE_CORNER)) {
             if (auto document = _snapmanager->getDocument()) {
@@ -116,79 +201,77 @@ void Inkscape::ObjectSnapper::_collectNodes(SnapSourceType const &t,
                     SNAPSOURCE_UNDEFINED, SNAPTARGET_UNDEFINED);
             }
         }
+    }
+}
 
-        for (const auto & _candidate : *_snapmanager->_obj_snapper_candidates) {
-            //Geom::Affine i2doc(Geom::identity());
-            SPItem *root_item = _candidate.item;
-
-            SPUse *use = dynamic_cast<SPUse *>(_candidate.item);
-            if (use) {
-                root_item = use->root();
-            }
-            g_return_if_fail(root_item);
-
-            //Collect all nodes so we can snap to them
-            if (p_is_a_node || p_is_other || (p_is_a_bbox && !_snapmanager->snapprefs.getStrictSnapping())) {
-                // Note: there are two ways in which intersections are considered:
-                // Method 1: Intersections are calculated for each shape individually, for both the
-                //           snap source and snap target (see sp_shape_snappoints)
-                // Method 2: Intersections are calculated for each curve or line that we've snapped to, i.e. only for
-                //           the target (see the intersect() method in the SnappedCurve and SnappedLine classes)
-                // Some differences:
-                // - Method 1 doesn't find intersections within a set of multiple objects
-                // - Method 2 only works for targets
-                // When considering intersections as snap targets:
-                // - Method 1 only works when snapping to nodes, whereas
-                // - Method 2 only works when snapping to paths
-                // - There will be performance differences too!
-                // If both methods are being used simultaneously, then this might lead to duplicate targets!
-
-                // Well, here we will be looking for snap TARGETS. Both methods can therefore be used.
-                // When snapping to paths, we will get a collection of snapped lines and snapped curves. findBestSnap() will
-                // go hunting for intersections (but only when asked to in the prefs of course). In that case we can just
-                // temporarily block the intersections in sp_item_snappoints, we don't need duplicates. If we're not snapping to
-                // paths though but only to item nodes then we should still look for the intersections in sp_item_snappoints()
-                bool old_pref = _snapmanager->snapprefs.isTargetSnappable(SNAPTARGET_PATH_INTERSECTION);
-                if (_snapmanager->snapprefs.isTargetSnappable(SNAPTARGET_PATH)) {
-                    // So if we snap to paths, then findBestSnap will find the intersections
-                    // and therefore we temporarily disable SNAPTARGET_PATH_INTERSECTION, which will
-                    // avoid root_item->getSnappoints() below from returning intersections
-                    _snapmanager->snapprefs.setTargetSnappable(SNAPTARGET_PATH_INTERSECTION, false);
-                }
+void Inkscape::ObjectSnapper::_collectItemNodes(SnapCandidateItem const &candidate,
+                                                SPItem *root_item,
+                                                int bbox_type,
+                                                bool p_is_a_node,
+                                                bool p_is_a_bbox,
+                                                bool p_is_other,
+                                                std::vector<SnapCandidatePoint> &points) const
+{
+    //Collect all nodes so we can snap to them
+    if (p_is_a_node || p_is_other || (p_is_a_bbox && !_snapmanager->snapprefs.getStrictSnapping())) {
+        // Note: there are two ways in which intersections are considered:
+        // Method 1: Intersections are calculated for each shape individually, for both the
+        //           snap source and snap target (see sp_shape_snappoints)
+        // Method 2: Intersections are calculated for each curve or line that we've snapped to, i.e. only for
+        //           the target (see the intersect() method in the SnappedCurve and SnappedLine classes)
+        // Some differences:
+        // - Method 1 doesn't find intersections within a set of multiple objects
+        // - Method 2 only works for targets
+        // When considering intersections as snap targets:
+        // - Method 1 only works when snapping to nodes, whereas
+        // - Method 2 only works when snapping to paths
+        // - There will be performance differences too!
+        // If both methods are being used simultaneously, then this might lead to duplicate targets!
+
+        // Well, here we will be looking for snap TARGETS. Both methods can therefore be used.
+        // When snapping to paths, we will get a collection of snapped lines and snapped curves. findBestSnap() will
+        // go hunting for intersections (but only when asked to in the prefs of course). In that case we can just
+        // temporarily block the intersections in sp_item_snappoints, we don't need duplicates. If we're not snapping to
+        // paths though but only to item nodes then we should still look for the intersections in sp_item_snappoints()
+        bool old_pref = _snapmanager->snapprefs.isTargetSnappable(SNAPTARGET_PATH_INTERSECTION);
+        if (_snapmanager->snapprefs.isTargetSnappable(SNAPTARGET_PATH)) {
+            // So if we snap to paths, then findBestSnap will find the intersections
+            // and therefore we temporarily disable SNAPTARGET_PATH_INTERSECTION, which will
+            // avoid root_item->getSnappoints() below from returning intersections
+            _snapmanager->snapprefs.setTargetSnappable(SNAPTARGET_PATH_INTERSECTION, false);
+        }
 
-                // We should not snap a transformation center to any of the centers of the items in the
-                // current selection (see the comment in SelTrans::centerRequest())
-                bool old_pref2 = _snapmanager->snapprefs.isTargetSnappable(SNAPTARGET_ROTATION_CENTER);
-                if (old_pref2) {
-                    std::vector<SPItem*> rotationSource=_snapmanager->getRotationCenterSource();
-                    for (auto itemlist : rotationSource) {
-                        if (_candidate.item == itemlist) {
-                            // don't snap to this item's rotation center
-                            _snapmanager->snapprefs.setTargetSnappable(SNAPTARGET_ROTATION_CENTER, false);
-                            break;
-                        }
-                    }
+        // We should not snap a transformation center to any of the centers of the items in the
+        // current selection (see the comment in SelTrans::centerRequest())
+        bool old_pref2 = _snapmanager->snapprefs.isTargetSnappable(SNAPTARGET_ROTATION_CENTER);
+        if (old_pref2) {
+            std::vector<SPItem*> rotationSource=_snapmanager->getRotationCenterSource();
+            for (auto itemlist : rotationSource) {
+                if (candidate.item == itemlist) {
+                    // don't snap to this item's rotation center
+                    _snapmanager->snapprefs.setTargetSnappable(SNAPTARGET_ROTATION_CENTER, false);
+                    break;
                 }
+            }
+        }
 
-                root_item->getSnappoints(*_points_to_snap_to, &_snapmanager->snapprefs);
+        root_item->getSnappoints(points, &_snapmanager->snapprefs);
 
-                // restore the original snap preferences
-                _snapmanager->snapprefs.setTargetSnappable(SNAPTARGET_PATH_INTERSECTION, old_pref);
-                _snapmanager->snapprefs.setTargetSnappable(SNAPTARGET_ROTATION_CENTER, old_pref2);
-            }
+        // restore the original snap preferences
+        _snapmanager->snapprefs.setTargetSnappable(SNAPTARGET_PATH_INTERSECTION, old_pref);
+        _snapmanager->snapprefs.setTargetSnappable(SNAPTARGET_ROTATION_CENTER, old_pref2);
+    }
 
-            //Collect the bounding box's corners so we can snap to them
-            if (p_is_a_bbox || (!_snapmanager->snapprefs.getStrictSnapping() && p_is_a_node) || p_is_other) {
-                // Discard the bbox of a clipped path / mask, because we don't want to snap to both the bbox
-                // of the item AND the bbox of the clipping path at the same time
-                if (!_candidate.clip_or_mask) {
-                    Geom::OptRect b = root_item->desktopBounds(bbox_type);
-                    getBBoxPoints(b, _points_to_snap_to.get(), true,
-                            _snapmanager->snapprefs.isTargetSnappable(SNAPTARGET_BBOX_CORNER),
-                            _snapmanager->snapprefs.isTargetSnappable(SNAPTARGET_BBOX_EDGE_MIDPOINT),
-                            _snapmanager->snapprefs.isTargetSnappable(SNAPTARGET_BBOX_MIDPOINT));
-                }
-            }
+    //Collect the bounding box's corners so we can snap to them
+    if (p_is_a_bbox || (!_snapmanager->snapprefs.getStrictSnapping() && p_is_a_node) || p_is_other) {
+        // Discard the bbox of a clipped path / mask, because we don't want to snap to both the bbox
+        // of the item AND the bbox of the clipping path at the same time
+        if (!candidate.clip_or_mask) {
+            Geom::OptRect b = root_item->desktopBounds(static_cast<SPItem::BBoxType>(bbox_type));
+            getBBoxPoints(b, &points, true,
+                    _snapmanager->snapprefs.isTargetSnappable(SNAPTARGET_BBOX_CORNER),
+                    _snapmanager->snapprefs.isTargetSnappable(SNAPTARGET_BBOX_EDGE_MIDPOINT),
+                    _snapmanager->snapprefs.isTargetSnappable(SNAPTARGET_BBOX_MIDPOINT));
         }
     }
 }
@@ -199,20 +282,15 @@ void Inkscape::ObjectSnapper::_snapNodes(IntermSnapResults &isr,
                                          SnapConstraint const &c,
                                          Geom::Point const &p_proj_on_constraint) const
 {
-    // Iterate through all nodes, find out which one is the closest to p, and snap to it!
+    // Find out which of the nodes is the closest to p, and snap to it!
 
     _collectNodes(p.getSourceType(), p.getSourceNum() <= 0);
 
-    if (unselected_nodes != nullptr && unselected_nodes->size() > 0) {
-        g_assert(_points_to_snap_to != nullptr);
-        _points_to_snap_to->insert(_points_to_snap_to->end(), unselected_nodes->begin(), unselected_nodes->end());
-    }
-
     SnappedPoint s;
     bool success = false;
     bool strict_snapping = _snapmanager->snapprefs.getStrictSnapping();
 
-    for (const auto & k : *_points_to_snap_to) {
+    auto consider = [&] (SnapCandidatePoint const &k) {
         if (_allowSourceToSnapToTarget(p.getSourceType(), k.getTargetType(), strict_snapping)) {
             Geom::Point target_pt = k.getPoint();
             Geom::Coord dist = Geom::L2(target_pt - p.getPoint()); // Default: free (unconstrained) snapping
@@ -222,7 +300,7 @@ void Inkscape::ObjectSnapper::_snapNodes(IntermSnapResults &isr,
                 if (Geom::L2(target_pt - c.projection(target_pt)) > 1e-9) {
                     // The distance from the target point to its projection on the constraint
                     // is too large, so this point is not on the constraint. Skip it!
-                    continue;
+                    return;
                 }
                 dist = Geom::L2(target_pt - p_proj_on_constraint);
             }
@@ -232,6 +310,21 @@ void Inkscape::ObjectSnapper::_snapNodes(IntermSnapResults &isr,
                 success = true;
             }
         }
+    };
+
+    // The page points, then only those points of the items that are within range, then the
+    // unselected nodes; ties go to the first point found, as they always have.
+    for (auto k = _num_item_points; k < _points_to_snap_to->size(); k++) {
+        consider((*_points_to_snap_to)[k]);
+    }
+    Geom::Point const centre = c.isUndefined() ? p.getPoint() : p_proj_on_constraint;
+    for (auto k : _item_points_index.query(centre, getSnapperTolerance())) {
+        consider((*_points_to_snap_to)[k]);
+    }
+    if (unselected_nodes != nullptr) {
+        for (auto const &k : *unselected_nodes) {
+            consider(k);
+        }
     }
 
     if (success) {
@@ -416,6 +509,16 @@ void Inkscape::ObjectSnapper::_snapPaths(IntermSnapResults &isr,
             //if true then this pathvector it_pv is currently being edited in the node tool
 
             for (auto &it_pv : it_p.path_vector) {
+                // Finding the nearest points is expensive, so first rule out the paths that are
+                // out of range altogether
+                if (auto bounds = it_pv.boundsFast()) {
+                    bounds->expandBy(getSnapperTolerance());
+                    if (!bounds->contains(p_doc)) {
+                        num_path++;
+                        continue;
+                    }
+                }
+
                 // Find a nearest point for each curve within this path
                 // n curves will return n time values with 0 <= t <= 1
                 std::vector<double> anp = it_pv.nearestTimePerCurve(p_doc);
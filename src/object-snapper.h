@@ -11,11 +11,16 @@
  * Released under GNU GPL v2+, read the file 'COPYING' for more information.
  */
 
+#include <map>
 #include <memory>
+#include <sigc++/connection.h>
 #include "snapper.h"
 #include "snap-candidate.h"
+#include "snap-preferences.h"
+#include "util/rect-tree.h"
 
 class SPDesktop;
+class SPItem;
 class SPNamedView;
 class SPObject;
 class SPPath;
@@ -63,6 +68,38 @@ private:
     std::unique_ptr<std::vector<SnapCandidatePoint>> _points_to_snap_to;
     std::unique_ptr<std::vector<SnapCandidatePath >> _paths_to_snap_to;
 
+    /**
+     * The snap points of a candidate item, kept until the item is modified or released so that
+     * they don't have to be recollected for every snap during a drag.
+     */
+    struct CachedSnapPoints
+    {
+        std::vector<SnapCandidatePoint> points;
+        sigc::connection modified_connection;
+        sigc::connection release_connection;
+    };
+
+    /// Everything besides the items themselves that the collected snap points depend on.
+    struct CollectContext
+    {
+        SnapPreferences snapprefs;
+        bool p_is_a_node;
+        bool p_is_a_bbox;
+        bool p_is_other;
+        int bbox_type;
+        Geom::Affine doc2dt;
+        std::vector<SPItem *> rotation_center_source;
+    };
+
+    mutable std::map<std::pair<SPItem const *, bool>, CachedSnapPoints> _cached_points; ///< Keyed by item and clip_or_mask.
+    mutable std::unique_ptr<CollectContext> _collect_context;   ///< The context of _cached_points.
+    mutable std::vector<SnapCandidateItem> _collected_candidates; ///< The candidates in _points_to_snap_to.
+    mutable bool _collected_points_valid = false;
+    mutable std::size_t _num_item_points = 0; ///< The points of the items come first in _points_to_snap_to, the pages' last.
+    mutable Util::RectTree<std::size_t> _item_points_index; ///< Spatial index of the points of the items.
+
+    void _clearCachedPoints() const;
+
     void _snapNodes(IntermSnapResults &isr,
                       Inkscape::SnapCandidatePoint const &p, // in desktop coordinates
                       std::vector<SnapCandidatePoint> *unselected_nodes,
@@ -76,6 +113,14 @@ private:
     void _collectNodes(Inkscape::SnapSourceType const &t,
                   bool const &first_point) const;
 
+    void _collectItemNodes(SnapCandidateItem const &candidate,
+                           SPItem *root_item,
+                           int bbox_type,
+                           bool p_is_a_node,
+                           bool p_is_a_bbox,
+                           bool p_is_other,
+                           std::vector<SnapCandidatePoint> &points) const;
+
     void _snapPaths(IntermSnapResults &isr,
                       Inkscape::SnapCandidatePoint const &p, // in desktop coordinates
                       std::vector<Inkscape::SnapCandidatePoint> *unselected_nodes, // in desktop coordinates
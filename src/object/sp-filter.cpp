@@ -18,6 +18,7 @@
 
 #include <cstring>
 #include <map>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -28,8 +29,10 @@
 #include "bad-uri-exception.h"
 #include "display/nr-filter.h"
 #include "document.h"
+#include "filters/image.h"
 #include "filters/sp-filter-primitive.h"
 #include "sp-filter-reference.h"
+#include "style.h"
 #include "uri.h"
 #include "xml/repr.h"
 
@@ -482,6 +485,36 @@ void SPFilter::remove_child(Inkscape::XML::Node *child)
     this->requestModified(SP_OBJECT_MODIFIED_FLAG);
 }
 
+/**
+ * Appends a string to the signature, prefixed by its length so that signatures built from
+ * different strings never coincide.
+ */
+static void append_signature(std::string &signature, char const *str)
+{
+    str = str ? str : "";
+    signature += std::to_string(std::strlen(str));
+    signature += ':';
+    signature += str;
+}
+
+/**
+ * Appends the element, its attributes and its descendants to the signature.
+ */
+static void append_signature(std::string &signature, Inkscape::XML::Node const *repr)
+{
+    append_signature(signature, repr->name());
+    append_signature(signature, repr->content());
+    for (auto const &attr : repr->attributeList()) {
+        append_signature(signature, g_quark_to_string(attr.key));
+        append_signature(signature, attr.value.pointer());
+    }
+    signature += '{';
+    for (auto child = repr->firstChild(); child; child = child->next()) {
+        append_signature(signature, child);
+    }
+    signature += '}';
+}
+
 void SPFilter::build_renderer(Inkscape::Filters::Filter *nr_filter) const
 {
     g_assert(nr_filter != nullptr);
@@ -501,12 +534,33 @@ void SPFilter::build_renderer(Inkscape::Filters::Filter *nr_filter) const
         }
     }
 
+    // The values used above, followed by the primitives with their computed style. The results of
+    // feImage depend on the referenced image as well, so they are never reused.
+    std::string signature;
+    append_signature(signature, (std::to_string(this->filterUnits) + ' ' + std::to_string(this->primitiveUnits)).c_str());
+    for (auto length : {&this->x, &this->y, &this->width, &this->height}) {
+        if (length->_set) {
+            append_signature(signature, (length->write() + ' ' + std::to_string(length->computed)).c_str());
+        } else {
+            append_signature(signature, "");
+        }
+    }
+    append_signature(signature, this->filterRes.getValueString().c_str());
+    bool reusable = true;
+
     nr_filter->clear_primitives();
     for (auto &primitive_obj : this->children) {
         if (SP_IS_FILTER_PRIMITIVE(&primitive_obj)) {
             SPFilterPrimitive *primitive = SP_FILTER_PRIMITIVE(&primitive_obj);
             g_assert(primitive != nullptr);
 
+            if (SP_IS_FEIMAGE(primitive)) {
+                reusable = false;
+            } else if (reusable) {
+                append_signature(signature, primitive->getRepr());
+                append_signature(signature, primitive->style->write(SP_STYLE_FLAG_ALWAYS).c_str());
+            }
+
             //if (((SPFilterPrimitiveClass*) G_OBJECT_GET_CLASS(primitive))->build_renderer) {
             //    ((SPFilterPrimitiveClass *) G_OBJECT_GET_CLASS(primitive))->build_renderer(primitive,
             //    nr_filter);
@@ -516,6 +570,7 @@ void SPFilter::build_renderer(Inkscape::Filters::Filter *nr_filter) const
             primitive->build_renderer(nr_filter);
         }
     }
+    nr_filter->set_signature(reusable ? std::move(signature) : std::string());
 }
 
 int SPFilter::primitive_count() const
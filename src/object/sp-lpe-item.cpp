@@ -279,8 +279,23 @@ bool SPLPEItem::performOnePathEffect(SPCurve *curve, SPShape *current, Inkscape:
                 current->bbox_geom_cache_is_valid = false;
             }
             SPGroup *group = dynamic_cast<SPGroup *>(this);
+            Geom::PathVector path_in;
             if (!group && !is_clip_or_mask) {
-                lpe->doBeforeEffect_impl(this);
+                // Unchanged since the last run, or computed on a worker thread showing the last
+                // result meanwhile: skip the effect, later ones still run on its output
+                Geom::PathVector result;
+                path_in = lpe->pathvector_before_effect;
+                bool skip = lpe->cachedResult(this, path_in, result);
+                if (!skip) {
+                    lpe->doBeforeEffect_impl(this);
+                    skip = lpe->startAsyncEffect(this, path_in, result);
+                }
+                if (skip) {
+                    curve->set_pathvector(result);
+                    current->setCurveInsync(curve);
+                    lpe->pathvector_after_effect = result;
+                    return true;
+                }
             }
 
             try {
@@ -294,6 +309,7 @@ bool SPLPEItem::performOnePathEffect(SPCurve *curve, SPShape *current, Inkscape:
                     SP_ACTIVE_DESKTOP->messageStack()->flash( Inkscape::WARNING_MESSAGE,
                                     _("An exception occurred during execution of the Path Effect.") );
                 }
+                lpe->clearCachedResult();
                 lpe->doOnException(this);
                 return false;
             }
@@ -305,6 +321,9 @@ bool SPLPEItem::performOnePathEffect(SPCurve *curve, SPShape *current, Inkscape:
                     lpe->pathvector_after_effect = curve->get_pathvector();
                 }
                 lpe->doAfterEffect_impl(this, curve);
+                if (curve && !is_clip_or_mask && !lpe->has_exception) {
+                    lpe->storeResult(this, path_in, curve->get_pathvector());
+                }
             }
             // we need this on slice LPE to calculate effects correctly
             if (dynamic_cast<Inkscape::LivePathEffect::LPESlice *>(lpe)) { // we are on 1 or up
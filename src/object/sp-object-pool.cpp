@@ -0,0 +1,173 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Pooled storage for the SPObjects of a document
+ *//*
+ * Authors: see git history
+ *
+ * Copyright (C) 2022 Authors
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include "sp-object-pool.h"
+
+#include <algorithm>
+#include <new>
+
+#include "debug/heap.h"
+
+namespace {
+
+/// Put before each object, to find the pool it came from.
+struct alignas(alignof(std::max_align_t)) Header
+{
+    SPObjectPool *pool;
+    std::size_t size;
+};
+
+SPObjectPool *current_pool = nullptr;
+
+/// All pools, which have not been deleted yet.
+std::vector<SPObjectPool const *> &pools()
+{
+    static std::vector<SPObjectPool const *> pools;
+    return pools;
+}
+
+/// Statistics of all pools for the Memory dialog.
+class PoolHeap : public Inkscape::Debug::Heap
+{
+public:
+    int features() const override { return SIZE_AVAILABLE | USED_AVAILABLE | SUBALLOCATED; }
+    char const *name() const override { return "SPObject pools"; }
+    Stats stats() const override
+    {
+        Stats stats{0, 0};
+        for (auto pool : pools()) {
+            stats.size += pool->reserved();
+            stats.bytes_used += pool->used();
+        }
+        return stats;
+    }
+    void force_collect() override {}
+};
+
+} // namespace
+
+SPObjectPool::SPObjectPool()
+{
+    static bool registered = false;
+    if (!registered) {
+        static PoolHeap heap;
+        Inkscape::Debug::register_extra_heap(heap);
+        registered = true;
+    }
+    pools().push_back(this);
+}
+
+SPObjectPool::~SPObjectPool()
+{
+    for (auto block : _blocks) {
+        ::operator delete(block);
+    }
+    auto &all = pools();
+    all.erase(std::find(all.begin(), all.end(), this));
+}
+
+SPObjectPool::Scope::Scope(SPObjectPool *pool)
+    : _previous(current_pool)
+{
+    current_pool = pool;
+}
+
+SPObjectPool::Scope::~Scope()
+{
+    current_pool = _previous;
+}
+
+void *SPObjectPool::allocate(std::size_t size)
+{
+    size = (size + sizeof(Header) + GRANULE - 1) / GRANULE * GRANULE;
+    auto pool = current_pool;
+    void *p = pool ? pool->_allocate(size) : ::operator new(size);
+    return new (p) Header{pool, size} + 1;
+}
+
+void SPObjectPool::deallocate(void *p)
+{
+    auto header = static_cast<Header *>(p) - 1;
+    auto const pool = header->pool;
+    auto const size = header->size;
+    if (pool) {
+        pool->_deallocate(header, size);
+    } else {
+        ::operator delete(header);
+    }
+}
+
+void SPObjectPool::release()
+{
+    _released = true;
+    if (_live == 0) {
+        delete this;
+    }
+}
+
+void *SPObjectPool::_allocate(std::size_t size)
+{
+    ++_live;
+    _used += size;
+
+    if (size > MAX_POOLED_SIZE) {
+        _reserved += size;
+        return ::operator new(size);
+    }
+
+    auto &slot = _free_slots[size / GRANULE - 1];
+    if (slot) {
+        void *p = slot;
+        slot = slot->next;
+        return p;
+    }
+
+    if (_block_end - _block_pos < static_cast<std::ptrdiff_t>(size)) {
+        // The rest of the current block is lost until the pool is deleted. Blocks grow, so that
+        // small documents don't take much.
+        _block_pos = static_cast<char *>(::operator new(_block_size));
+        _block_end = _block_pos + _block_size;
+        _blocks.push_back(_block_pos);
+        _reserved += _block_size;
+        _block_size = std::min(_block_size * 2, MAX_BLOCK_SIZE);
+    }
+    void *p = _block_pos;
+    _block_pos += size;
+    return p;
+}
+
+void SPObjectPool::_deallocate(void *p, std::size_t size)
+{
+    --_live;
+    _used -= size;
+
+    if (size > MAX_POOLED_SIZE) {
+        _reserved -= size;
+        ::operator delete(p);
+    } else {
+        auto &slot = _free_slots[size / GRANULE - 1];
+        slot = new (p) FreeSlot{slot};
+    }
+
+    if (_live == 0 && _released) {
+        delete this;
+    }
+}
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,101 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Pooled storage for the SPObjects of a document
+ *//*
+ * Authors: see git history
+ *
+ * Copyright (C) 2022 Authors
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#ifndef SEEN_SP_OBJECT_POOL_H
+#define SEEN_SP_OBJECT_POOL_H
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+/**
+ * Storage for the SPObjects of one document, which are allocated and freed in large numbers
+ * whenever documents are loaded and closed. Objects are carved from large blocks, and freed
+ * objects are kept in lists by size for reuse, so that they do not fragment the heap. The blocks
+ * are freed together once the document is gone and so are all of its objects.
+ *
+ * Objects come from the pool of the innermost Scope, or from the heap outside any scope. The
+ * pools show up in the Memory dialog. They may only be used from the main thread.
+ */
+class SPObjectPool
+{
+public:
+    SPObjectPool();
+    SPObjectPool(SPObjectPool const &) = delete;
+    SPObjectPool &operator=(SPObjectPool const &) = delete;
+
+    /// While alive, makes new objects come from the given pool.
+    class Scope
+    {
+    public:
+        explicit Scope(SPObjectPool *pool);
+        ~Scope();
+        Scope(Scope const &) = delete;
+        Scope &operator=(Scope const &) = delete;
+
+    private:
+        SPObjectPool *_previous;
+    };
+
+    /// Storage for an object of the given size, from the pool of the current scope if any.
+    static void *allocate(std::size_t size);
+    /// Gives back the storage of an object to the pool it came from.
+    static void deallocate(void *p);
+
+    /// Called by the owner when no new objects will be made. Deletes the pool, and frees all of
+    /// its blocks, as soon as no objects are left.
+    void release();
+
+    /// Bytes taken from the system, including those of objects too large to pool.
+    std::size_t reserved() const { return _reserved; }
+    /// Bytes of objects currently alive.
+    std::size_t used() const { return _used; }
+    std::size_t objectCount() const { return _live; }
+
+private:
+    ~SPObjectPool();
+
+    void *_allocate(std::size_t size);
+    void _deallocate(void *p, std::size_t size);
+
+    static constexpr std::size_t GRANULE = 16;
+    static constexpr std::size_t MAX_POOLED_SIZE = 4096;
+    static constexpr std::size_t MIN_BLOCK_SIZE = 16 * 1024;
+    static constexpr std::size_t MAX_BLOCK_SIZE = 256 * 1024;
+
+    struct FreeSlot
+    {
+        FreeSlot *next;
+    };
+
+    std::array<FreeSlot *, MAX_POOLED_SIZE / GRANULE> _free_slots{};
+    std::vector<void *> _blocks;
+    std::size_t _block_size = MIN_BLOCK_SIZE;
+    char *_block_pos = nullptr;
+    char *_block_end = nullptr;
+
+    std::size_t _reserved = 0;
+    std::size_t _used = 0;
+    std::size_t _live = 0;
+    bool _released = false;
+};
+
+#endif // SEEN_SP_OBJECT_POOL_H
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -35,6 +35,7 @@
 #include "style.h"
 #include "live_effects/lpeobject.h"
 #include "sp-factory.h"
+#include "sp-object-pool.h"
 #include "sp-font.h"
 #include "sp-paint-server.h"
 #include "sp-root.h"
@@ -175,6 +176,16 @@ SPObject::~SPObject() {
     }
 }
 
+void *SPObject::operator new(std::size_t size)
+{
+    return SPObjectPool::allocate(size);
+}
+
+void SPObject::operator delete(void *p)
+{
+    SPObjectPool::deallocate(p);
+}
+
 // CPPIFY: make pure virtual
 void SPObject::read_content() {
     //throw;
@@ -615,6 +626,9 @@ void SPObject::attach(SPObject *object, SPObject *prev)
         it = ++children.iterator_to(*prev);
     }
     children.insert(it, *object);
+    if (document) {
+        document->objectChildrenChanged(this);
+    }
 
     if (!object->xml_space.set)
         object->xml_space.value = this->xml_space.value;
@@ -633,6 +647,9 @@ void SPObject::reorder(SPObject* obj, SPObject* prev) {
     }
 
     children.splice(it, children, children.iterator_to(*obj));
+    if (document) {
+        document->objectChildrenChanged(this);
+    }
 }
 
 void SPObject::detach(SPObject *object)
@@ -644,6 +661,9 @@ void SPObject::detach(SPObject *object)
     g_return_if_fail(object->parent == this);
 
     children.erase(children.iterator_to(*object));
+    if (document) {
+        document->objectChildrenChanged(this);
+    }
     object->releaseReferences();
 
     object->parent = nullptr;
@@ -701,6 +721,7 @@ void SPObject::child_added(Inkscape::XML::Node *child, Inkscape::XML::Node *ref)
 
     const std::string type_string = NodeTraits::get_type_string(*child);
 
+    SPObjectPool::Scope scope(object->document->objectPool());
     SPObject* ochild = SPFactory::createObject(type_string);
     if (ochild == nullptr) {
         // Currently, there are many node types that do not have
@@ -782,6 +803,7 @@ void SPObject::build(SPDocument *document, Inkscape::XML::Node *repr) {
     for (Inkscape::XML::Node *rchild = repr->firstChild() ; rchild != nullptr; rchild = rchild->next()) {
         const std::string typeString = NodeTraits::get_type_string(*rchild);
 
+        SPObjectPool::Scope scope(document->objectPool());
         SPObject* child = SPFactory::createObject(typeString);
         if (child == nullptr) {
             // Currently, there are many node types that do not have
@@ -1118,9 +1140,9 @@ void SPObject::setKeyValue(SPAttr key, gchar const *value)
 
 void SPObject::readAttr(SPAttr keyid)
 {
-    char const *key = sp_attribute_name(keyid);
+    GQuark const key = sp_attribute_quark(keyid);
 
-    assert(key != nullptr);
+    assert(key != 0);
     assert(getRepr() != nullptr);
 
     char const *value = getRepr()->attribute(key);
@@ -1480,6 +1502,10 @@ void SPObject::emitModified(unsigned int flags)
 
     this->modified(flags);
 
+    if (document && (flags & (SP_OBJECT_MODIFIED_FLAG | SP_OBJECT_CHILD_MODIFIED_FLAG | SP_OBJECT_PARENT_MODIFIED_FLAG))) {
+        document->objectBoundsChanged(this, flags & SP_OBJECT_MODIFIED_FLAG);
+    }
+
     _modified_signal.emit(this, flags);
     sp_object_unref(this);
 
@@ -163,6 +163,10 @@ public:
     SPObject();
     virtual ~SPObject();
 
+    // Objects live in the SPObjectPool of their document, see SPObjectPool::Scope.
+    static void *operator new(std::size_t size);
+    static void operator delete(void *p);
+
     unsigned int cloned : 1;
     SPObject *clone_original;
     unsigned int uflags : 8;
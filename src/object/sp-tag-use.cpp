@@ -27,6 +27,7 @@
 #include "preferences.h"
 #include "style.h"
 #include "sp-factory.h"
+#include "sp-object-pool.h"
 #include "sp-symbol.h"
 #include "sp-tag-use-reference.h"
 
@@ -165,7 +166,11 @@ SPTagUse::href_changed(SPObject */*old_ref*/, SPObject */*ref*/)
             Inkscape::XML::Node *childrepr = refobj->getRepr();
             const std::string typeString = NodeTraits::get_type_string(*childrepr);
             
-            SPObject* child_ = SPFactory::createObject(typeString);
+            SPObject *child_;
+            {
+                SPObjectPool::Scope scope(this->document->objectPool());
+                child_ = SPFactory::createObject(typeString);
+            }
             if (child_) {
                 child = child_;
                 attach(child_, lastChild());
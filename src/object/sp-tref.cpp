@@ -25,6 +25,7 @@
 #include "attributes.h"
 #include "document.h"
 #include "sp-factory.h"
+#include "sp-object-pool.h"
 #include "sp-text.h"
 #include "style.h"
 #include "text-editing.h"
@@ -383,7 +384,10 @@ void sp_tref_update_text(SPTRef *tref)
         Inkscape::XML::Document *xml_doc = tref->document->getReprDoc();
 
         Inkscape::XML::Node *newStringRepr = xml_doc->createTextNode(charData.c_str());
-        tref->stringChild = SPFactory::createObject(NodeTraits::get_type_string(*newStringRepr));
+        {
+            SPObjectPool::Scope scope(tref->document->objectPool());
+            tref->stringChild = SPFactory::createObject(NodeTraits::get_type_string(*newStringRepr));
+        }
 
         // Add this SPString as a child of the tref
         tref->attach(tref->stringChild, tref->lastChild());
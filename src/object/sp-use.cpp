@@ -14,8 +14,12 @@
  * Released under GNU GPL v2+, read the file 'COPYING' for more information.
  */
 
+#include <algorithm>
 #include <cstring>
+#include <map>
+#include <sstream>
 #include <string>
+#include <utility>
 
 #include <2geom/transforms.h>
 #include <glibmm/i18n.h>
@@ -24,11 +28,14 @@
 #include "bad-uri-exception.h"
 #include "display/curve.h"
 #include "display/drawing-group.h"
+#include "display/drawing-instance.h"
+#include "display/drawing.h"
 #include "attributes.h"
 #include "document.h"
 #include "sp-clippath.h"
 #include "sp-mask.h"
 #include "sp-factory.h"
+#include "sp-object-pool.h"
 #include "sp-flowregion.h"
 #include "uri.h"
 #include "print.h"
@@ -45,6 +52,48 @@
 #include "sp-text.h"
 #include "sp-flowtext.h"
 
+namespace {
+
+/// Drawing items of a clone's child, shown in one drawing by all the clones that draw the same.
+struct SharedChild {
+    Inkscape::DrawingSource *source = nullptr;
+    SPUse *owner = nullptr; ///< The clone whose child's drawing items are in the source
+    std::vector<SPUse *> users;
+};
+
+std::map<std::pair<Inkscape::Drawing const *, std::string>, SharedChild> shared_children;
+
+/**
+ * Returns whether the item and its descendants draw the same wherever they are shown. Filters,
+ * clips, masks and compositing are rendered on surfaces aligned to the device pixels, and vector
+ * effects depend on the full transform.
+ */
+bool can_share_display(SPItem const *item)
+{
+    if (item->isFiltered() || item->getClipObject() || item->getMaskObject()) {
+        return false;
+    }
+    if (auto style = item->style) {
+        if (style->opacity.value != SP_SCALE24_MAX ||
+            style->mix_blend_mode.value != SP_CSS_BLEND_NORMAL ||
+            style->isolation.value == SP_CSS_ISOLATION_ISOLATE ||
+            style->vector_effect.stroke || style->vector_effect.size ||
+            style->vector_effect.rotate || style->vector_effect.fixed) {
+            return false;
+        }
+    }
+    for (auto &child : item->children) {
+        if (auto child_item = dynamic_cast<SPItem const *>(&child)) {
+            if (!can_share_display(child_item)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+} // namespace
+
 SPUse::SPUse()
     : SPItem(),
       SPDimensions(),
@@ -91,6 +140,8 @@ void SPUse::build(SPDocument *document, Inkscape::XML::Node *repr) {
 }
 
 void SPUse::release() {
+    this->unshare_all();
+
     if (this->child) {
         this->detach(this->child);
         this->child = nullptr;
@@ -309,7 +360,7 @@ Inkscape::DrawingItem* SPUse::show(Inkscape::Drawing &drawing, unsigned int key,
     ai->setStyle(this->style, this->context_style);
     
     if (this->child) {
-        Inkscape::DrawingItem *ac = this->child->invoke_show(drawing, key, flags);
+        Inkscape::DrawingItem *ac = this->show_child(drawing, key, flags);
 
         if (ac) {
             ai->prependChild(ac);
@@ -323,13 +374,117 @@ Inkscape::DrawingItem* SPUse::show(Inkscape::Drawing &drawing, unsigned int key,
 }
 
 void SPUse::hide(unsigned int key) {
-    if (this->child) {
-        this->child->invoke_hide(key);
-    }
+    this->hide_child(key);
 
 //  SPItem::onHide(key);
 }
 
+/**
+ * Shows the child in a view. On the canvas, clones of the same original with the same style and
+ * size share one set of drawing items: the child of the first of them is shown once, and each
+ * clone gets a DrawingInstance of it.
+ */
+Inkscape::DrawingItem *SPUse::show_child(Inkscape::Drawing &drawing, unsigned key, unsigned flags)
+{
+    if (!this->child) {
+        return nullptr;
+    }
+
+    // Exports and previews show each clone by itself
+    std::string shared_key = drawing.shareClones() ? this->shared_child_key() : std::string();
+    if (shared_key.empty()) {
+        return this->child->invoke_show(drawing, key, flags);
+    }
+
+    auto &shared = shared_children[{&drawing, shared_key}];
+    if (!shared.owner) {
+        auto ac = this->child->invoke_show(drawing, key, flags);
+        if (!ac) {
+            shared_children.erase({&drawing, shared_key});
+            return nullptr;
+        }
+        shared.source = new Inkscape::DrawingSource(drawing);
+        shared.source->appendChild(ac);
+        shared.owner = this;
+    }
+    shared.users.push_back(this);
+
+    auto instance = new Inkscape::DrawingInstance(drawing, shared.source);
+    _shared_views.push_back({key, flags, &drawing, std::move(shared_key), instance});
+    return instance;
+}
+
+/**
+ * Removes the child from a view. If other clones still share its drawing items, one of them
+ * shows its own child in their place.
+ */
+void SPUse::hide_child(unsigned key)
+{
+    auto it = std::find_if(_shared_views.begin(), _shared_views.end(),
+                           [=] (SharedView const &v) { return v.key == key; });
+    if (it == _shared_views.end()) {
+        if (this->child) {
+            this->child->invoke_hide(key);
+        }
+        return;
+    }
+    auto const view = std::move(*it);
+    _shared_views.erase(it);
+
+    auto entry = shared_children.find({view.drawing, view.shared_key});
+    g_assert(entry != shared_children.end());
+    auto &shared = entry->second;
+    shared.users.erase(std::find(shared.users.begin(), shared.users.end(), this));
+
+    if (shared.owner == this) {
+        if (this->child) {
+            this->child->invoke_hide(key);
+        }
+        shared.owner = nullptr;
+        if (!shared.users.empty()) {
+            auto next = shared.users.back();
+            auto const &next_view = *std::find_if(next->_shared_views.begin(), next->_shared_views.end(),
+                [&] (SharedView const &v) { return v.drawing == view.drawing && v.shared_key == view.shared_key; });
+            if (auto ac = next->child->invoke_show(*view.drawing, next_view.key, next_view.flags)) {
+                shared.source->appendChild(ac);
+            }
+            shared.owner = next;
+        }
+    }
+    if (shared.users.empty()) {
+        shared_children.erase(entry);
+    }
+
+    // The source goes with its last instance
+    delete view.instance;
+}
+
+/// Takes the child out of all drawing items shared with other clones.
+void SPUse::unshare_all()
+{
+    while (!_shared_views.empty()) {
+        this->hide_child(_shared_views.back().key);
+    }
+}
+
+/**
+ * Returns a description of everything the drawing of the child depends on, or an empty string if
+ * it can not be shared with other clones.
+ */
+std::string SPUse::shared_child_key() const
+{
+    auto original = this->get_original();
+    if (!this->child || !original || !can_share_display(this->child)) {
+        return {};
+    }
+
+    std::ostringstream key;
+    key.imbue(std::locale::classic());
+    key << static_cast<void const *>(original) << ';' << this->width.computed << ';' << this->height.computed << ';'
+        << this->style->write(SP_STYLE_FLAG_ALWAYS).raw();
+    return key.str();
+}
+
 
 /**
  * Returns the ultimate original of a SPUse (i.e. the first object in the chain of its originals
@@ -590,6 +745,8 @@ void SPUse::href_changed() {
     this->_delete_connection.disconnect();
     this->_transformed_connection.disconnect();
 
+    this->unshare_all();
+
     if (this->child) {
         this->detach(this->child);
         this->child = nullptr;
@@ -601,7 +758,11 @@ void SPUse::href_changed() {
         if (refobj) {
             Inkscape::XML::Node *childrepr = refobj->getRepr();
 
-            SPObject* obj = SPFactory::createObject(NodeTraits::get_type_string(*childrepr));
+            SPObject *obj;
+            {
+                SPObjectPool::Scope scope(this->document->objectPool());
+                obj = SPFactory::createObject(NodeTraits::get_type_string(*childrepr));
+            }
 
             SPItem *item = dynamic_cast<SPItem *>(obj);
             if (item) {
@@ -613,7 +774,7 @@ void SPUse::href_changed() {
                 this->child->invoke_build(refobj->document, childrepr, TRUE);
 
                 for (auto &v : views) {
-                    auto ai = this->child->invoke_show(v.drawingitem->drawing(), v.key, v.flags);
+                    auto ai = this->show_child(v.drawingitem->drawing(), v.key, v.flags);
                     if (ai) {
                         v.drawingitem->prependChild(ai);
                     }
@@ -669,10 +830,13 @@ void SPUse::update(SPCtx *ctx, unsigned flags) {
 
     childflags &= ~SP_OBJECT_USER_MODIFIED_FLAG_B;
 
+    bool child_updated = false;
+
     if (this->child) {
         sp_object_ref(this->child);
 
         if (childflags || (this->child->uflags & (SP_OBJECT_MODIFIED_FLAG | SP_OBJECT_CHILD_MODIFIED_FLAG))) {
+            child_updated = true;
             SPItem const *chi = dynamic_cast<SPItem const *>(child);
             g_assert(chi != nullptr);
             cctx.i2doc = chi->transform * ictx->i2doc;
@@ -693,6 +857,26 @@ void SPUse::update(SPCtx *ctx, unsigned flags) {
         }
     }
 
+    // Share the drawing of the child with the clones it now draws the same as
+    if (this->child && (child_updated || (flags & (SP_OBJECT_MODIFIED_FLAG | SP_OBJECT_STYLE_MODIFIED_FLAG)))) {
+        auto const shared_key = this->shared_child_key();
+        for (auto &v : views) {
+            auto &drawing = v.drawingitem->drawing();
+            if (!drawing.shareClones()) {
+                continue;
+            }
+            auto it = std::find_if(_shared_views.begin(), _shared_views.end(),
+                                   [&] (SharedView const &sv) { return sv.key == v.key; });
+            if ((it != _shared_views.end() ? it->shared_key : std::string()) == shared_key) {
+                continue;
+            }
+            this->hide_child(v.key);
+            if (auto ai = this->show_child(drawing, v.key, v.flags)) {
+                v.drawingitem->prependChild(ai);
+            }
+        }
+    }
+
     /* As last step set additional transform of arena group */
     for (auto &v : views) {
         auto g = dynamic_cast<Inkscape::DrawingGroup*>(v.drawingitem);
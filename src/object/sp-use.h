@@ -17,6 +17,8 @@
  */
 
 #include <cstddef>
+#include <string>
+#include <vector>
 #include <sigc++/sigc++.h>
 
 #include "svg/svg-length.h"
@@ -26,6 +28,10 @@
 
 class SPUseReference;
 
+namespace Inkscape {
+class DrawingInstance;
+}
+
 class SPUse : public SPItem, public SPDimensions {
 public:
 	SPUse();
@@ -80,6 +86,21 @@ private:
     void href_changed();
     void move_compensate(Geom::Affine const *mp);
     void delete_self();
+
+    Inkscape::DrawingItem *show_child(Inkscape::Drawing &drawing, unsigned key, unsigned flags);
+    void hide_child(unsigned key);
+    void unshare_all();
+    std::string shared_child_key() const;
+
+    // a view whose child is shown through drawing items shared with other clones
+    struct SharedView {
+        unsigned key;
+        unsigned flags;
+        Inkscape::Drawing *drawing;
+        std::string shared_key;
+        Inkscape::DrawingInstance *instance;
+    };
+    std::vector<SharedView> _shared_views;
 };
 
 #endif
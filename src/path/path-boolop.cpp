@@ -11,6 +11,9 @@
  * Released under GNU GPL v2+, read the file 'COPYING' for more information.
  */
 
+#include <future>
+#include <memory>
+#include <thread>
 #include <vector>
 
 #include <glibmm/i18n.h>
@@ -23,6 +26,7 @@
 
 #include "message-stack.h"
 #include "path-chemistry.h"     // copy_object_properties()
+#include "preferences.h"
 
 #include "helper/geom.h"        // pathv_to_linear_and_cubic_beziers()
 
@@ -173,6 +177,53 @@ sp_flatten(Geom::PathVector &pathvector, FillRule fillkind)
     pathvector = sp_svg_read_pathv(res_d);
 }
 
+/**
+ * Drops the subpaths of \a pathv whose bounding boxes miss \a area. The winding number of a
+ * closed subpath is zero outside its bounding box, so where an operation keeps nothing of
+ * \a pathv outside \a area, such subpaths cannot affect its result. Keeps all subpaths if none
+ * would be left.
+ */
+static void drop_subpaths_outside(Geom::PathVector &pathv, Geom::Rect const &area)
+{
+    Geom::PathVector kept;
+    for (auto const &path : pathv) {
+        auto const bounds = path.boundsFast();
+        if (bounds && bounds->intersects(area)) {
+            kept.push_back(path);
+        }
+    }
+    if (!kept.empty() && kept.size() < pathv.size()) {
+        pathv = std::move(kept);
+    }
+}
+
+/**
+ * Drops the subpaths of the operands of \a bop that cannot affect its result, such as the parts
+ * of a large map far from a small shape it is intersected with. The sweep of livarot then only
+ * deals with the region where the operands overlap. The operands are in livarot order: for a
+ * difference, the first one is subtracted from the second one.
+ */
+static void drop_distant_subpaths(std::vector<Geom::PathVector> &operands, bool_op bop)
+{
+    if (bop == bool_op_inters) {
+        // the result lies within the bounding boxes of all operands
+        Geom::OptRect common = operands[0].boundsFast();
+        for (auto const &operand : operands) {
+            common &= operand.boundsFast();
+        }
+        if (common) {
+            for (auto &operand : operands) {
+                drop_subpaths_outside(operand, *common);
+            }
+        }
+    } else if (bop == bool_op_diff && operands.size() >= 2) {
+        // only the part of the first operand within the second one is subtracted
+        if (auto const area = operands[1].boundsFast()) {
+            drop_subpaths_outside(operands[0], *area);
+        }
+    }
+}
+
 // boolean operations PathVectors A,B -> PathVector result.
 // This is derived from sp_selected_path_boolop
 // take the source paths from the file, do the operation, delete the originals and add the results
@@ -186,9 +237,14 @@ sp_pathvector_boolop(Geom::PathVector const &pathva, Geom::PathVector const &pat
 }
 
 Geom::PathVector 
-sp_pathvector_boolop(Geom::PathVector const &pathva, Geom::PathVector const &pathvb, bool_op bop,
+sp_pathvector_boolop(Geom::PathVector const &pathva_full, Geom::PathVector const &pathvb_full, bool_op bop,
                      fill_typ fra, fill_typ frb, bool livarotonly, bool flattenbefore, int &error)
 {       
+    std::vector<Geom::PathVector> operands{pathva_full, pathvb_full};
+    drop_distant_subpaths(operands, bop);
+    Geom::PathVector const &pathva = operands[0];
+    Geom::PathVector const &pathvb = operands[1];
+
     if (!livarotonly) {
         try {
             Geom::PathVector a = pathv_to_linear_and_cubic_beziers(pathva);
@@ -404,6 +460,85 @@ sp_pathvector_boolop(Geom::PathVector const &pathva, Geom::PathVector const &pat
     return outres;
 }
 
+/**
+ * Unites the paths with indices [first, last) into a new shape, by uniting the unions of both
+ * halves of the range. Each edge then takes part in a number of operations that grows with the
+ * logarithm of the number of paths, rather than in all of the remaining ones, as when the paths
+ * are added to the result one after another.
+ *
+ * The paths must have been converted with back data; the result refers to them by index. The
+ * halves do not share any shapes, so while \a threads is above one, they are united in parallel.
+ */
+static std::unique_ptr<Shape> union_shapes(std::vector<Path *> const &paths, std::vector<FillRule> const &fill_rules,
+                                           int first, int last, int threads)
+{
+    if (last - first == 1) {
+        Shape polygon;
+        paths[first]->Fill(&polygon, first);
+        auto shape = std::make_unique<Shape>();
+        shape->ConvertToShape(&polygon, fill_rules[first]);
+        return shape;
+    }
+
+    int const middle = first + (last - first) / 2;
+    std::unique_ptr<Shape> a, b;
+    if (threads > 1) {
+        auto future_a = std::async(std::launch::async, union_shapes, std::cref(paths), std::cref(fill_rules),
+                                   first, middle, threads / 2);
+        b = union_shapes(paths, fill_rules, middle, last, threads - threads / 2);
+        a = future_a.get();
+    } else {
+        a = union_shapes(paths, fill_rules, first, middle, 1);
+        b = union_shapes(paths, fill_rules, middle, last, 1);
+    }
+
+    // Due to quantization of the input shape coordinates, either may be empty.
+    if (a->numberOfEdges() == 0) {
+        return b;
+    }
+    if (b->numberOfEdges() == 0) {
+        return a;
+    }
+    auto result = std::make_unique<Shape>();
+    result->Booleen(b.get(), a.get(), bool_op_union);
+    return result;
+}
+
+static int boolop_thread_count()
+{
+    auto prefs = Inkscape::Preferences::get();
+    return prefs->getIntLimited("/options/threading/numthreads", std::thread::hardware_concurrency(), 1, 256);
+}
+
+Geom::PathVector sp_pathvector_union(std::vector<Geom::PathVector> const &pathvs, FillRule fill)
+{
+    if (pathvs.empty()) {
+        return {};
+    }
+
+    std::vector<Path *> originaux;
+    for (auto const &pathv : pathvs) {
+        // Livarot's outline of arcs is broken, see sp_pathvector_boolop().
+        originaux.push_back(Path_for_pathvector(pathv_to_linear_and_cubic_beziers(pathv)));
+        originaux.back()->ConvertWithBackData(get_threshold(pathv, 0.1));
+    }
+    std::vector<FillRule> fill_rules(pathvs.size(), fill);
+
+    auto shape = union_shapes(originaux, fill_rules, 0, originaux.size(), boolop_thread_count());
+    Path res;
+    res.SetBackData(false);
+    shape->ConvertToForme(&res, originaux.size(), originaux.data());
+
+    for (auto path : originaux) {
+        delete path;
+    }
+
+    gchar *result_str = res.svg_dump_path();
+    Geom::PathVector outres = Geom::parse_svg_path(result_str);
+    g_free(result_str);
+    return outres;
+}
+
 /**
  * Workaround for buggy Path::Transform() which incorrectly transforms arc commands.
  *
@@ -539,9 +674,10 @@ BoolOpErrors Inkscape::ObjectSet::pathBoolOp(bool_op bop, const bool skip_undo,
         }
     }
 
-    // extract the livarot Paths from the source objects
+    // extract the paths from the source objects
     // also get the winding rule specified in the style
     int nbOriginaux = il.size();
+    std::vector<Geom::PathVector> operands(nbOriginaux);
     std::vector<Path *> originaux(nbOriginaux);
     std::vector<FillRule> origWind(nbOriginaux);
     int curOrig;
@@ -572,22 +708,35 @@ BoolOpErrors Inkscape::ObjectSet::pathBoolOp(bool_op bop, const bool skip_undo,
                 origWind[curOrig]= fill_nonZero;
             }
 
-            originaux[curOrig] = Path_for_item(item, true, true);
-            if (originaux[curOrig] == nullptr || originaux[curOrig]->descr_cmd.size() <= 1)
-            {
-                for (int i = curOrig; i >= 0; i--) delete originaux[i];
+            auto curve = curve_for_item(item);
+            if (!curve) {
                 return DONE_NO_ACTION;
             }
+            std::unique_ptr<Geom::PathVector> pathv(
+                pathvector_for_curve(item, &*curve, true, true, Geom::identity(), Geom::identity()));
+            operands[curOrig] = std::move(*pathv);
             curOrig++;
         }
     }
     // reverse if needed
     // note that the selection list keeps its order
     if ( reverseOrderForOp ) {
-        std::swap(originaux[0], originaux[1]);
+        std::swap(operands[0], operands[1]);
         std::swap(origWind[0], origWind[1]);
     }
 
+    // drop what cannot affect the result before livarot sees it
+    drop_distant_subpaths(operands, bop);
+
+    for (curOrig = 0; curOrig < nbOriginaux; curOrig++) {
+        originaux[curOrig] = Path_for_pathvector(operands[curOrig]);
+        if (originaux[curOrig]->descr_cmd.size() <= 1)
+        {
+            for (int i = curOrig; i >= 0; i--) delete originaux[i];
+            return DONE_NO_ACTION;
+        }
+    }
+
     // and work
     // some temporary instances, first
     Shape *theShapeA = new Shape;
@@ -598,7 +747,15 @@ BoolOpErrors Inkscape::ObjectSet::pathBoolOp(bool_op bop, const bool skip_undo,
     Path::cut_position  *toCut=nullptr;
     int                  nbToCut=0;
 
-    if ( bop == bool_op_inters || bop == bool_op_union || bop == bool_op_diff || bop == bool_op_symdiff ) {
+    if ( bop == bool_op_union ) {
+        // unite halves of the list recursively, which is much faster than one path after another
+        for (int i = 0; i < nbOriginaux; i++) {
+            originaux[i]->ConvertWithBackData(get_threshold(il[i], 0.1));
+        }
+        delete theShape;
+        theShape = union_shapes(originaux, origWind, 0, nbOriginaux, boolop_thread_count()).release();
+
+    } else if ( bop == bool_op_inters || bop == bool_op_diff || bop == bool_op_symdiff ) {
         // true boolean op
         // get the polygons of each path, with the winding rule specified, and apply the operation iteratively
         originaux[0]->ConvertWithBackData(get_threshold(il[0], 0.1));
@@ -10,6 +10,7 @@
 #ifndef PATH_BOOLOP_H
 #define PATH_BOOLOP_H
 
+#include <vector>
 #include <2geom/path.h>
 #include "livarot/Path.h"       // FillRule
 #include "object/object-set.h"  // bool_op
@@ -19,6 +20,8 @@ Geom::PathVector sp_pathvector_boolop(Geom::PathVector const &pathva, Geom::Path
                                       FillRule fra, FillRule frb, bool livarotonly, bool flattenbefore, int &error);
 Geom::PathVector sp_pathvector_boolop(Geom::PathVector const &pathva, Geom::PathVector const &pathvb, bool_op bop,
                                       FillRule fra, FillRule frb, bool livarotonly = false, bool flattenbefore = true);
+/// Unites any number of path vectors with livarot, like Path > Union does for objects.
+Geom::PathVector sp_pathvector_union(std::vector<Geom::PathVector> const &pathvs, FillRule fill);
 
 #endif // PATH_BOOLOP_H
 
@@ -20,6 +20,7 @@
 #include <glibmm/ustring.h>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -651,6 +652,7 @@ private:
     bool _hasError = false; ///< Indication that some error has occurred;
     bool _initialized = false; ///< Is this instance fully initialized? Caching should be avoided before.
     std::unordered_map<std::string, Glib::ustring> cachedRawValue;
+    std::mutex _cache_mutex; ///< Guards cachedRawValue, since preferences are also read while rendering on worker threads.
 
     /// Wrapper class for XML node observers
     class PrefNodeObserver;
@@ -10,6 +10,9 @@
  * Released under GNU GPL v2+, read the file 'COPYING' for more information.
  */
 
+#include <algorithm>
+#include <iterator>
+
 #include "inkscape.h"
 #include "snap-preferences.h"
 
@@ -290,6 +293,14 @@ bool Inkscape::SnapPreferences::isTargetSnappable(Inkscape::SnapTargetType const
     return isTargetSnappable(target1) || isTargetSnappable(target2) || isTargetSnappable(target3) || isTargetSnappable(target4) || isTargetSnappable(target5);
 }
 
+bool Inkscape::SnapPreferences::hasSameTargets(SnapPreferences const &other) const
+{
+    return std::equal(std::begin(_active_snap_targets), std::end(_active_snap_targets), std::begin(other._active_snap_targets)) &&
+           std::equal(std::begin(_active_mask_targets), std::end(_active_mask_targets), std::begin(other._active_mask_targets)) &&
+           std::equal(std::begin(_simple_snapping), std::end(_simple_snapping), std::begin(other._simple_snapping)) &&
+           _strict_snapping == other._strict_snapping;
+}
+
 bool Inkscape::SnapPreferences::isSnapButtonEnabled(Inkscape::SnapTargetType const target) const
 {
     bool always_on = false; // Only needed as a dummy
@@ -39,6 +39,12 @@ public:
     bool isAnyDatumSnappable() const; // Needed because we cannot toggle the datum snap targets as a group
     bool isAnyCategorySnappable() const;
 
+    /**
+     * @return true if both preferences enable the same snap targets, so that they yield the same snap points.
+     * Tolerances and the global toggles are not compared.
+     */
+    bool hasSameTargets(SnapPreferences const &other) const;
+
     void setSnapEnabledGlobally(bool enabled) {_snap_enabled_globally = enabled;}
     bool getSnapEnabledGlobally() const {return _snap_enabled_globally;}
 
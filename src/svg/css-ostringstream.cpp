@@ -8,7 +8,7 @@
  * Released under GNU GPL v2+, read the file 'COPYING' for more information.
  */
 #include "svg/css-ostringstream.h"
-#include "svg/strip-trailing-zeros.h"
+#include "svg/number-format.h"
 #include "preferences.h"
 
 Inkscape::CSSOStringStream::CSSOStringStream()
@@ -34,22 +34,12 @@ Inkscape::CSSOStringStream &Inkscape::CSSOStringStream::operator<<(double d)
         return *this;
     }
 
-    char buf[32];  // haven't thought about how much is really required.
-    switch (precision()) {
-        case 9: g_ascii_formatd(buf, sizeof(buf), "%.9f", d); break;
-        case 8: g_ascii_formatd(buf, sizeof(buf), "%.8f", d); break;
-        case 7: g_ascii_formatd(buf, sizeof(buf), "%.7f", d); break;
-        case 6: g_ascii_formatd(buf, sizeof(buf), "%.6f", d); break;
-        case 5: g_ascii_formatd(buf, sizeof(buf), "%.5f", d); break;
-        case 4: g_ascii_formatd(buf, sizeof(buf), "%.4f", d); break;
-        case 3: g_ascii_formatd(buf, sizeof(buf), "%.3f", d); break;
-        case 2: g_ascii_formatd(buf, sizeof(buf), "%.2f", d); break;
-        case 1: g_ascii_formatd(buf, sizeof(buf), "%.1f", d); break;
-        case 0: g_ascii_formatd(buf, sizeof(buf), "%.0f", d); break;
-        case 10: default: g_ascii_formatd(buf, sizeof(buf), "%.10f", d); break;
-    }
+    // Fixed notation; CSS does not allow exponents everywhere.
+    int const decimals = precision() >= 0 && precision() <= 9 ? precision() : 10;
+    char buf[Inkscape::SVG::NUMBER_BUFFER_SIZE];
+    char const *end = Inkscape::SVG::format_number_fixed(buf, d, decimals);
     auto &os = *this;
-    os << strip_trailing_zeros(buf);
+    os.ostr.write(buf, end - buf);
     return os;
 }
 
@@ -0,0 +1,388 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Inkscape::SVG number formatting - writes doubles as SVG and CSS numbers without iostreams
+ *//*
+ * Authors: see git history
+ *
+ * Copyright (C) 2022 Authors
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include "svg/number-format.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+
+namespace Inkscape {
+
+namespace SVG {
+
+namespace {
+
+// A double has 17 significant digits at most, which also keeps the digits within 64 bits.
+int const MAX_DIGITS = 17;
+
+double const POW10[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+std::uint64_t const UPOW10[] = {1ull,
+                                10ull,
+                                100ull,
+                                1000ull,
+                                10000ull,
+                                100000ull,
+                                1000000ull,
+                                10000000ull,
+                                100000000ull,
+                                1000000000ull,
+                                10000000000ull,
+                                100000000000ull,
+                                1000000000000ull,
+                                10000000000000ull,
+                                100000000000000ull,
+                                1000000000000000ull,
+                                10000000000000000ull,
+                                100000000000000000ull};
+
+/// Returns v * 10^e. Powers of ten up to 10^22 are exact, so this rounds only once in that range.
+double scale10(double v, int e)
+{
+    while (e > 22) {
+        v *= 1e22;
+        e -= 22;
+    }
+    while (e < -22) {
+        v /= 1e22;
+        e += 22;
+    }
+    return e >= 0 ? v * POW10[e] : v / POW10[-e];
+}
+
+/**
+ * Returns v * 10^e, a non-negative value, rounded to an integer like round_scaled(), from the
+ * exact decimal expansion of v. This is slow, and only used where the faster way is not exact.
+ */
+std::uint64_t round_scaled_exact(double v, int e, bool ties_to_even)
+{
+    // The decimals of a binary fraction are as many as its binary digits after the point.
+    int exp2;
+    std::frexp(v, &exp2);
+    int fraction_bits = std::max(0, std::numeric_limits<double>::digits - exp2);
+    while (fraction_bits > 0 && std::ldexp(v, fraction_bits - 1) == std::floor(std::ldexp(v, fraction_bits - 1))) {
+        --fraction_bits;
+    }
+
+    // At most 309 integral digits, or 1074 decimals.
+    char buf[1500];
+    int const length = std::snprintf(buf, sizeof(buf), "%.*f", std::max(fraction_bits, e + 1), v);
+    if (length < 0 || length >= (int)sizeof(buf)) {
+        return std::llround(scale10(v, e));
+    }
+    int const point = std::find(buf, buf + length, '.') - buf;
+    char *const end = std::remove(buf, buf + length, '.');
+    int const split = point + e;
+    if (split < 0) {
+        return 0; // below 0.1
+    }
+
+    std::uint64_t whole = 0;
+    for (char const *c = buf; c != buf + split; ++c) {
+        whole = whole * 10 + (*c - '0');
+    }
+    char const *const rest = buf + split;
+    if (rest == end || *rest != '5') {
+        return whole + (rest != end && *rest > '5');
+    }
+    if (std::any_of(rest + 1, (char const *)end, [](char c) { return c != '0'; })) {
+        return whole + 1;
+    }
+    return whole + (!ties_to_even || whole % 2 != 0);
+}
+
+/**
+ * Returns v * 10^e, a non-negative value, rounded to an integer. Within the range of exact powers
+ * of ten, the rounding error of the product or quotient is recovered with a fused multiply-add,
+ * so that the result is rounded as the exact decimal value would be. Exact ties are rounded
+ * away from zero, or to even if \a ties_to_even is set, as printf does.
+ */
+std::uint64_t round_scaled(double v, int e, bool ties_to_even)
+{
+    if (e < -22 || e > 22) {
+        return round_scaled_exact(v, e, ties_to_even);
+    }
+    double const power = POW10[std::abs(e)];
+    double scaled, error;
+    if (e >= 0) {
+        scaled = v * power;
+        error = std::fma(v, power, -scaled);   // exact: v * power - scaled
+    } else {
+        scaled = v / power;
+        error = std::fma(-scaled, power, v);   // exact: (v / power - scaled) * power
+    }
+    if (scaled >= 0x1p52) {
+        if (e < 0) {
+            // Only the remainder of the division is exact here, not the quotient's fraction.
+            return round_scaled_exact(v, e, ties_to_even);
+        }
+        // 'scaled' is an integer, and the exact product is scaled + error.
+        double const error_whole = std::floor(error);
+        double const error_fraction = error - error_whole; // exact
+        std::uint64_t const whole = std::uint64_t(scaled) + std::uint64_t(std::int64_t(error_whole));
+        if (error_fraction != 0.5) {
+            return whole + (error_fraction > 0.5);
+        }
+        return whole + (!ties_to_even || whole % 2 != 0);
+    }
+    double const whole = std::floor(scaled);
+    // Exact, and a multiple of the unit in the last place of 'scaled', which the error is not.
+    double const above_half = scaled - whole - 0.5;
+    bool up;
+    if (above_half != 0.0) {
+        up = above_half > 0.0;
+    } else if (error != 0.0) {
+        up = error > 0.0;
+    } else {
+        up = !ties_to_even || std::fmod(whole, 2.0) != 0.0;
+    }
+    return std::uint64_t(whole) + up;
+}
+
+int count_digits(std::uint64_t m)
+{
+    int n = 1;
+    while (n < MAX_DIGITS + 1 && m >= UPOW10[n]) {
+        ++n;
+    }
+    return n;
+}
+
+/**
+ * Rounds a positive finite value to \a precision significant digits, returned as the integer
+ * \a digits and the decimal exponent \a exp of its first digit.
+ */
+void round_significant(double v, int precision, std::uint64_t &digits, int &exp, bool ties_to_even)
+{
+    exp = (int)std::floor(std::log10(v));
+    // log10 may be off by one close to powers of ten.
+    for (int attempt = 0; attempt < 3; ++attempt) {
+        digits = round_scaled(v, precision - 1 - exp, ties_to_even);
+        if (digits >= UPOW10[precision]) {
+            if (digits == UPOW10[precision]) {
+                // Rounded up to the next power of ten, like 9.9999 to 10.000.
+                digits /= 10;
+                ++exp;
+                return;
+            }
+            ++exp;
+        } else if (digits < UPOW10[precision - 1]) {
+            --exp;
+        } else {
+            return;
+        }
+    }
+}
+
+/// Drops trailing zeros from \a digits, which has \a count digits.
+void strip_zeros(std::uint64_t &digits, int &count)
+{
+    while (count > 1 && digits % 10 == 0) {
+        digits /= 10;
+        --count;
+    }
+}
+
+/// Writes exactly \a count digits of \a digits, including leading zeros.
+char *write_digits(char *buf, std::uint64_t digits, int count)
+{
+    for (int i = count - 1; i >= 0; --i) {
+        buf[i] = char('0' + digits % 10);
+        digits /= 10;
+    }
+    return buf + count;
+}
+
+char *write_integer(char *buf, int value)
+{
+    if (value < 0) {
+        *buf++ = '-';
+        value = -value;
+    }
+    return write_digits(buf, value, count_digits(value));
+}
+
+/**
+ * Writes \a count \a digits, the first of which is at decimal exponent \a exp, in fixed notation.
+ * The digits must not have trailing zeros.
+ */
+char *write_fixed(char *buf, std::uint64_t digits, int count, int exp)
+{
+    if (exp < 0) {
+        *buf++ = '0';
+        *buf++ = '.';
+        buf = std::fill_n(buf, -exp - 1, '0');
+        return write_digits(buf, digits, count);
+    }
+    if (exp >= count - 1) {
+        buf = write_digits(buf, digits, count);
+        return std::fill_n(buf, exp - count + 1, '0');
+    }
+    std::uint64_t const split = UPOW10[count - exp - 1];
+    buf = write_digits(buf, digits / split, exp + 1);
+    *buf++ = '.';
+    return write_digits(buf, digits % split, count - exp - 1);
+}
+
+/// Writes \a count \a digits as a mantissa with one integral digit. Trailing zeros are dropped.
+char *write_mantissa(char *buf, std::uint64_t digits, int count)
+{
+    strip_zeros(digits, count);
+    std::uint64_t const split = UPOW10[count - 1];
+    *buf++ = char('0' + digits / split);
+    if (count > 1) {
+        *buf++ = '.';
+        buf = write_digits(buf, digits % split, count - 1);
+    }
+    return buf;
+}
+
+char *write_non_finite(char *buf, double val)
+{
+    if (std::isnan(val)) {
+        return std::copy_n("nan", 3, buf);
+    }
+    if (val < 0) {
+        *buf++ = '-';
+    }
+    return std::copy_n("inf", 3, buf);
+}
+
+} // namespace
+
+char *format_number(char *buf, double val, int precision, int min_exp)
+{
+    precision = std::clamp(precision, 1, MAX_DIGITS - 1);
+
+    double const magnitude = std::fabs(val);
+    if (!std::isfinite(val) || val == 0.0) {
+        *buf++ = '0';
+        return buf;
+    }
+    int const eval = (int)std::floor(std::log10(magnitude));
+    if (eval < min_exp) {
+        *buf++ = '0';
+        return buf;
+    }
+
+    // Lengths without the sign, which both notations share.
+    int const length_fixed = eval < 0 ? precision - eval + 1 : std::max(eval + 1, precision + 1);
+    int const length_exponent = precision + (eval < 0 ? 4 : 3);
+
+    if (length_fixed <= length_exponent) {
+        // All integral digits are kept; small numbers get 'precision' decimals.
+        int const decimals = eval < 0 ? precision : precision - eval - 1;
+        std::uint64_t digits = round_scaled(magnitude, decimals, false);
+        if (digits == 0) {
+            *buf++ = '0';
+            return buf;
+        }
+        if (val < 0) {
+            *buf++ = '-';
+        }
+        int count = count_digits(digits);
+        int const exp = count - 1 - decimals;
+        strip_zeros(digits, count);
+        return write_fixed(buf, digits, count, exp);
+    }
+
+    std::uint64_t digits;
+    int exp;
+    round_significant(magnitude, precision, digits, exp, false);
+    if (val < 0) {
+        *buf++ = '-';
+    }
+    buf = write_mantissa(buf, digits, precision);
+    *buf++ = 'e';
+    return write_integer(buf, exp);
+}
+
+char *format_number_general(char *buf, double val, int precision)
+{
+    precision = std::clamp(precision, 1, MAX_DIGITS);
+
+    if (!std::isfinite(val)) {
+        return write_non_finite(buf, val);
+    }
+    if (val == 0.0) {
+        *buf++ = '0';
+        return buf;
+    }
+    if (val < 0) {
+        *buf++ = '-';
+    }
+
+    std::uint64_t digits;
+    int exp;
+    round_significant(std::fabs(val), precision, digits, exp, true);
+
+    if (exp < -4 || exp >= precision) {
+        buf = write_mantissa(buf, digits, precision);
+        *buf++ = 'e';
+        *buf++ = exp < 0 ? '-' : '+';
+        int const e = std::abs(exp);
+        return write_digits(buf, e, std::max(2, count_digits(e)));
+    }
+    int count = precision;
+    strip_zeros(digits, count);
+    return write_fixed(buf, digits, count, exp);
+}
+
+char *format_number_fixed(char *buf, double val, int decimals)
+{
+    decimals = std::clamp(decimals, 0, MAX_DIGITS);
+
+    if (!std::isfinite(val)) {
+        return write_non_finite(buf, val);
+    }
+    double const scaled = scale10(std::fabs(val), decimals);
+    if (scaled >= 1e17) {
+        // More digits than a double holds; the buffer could not take them all in fixed notation.
+        return format_number_general(buf, val, MAX_DIGITS);
+    }
+
+    std::uint64_t digits = round_scaled(std::fabs(val), decimals, true);
+    if (digits == 0) {
+        *buf++ = '0';
+        return buf;
+    }
+    if (val < 0) {
+        *buf++ = '-';
+    }
+    int count = count_digits(digits);
+    int const exp = count - 1 - decimals;
+    strip_zeros(digits, count);
+    return write_fixed(buf, digits, count, exp);
+}
+
+void append_number(std::string &str, double val, int precision, int min_exp)
+{
+    char buf[NUMBER_BUFFER_SIZE];
+    str.append(buf, format_number(buf, val, precision, min_exp));
+}
+
+} // namespace SVG
+
+} // namespace Inkscape
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
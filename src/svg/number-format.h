@@ -0,0 +1,67 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Inkscape::SVG number formatting - writes doubles as SVG and CSS numbers without iostreams
+ *//*
+ * Authors: see git history
+ *
+ * Copyright (C) 2022 Authors
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#ifndef SEEN_INKSCAPE_SVG_NUMBER_FORMAT_H
+#define SEEN_INKSCAPE_SVG_NUMBER_FORMAT_H
+
+#include <cstddef>
+#include <string>
+
+namespace Inkscape {
+
+namespace SVG {
+
+/**
+ * Size of a buffer that can hold any number written by the functions below. The numbers are
+ * not null-terminated; each function returns the position just past the last character written.
+ *
+ * All functions round correctly to the requested digits, write no trailing zeros and no
+ * decimal point without a fraction, and never allocate.
+ */
+constexpr std::size_t NUMBER_BUFFER_SIZE = 32;
+
+/**
+ * Writes a number in the style of path data and transforms: in fixed notation with \a precision
+ * digits, of which at least the integral ones are kept, or with an exponent ("1.5e-5", "3e12")
+ * if that is shorter. Numbers whose magnitude is below 10^min_exp are written as "0".
+ */
+char *format_number(char *buf, double val, int precision, int min_exp);
+
+/**
+ * Writes a number like printf's "%.*g" with trailing zeros removed: \a precision significant
+ * digits, with an exponent ("1.234e-12", "3e+09") for very large or small magnitudes.
+ */
+char *format_number_general(char *buf, double val, int precision);
+
+/**
+ * Writes a number like printf's "%.*f" with trailing zeros removed: at most \a decimals digits
+ * after the decimal point.
+ */
+char *format_number_fixed(char *buf, double val, int decimals);
+
+/// Appends format_number() to a string, which is expected to have reserved space already.
+void append_number(std::string &str, double val, int precision, int min_exp);
+
+} // namespace SVG
+
+} // namespace Inkscape
+
+#endif // SEEN_INKSCAPE_SVG_NUMBER_FORMAT_H
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -12,6 +12,7 @@
  */
 
 #include "svg/path-string.h"
+#include "svg/number-format.h"
 #include "svg/stringstream.h"
 #include "svg/svg.h"
 #include "preferences.h"
@@ -144,15 +145,16 @@ void Inkscape::SVG::PathString::State::appendRelative(Geom::Coord v, Geom::Coord
 }
 
 void Inkscape::SVG::PathString::State::appendNumber(double v, int precision, int minexp) {
-
-    str.append(sp_svg_number_write_de(v, precision, minexp));
+    append_number(str, v, precision, minexp);
 }
 
 void Inkscape::SVG::PathString::State::appendNumber(double v, double &rv, int precision, int minexp) {
-    size_t const oldsize = str.size();
-    appendNumber(v, precision, minexp);
-    char* begin_of_num = const_cast<char*>(str.data()+oldsize); // Slightly evil, I know (but std::string should be storing its data in one big block of memory, so...)
-    sp_svg_number_read_d(begin_of_num, &rv);
+    char buf[NUMBER_BUFFER_SIZE + 1];
+    char *end = format_number(buf, v, precision, minexp);
+    *end = '\0';
+    // The relative coordinates that follow must start from the value as written.
+    sp_svg_number_read_d(buf, &rv);
+    str.append(buf, end);
 }
 
 /*
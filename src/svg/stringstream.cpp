@@ -8,9 +8,10 @@
  * Released under GNU GPL v2+, read the file 'COPYING' for more information.
  */
 #include "svg/stringstream.h"
-#include "svg/strip-trailing-zeros.h"
+#include "svg/number-format.h"
 #include "preferences.h"
 #include <2geom/point.h>
+#include <climits>
 
 Inkscape::SVGOStringStream::SVGOStringStream()
 {
@@ -32,7 +33,7 @@ Inkscape::SVGOStringStream::operator<<(double d)
     auto &os = *this;
 
     /* Try as integer first. */
-    {
+    if (d >= INT_MIN && d <= INT_MAX) {
         int const n = int(d);
         if (d == n) {
             os << n;
@@ -40,12 +41,9 @@ Inkscape::SVGOStringStream::operator<<(double d)
         }
     }
 
-    std::ostringstream s;
-    s.imbue(std::locale::classic());
-    s.flags(os.setf(std::ios::showpoint));
-    s.precision(os.precision());
-    s << d;
-    os << strip_trailing_zeros(s.str());
+    char buf[Inkscape::SVG::NUMBER_BUFFER_SIZE];
+    char const *end = Inkscape::SVG::format_number_general(buf, d, os.precision());
+    os.ostr.write(buf, end - buf);
     return os;
 }
 
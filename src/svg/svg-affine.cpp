@@ -19,6 +19,7 @@
 #include <glib.h>
 #include <2geom/transforms.h>
 #include "svg.h"
+#include "number-format.h"
 #include "preferences.h"
 
 std::string
@@ -40,89 +41,90 @@ sp_svg_transform_write(Geom::Affine const &transform)
     }
 
 
-    std::stringstream c(""); // string buffer
+    std::string c; // string buffer
+    c.reserve(128);
 
     if (transform.isIdentity()) {
         // We are more or less identity, so no transform attribute needed:
         return {};
     } else if (transform.isScale()) {
         // We are more or less a uniform scale
-        c << "scale(";
-        c << sp_svg_number_write_de(transform[0], prec, min_exp);
+        c += "scale(";
+        Inkscape::SVG::append_number(c, transform[0], prec, min_exp);
         if (Geom::are_near(transform[0], transform[3], e)) {
-            c << ")";
+            c += ")";
         } else {
-            c << ",";
-            c << sp_svg_number_write_de(transform[3], prec, min_exp);
-            c << ")";
+            c += ",";
+            Inkscape::SVG::append_number(c, transform[3], prec, min_exp);
+            c += ")";
         }
     } else if (transform.isTranslation()) {
         // We are more or less a pure translation
-        c  << "translate(";
-        c << sp_svg_number_write_de(transform[4], prec, min_exp);
+        c += "translate(";
+        Inkscape::SVG::append_number(c, transform[4], prec, min_exp);
         if (Geom::are_near(transform[5], 0.0, e)) {
-            c << ")";
+            c += ")";
         } else {
-            c << ",";
-            c << sp_svg_number_write_de(transform[5], prec, min_exp);
-            c << ")";
+            c += ",";
+            Inkscape::SVG::append_number(c, transform[5], prec, min_exp);
+            c += ")";
         }
     } else if (transform.isRotation()) {
         // We are more or less a pure rotation
-        c << "rotate(";
+        c += "rotate(";
         double angle = std::atan2(transform[1], transform[0]) * (180 / M_PI);
-        c << sp_svg_number_write_de(angle, prec, min_exp);
-        c << ")";
+        Inkscape::SVG::append_number(c, angle, prec, min_exp);
+        c += ")";
     } else if (transform.withoutTranslation().isRotation()) {
         // Solution found by Johan Engelen
         // Refer to the matrix in svg-affine-test.h
 
         // We are a rotation about a special axis
-        c << "rotate(";
+        c += "rotate(";
         double angle = std::atan2(transform[1], transform[0]) * (180 / M_PI);
-        c << sp_svg_number_write_de(angle, prec, min_exp);
-        c << ",";
+        Inkscape::SVG::append_number(c, angle, prec, min_exp);
+        c += ",";
 
         Geom::Affine const& m = transform;
         double tx = (m[2]*m[5]+m[4]-m[4]*m[3]) / (1-m[3]-m[0]+m[0]*m[3]-m[2]*m[1]);
 
-        c << sp_svg_number_write_de(tx, prec, min_exp);
-        c << ",";
+        Inkscape::SVG::append_number(c, tx, prec, min_exp);
+        c += ",";
 
         double ty = (m[1]*tx + m[5]) / (1 - m[3]);
-        c << sp_svg_number_write_de(ty, prec, min_exp);
-        c << ")";
+        Inkscape::SVG::append_number(c, ty, prec, min_exp);
+        c += ")";
     } else if (transform.isHShear()) {
         // We are more or less a pure skewX
-        c << "skewX(";
+        c += "skewX(";
         double angle = atan(transform[2]) * (180 / M_PI);
-        c << sp_svg_number_write_de(angle, prec, min_exp);
-        c << ")";
+        Inkscape::SVG::append_number(c, angle, prec, min_exp);
+        c += ")";
     } else if (transform.isVShear()) {
         // We are more or less a pure skewY
-        c << "skewY(";
+        c += "skewY(";
         double angle = atan(transform[1]) * (180 / M_PI);
 
-        c << sp_svg_number_write_de(angle, prec, min_exp);
-        c << ")";
+        Inkscape::SVG::append_number(c, angle, prec, min_exp);
+        c += ")";
     } else {
-        c << "matrix(";
-        c << sp_svg_number_write_de(transform[0], prec, min_exp);
-        c << ",";
-        c << sp_svg_number_write_de(transform[1], prec, min_exp);
-        c << ",";
-        c << sp_svg_number_write_de(transform[2], prec, min_exp);
-        c << ",";
-        c << sp_svg_number_write_de(transform[3], prec, min_exp);
-        c << ",";
-        c << sp_svg_number_write_de(transform[4], prec, min_exp);
-        c << ",";
-        c << sp_svg_number_write_de(transform[5], prec, min_exp);
-        c << ")";
+        c += "matrix(";
+        Inkscape::SVG::append_number(c, transform[0], prec, min_exp);
+        c += ",";
+        Inkscape::SVG::append_number(c, transform[1], prec, min_exp);
+        c += ",";
+        Inkscape::SVG::append_number(c, transform[2], prec, min_exp);
+        c += ",";
+        Inkscape::SVG::append_number(c, transform[3], prec, min_exp);
+        c += ",";
+        Inkscape::SVG::append_number(c, transform[4], prec, min_exp);
+        c += ",";
+        Inkscape::SVG::append_number(c, transform[5], prec, min_exp);
+        c += ")";
     }
 
-    assert(c.str().length() <= 256);
-    return c.str();
+    assert(c.length() <= 256);
+    return c;
 
 }
 
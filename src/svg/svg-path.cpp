@@ -16,6 +16,9 @@
  * Released under GNU GPL v2+, read the file 'COPYING' for more information.
  */
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <cstring>
 #include <string>
 #include <glib.h> // g_assert()
@@ -23,12 +26,400 @@
 #include <2geom/pathvector.h>
 #include <2geom/curves.h>
 #include <2geom/sbasis-to-bezier.h>
-#include <2geom/path-sink.h>
-#include <2geom/svg-path-parser.h>
 
 #include "svg/svg.h"
 #include "svg/path-string.h"
 
+namespace {
+
+double const POW10[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+inline bool is_digit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+inline bool is_wsp(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+/**
+ * Reads SVG path data in a single pass over the attribute string, appending the curves directly
+ * to the paths of the resulting PathVector. Behaves like Geom::SVGPathParser with a Z snap
+ * threshold of Geom::EPSILON: a relative path that ends within EPSILON of its start is closed
+ * exactly, and a syntax error ends the data, keeping what was read before it.
+ */
+class PathDataParser
+{
+public:
+    PathDataParser(char const *str, Geom::PathVector &pathv)
+        : _pos(str)
+        , _pathv(pathv)
+    {}
+
+    /// Returns false if the data has a syntax error.
+    bool parse()
+    {
+        bool const result = _parse();
+        _flushSegment();
+        return result;
+    }
+
+private:
+    enum class Segment { NONE, LINE, QUAD, CUBIC, ARC };
+
+    bool _parse();
+    bool _number(double &value);
+    void _skipWsp();
+    bool _skipCommaWsp();
+    bool _atNumber() const;
+
+    void _moveTo(Geom::Point const &p);
+    void _lineTo(Geom::Point const &p);
+    void _quadTo(Geom::Point const &c, Geom::Point const &p);
+    void _curveTo(Geom::Point const &c0, Geom::Point const &c1, Geom::Point const &p);
+    void _arcTo(double rx, double ry, double angle, bool large, bool sweep, Geom::Point const &p);
+    void _closePath();
+    void _startSegment(Segment segment);
+    void _flushSegment();
+
+    char const *_pos;
+    Geom::PathVector &_pathv;
+    bool _in_path = false;
+    bool _absolute = false;         ///< whether the last drawing command was absolute
+    bool _moveto_absolute = false;  ///< whether the moveto of the current path was absolute
+
+    Geom::Point _initial;
+    Geom::Point _current;
+    Geom::Point _cubic_tangent;     ///< first control point of a following S
+    Geom::Point _quad_tangent;      ///< control point of a following T
+
+    // The last segment is only appended at the next command, so that Z can still snap its end.
+    Segment _segment = Segment::NONE;
+    Geom::Point _points[3];
+    double _rx = 0;
+    double _ry = 0;
+    double _angle = 0;
+    bool _large = false;
+    bool _sweep = false;
+};
+
+bool PathDataParser::_parse()
+{
+    _skipWsp();
+    if (*_pos && *_pos != 'M' && *_pos != 'm') {
+        return false;
+    }
+
+    while (*_pos) {
+        char const command = *_pos++;
+        bool const relative = command >= 'a';
+        _skipWsp();
+
+        int count;
+        switch (command) {
+            case 'Z': case 'z':
+                _closePath();
+                continue;
+            case 'H': case 'h': case 'V': case 'v':
+                count = 1;
+                break;
+            case 'M': case 'm': case 'L': case 'l': case 'T': case 't':
+                count = 2;
+                break;
+            case 'S': case 's': case 'Q': case 'q':
+                count = 4;
+                break;
+            case 'C': case 'c':
+                count = 6;
+                break;
+            case 'A': case 'a':
+                count = 7;
+                break;
+            default:
+                return false;
+        }
+
+        bool moveto = command == 'M' || command == 'm';
+        while (true) {
+            double args[7];
+            for (int i = 0; i < count; ++i) {
+                if (i > 0) {
+                    _skipCommaWsp();
+                }
+                if ((command == 'A' || command == 'a') && (i == 3 || i == 4)) {
+                    // Flags are single digits, which need no separator.
+                    if (*_pos != '0' && *_pos != '1') {
+                        return false;
+                    }
+                    args[i] = *_pos++ - '0';
+                } else if (!_number(args[i])) {
+                    return false;
+                }
+            }
+
+            Geom::Point const origin = relative ? _current : Geom::Point(0, 0);
+            auto const point = [&](int i) { return origin + Geom::Point(args[i], args[i + 1]); };
+            if (moveto) {
+                _moveto_absolute = !relative;
+                _moveTo(point(0));
+                // Further coordinate pairs are implicit lineto commands.
+                moveto = false;
+            } else {
+                _absolute = !relative;
+                switch (command) {
+                    case 'M': case 'm': case 'L': case 'l':
+                        _lineTo(point(0));
+                        break;
+                    case 'H': case 'h':
+                        _lineTo(Geom::Point(origin[Geom::X] + args[0], _current[Geom::Y]));
+                        break;
+                    case 'V': case 'v':
+                        _lineTo(Geom::Point(_current[Geom::X], origin[Geom::Y] + args[0]));
+                        break;
+                    case 'C': case 'c':
+                        _curveTo(point(0), point(2), point(4));
+                        break;
+                    case 'S': case 's':
+                        _curveTo(_cubic_tangent, point(0), point(2));
+                        break;
+                    case 'Q': case 'q':
+                        _quadTo(point(0), point(2));
+                        break;
+                    case 'T': case 't':
+                        _quadTo(_quad_tangent, point(0));
+                        break;
+                    default: // 'A', 'a'
+                        _arcTo(args[0], args[1], Geom::rad_from_deg(args[2]), args[3] != 0, args[4] != 0, point(5));
+                        break;
+                }
+            }
+
+            // Parameter sets may be separated by a comma, but a command may not follow one.
+            bool const comma = _skipCommaWsp();
+            if (!_atNumber()) {
+                if (comma) {
+                    return false;
+                }
+                break;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * Reads a number. Up to 19 significant digits are gathered in an integer; when it and the power
+ * of ten are both exact as doubles, their product or quotient is correctly rounded. Other numbers
+ * are converted again by g_ascii_strtod(), which reads the same characters.
+ */
+bool PathDataParser::_number(double &value)
+{
+    char const *p = _pos;
+    bool negative = false;
+    if (*p == '+' || *p == '-') {
+        negative = *p == '-';
+        ++p;
+    }
+
+    std::uint64_t mantissa = 0;
+    int significant = 0;
+    int exponent = 0;
+    bool exact = true;
+    bool digits = false;
+    for (; is_digit(*p); ++p) {
+        digits = true;
+        if (significant < 19) {
+            mantissa = mantissa * 10 + (*p - '0');
+            significant += mantissa != 0;
+        } else {
+            exact = false;
+        }
+    }
+    if (*p == '.') {
+        for (++p; is_digit(*p); ++p) {
+            digits = true;
+            if (significant < 19) {
+                mantissa = mantissa * 10 + (*p - '0');
+                significant += mantissa != 0;
+                --exponent;
+            }
+        }
+    }
+    if (!digits) {
+        return false;
+    }
+    if (*p == 'e' || *p == 'E') {
+        // An exponent needs digits, otherwise the 'e' is not part of the number.
+        char const *q = p + 1;
+        bool const negative_exponent = *q == '-';
+        if (*q == '+' || *q == '-') {
+            ++q;
+        }
+        if (is_digit(*q)) {
+            int e = 0;
+            for (; is_digit(*q); ++q) {
+                e = std::min(e * 10 + (*q - '0'), 100000);
+            }
+            exponent += negative_exponent ? -e : e;
+            p = q;
+        }
+    }
+
+    if (exact && mantissa < (std::uint64_t(1) << 53) && exponent >= -22 && exponent <= 22) {
+        value = exponent < 0 ? mantissa / POW10[-exponent] : mantissa * POW10[exponent];
+        if (negative) {
+            value = -value;
+        }
+    } else {
+        value = g_ascii_strtod(_pos, nullptr);
+    }
+    _pos = p;
+    return true;
+}
+
+void PathDataParser::_skipWsp()
+{
+    while (is_wsp(*_pos)) {
+        ++_pos;
+    }
+}
+
+/// Skips the separator between two parameters. Returns whether it has a comma.
+bool PathDataParser::_skipCommaWsp()
+{
+    _skipWsp();
+    if (*_pos != ',') {
+        return false;
+    }
+    ++_pos;
+    _skipWsp();
+    return true;
+}
+
+bool PathDataParser::_atNumber() const
+{
+    char const c = *_pos;
+    return is_digit(c) || c == '.' || c == '+' || c == '-';
+}
+
+void PathDataParser::_moveTo(Geom::Point const &p)
+{
+    _flushSegment();
+    _pathv.push_back(Geom::Path(p));
+    _in_path = true;
+    _initial = _current = _cubic_tangent = _quad_tangent = p;
+}
+
+void PathDataParser::_lineTo(Geom::Point const &p)
+{
+    _startSegment(Segment::LINE);
+    _points[0] = p;
+    _current = _cubic_tangent = _quad_tangent = p;
+}
+
+void PathDataParser::_quadTo(Geom::Point const &c, Geom::Point const &p)
+{
+    _startSegment(Segment::QUAD);
+    _points[0] = c;
+    _points[1] = p;
+    _cubic_tangent = _current = p;
+    _quad_tangent = p + (p - c);
+}
+
+void PathDataParser::_curveTo(Geom::Point const &c0, Geom::Point const &c1, Geom::Point const &p)
+{
+    _startSegment(Segment::CUBIC);
+    _points[0] = c0;
+    _points[1] = c1;
+    _points[2] = p;
+    _quad_tangent = _current = p;
+    _cubic_tangent = p + (p - c1);
+}
+
+void PathDataParser::_arcTo(double rx, double ry, double angle, bool large, bool sweep, Geom::Point const &p)
+{
+    if (_current == p) {
+        // An arc that ends where it starts is omitted, as the SVG specification requires.
+        return;
+    }
+    _startSegment(Segment::ARC);
+    _rx = std::fabs(rx);
+    _ry = std::fabs(ry);
+    _angle = angle;
+    _large = large;
+    _sweep = sweep;
+    _points[0] = p;
+    _quad_tangent = _cubic_tangent = _current = p;
+}
+
+void PathDataParser::_closePath()
+{
+    if (_segment != Segment::NONE && (!_absolute || !_moveto_absolute) &&
+        Geom::are_near(_initial, _current, Geom::EPSILON))
+    {
+        // Undo the rounding of relative coordinates, which would leave a tiny closing segment.
+        switch (_segment) {
+            case Segment::QUAD:
+                _points[1] = _initial;
+                break;
+            case Segment::CUBIC:
+                _points[2] = _initial;
+                break;
+            default:
+                _points[0] = _initial;
+                break;
+        }
+    }
+    _flushSegment();
+    if (_in_path) {
+        _pathv.back().close(true);
+        _in_path = false;
+    }
+    _quad_tangent = _cubic_tangent = _current = _initial;
+}
+
+/// Holds back a new segment, appending the previous one. Drawing after Z starts a new path.
+void PathDataParser::_startSegment(Segment segment)
+{
+    _flushSegment();
+    if (!_in_path) {
+        _pathv.push_back(Geom::Path(_initial));
+        _in_path = true;
+    }
+    _segment = segment;
+}
+
+void PathDataParser::_flushSegment()
+{
+    if (_segment == Segment::NONE) {
+        return;
+    }
+    // The path is built in place; the PathVector is its only owner, so appending does not copy it.
+    Geom::Path &path = _pathv.back();
+    switch (_segment) {
+        case Segment::LINE:
+            path.appendNew<Geom::LineSegment>(_points[0]);
+            break;
+        case Segment::QUAD:
+            path.appendNew<Geom::QuadraticBezier>(_points[0], _points[1]);
+            break;
+        case Segment::CUBIC:
+            path.appendNew<Geom::CubicBezier>(_points[0], _points[1], _points[2]);
+            break;
+        case Segment::ARC:
+            path.appendNew<Geom::EllipticalArc>(_rx, _ry, _angle, _large, _sweep, _points[0]);
+            break;
+        default:
+            break;
+    }
+    _segment = Segment::NONE;
+}
+
+} // namespace
+
 /*
  * Parses the path in str. When an error is found in the pathstring, this method
  * returns a truncated path up to where the error was found in the pathstring.
@@ -40,15 +431,8 @@ Geom::PathVector sp_svg_read_pathv(char const * str)
     if (!str)
         return pathv;  // return empty pathvector when str == NULL
 
-    Geom::PathBuilder builder(pathv);
-    Geom::SVGPathParser parser(builder);
-    parser.setZSnapThreshold(Geom::EPSILON);
-
-    try {
-        parser.parse(str);
-    }
-    catch (Geom::SVGPathParseError &e) {
-        builder.flush();
+    PathDataParser parser(str, pathv);
+    if (!parser.parse()) {
         // This warning is extremely annoying when testing
         g_warning(
             "Malformed SVG path, truncated path up to where error was found.\n Input path=\"%s\"\n Parsed path=\"%s\"",
@@ -33,7 +33,8 @@ unsigned int sp_svg_number_read_f( const char *str, float *val );
 unsigned int sp_svg_number_read_d( const char *str, double *val );
 
 /*
- * No buffer overflow checking is done, so better wrap them if needed
+ * Writes val with tprec significant digits, see Inkscape::SVG::format_number(). Serialisers that
+ * write many numbers should use that or append_number() directly, which need no allocation.
  */
 std::string sp_svg_number_write_de( double val, unsigned int tprec, int min_exp );
 
@@ -2635,6 +2635,10 @@ void InkscapePreferences::initPageBehavior()
     _lpe_copy_mirroricons.init ( _("Add advanced tiling options"), "/live_effects/copy/mirroricons", true); // text label
     _page_lpe.add_line( true, "", _lpe_copy_mirroricons, "",
                            _("Enables using 16 advanced mirror options between the copies (so there can be copies that are mirrored differently between the rows and the columns) for Tiling LPE")); // tooltip
+    _page_lpe.add_group_header( _("Updates"));
+    _lpe_async.init ( _("Compute slow effects in the background"), "/live_effects/async", false);
+    _page_lpe.add_line( true, "", _lpe_async, "",
+                           _("Keep showing the previous result of slow effects, like Pattern Along Path, while the new one is computed in the background, instead of waiting for it"));
     this->AddPage(_page_lpe, _("Live Path Effects (LPE)"), iter_behavior, PREFS_PAGE_BEHAVIOR_LPE);
 }
 
@@ -2783,6 +2787,8 @@ void InkscapePreferences::initPageRendering()
     add_devmode_line(_("Smallest tile size for new bisector"), _canvas_new_bisector_size, C_("pixel abbreviation", "px"), _("Halve rendering tile rectangles until their largest dimension is this small"));
     _rendering_tile_size.init("/options/rendering/tile-size", 1.0, 10000.0, 1.0, 0.0, 16.0, true, false);
     add_devmode_line(_("Tile size:"), _rendering_tile_size, "", _("The \"tile size\" parameter previously hard-coded into Inkscape's original tile bisector."));
+    _canvas_render_threads.init("/options/rendering/render-threads", 1.0, 64.0, 1.0, 0.0, 1.0, true, false);
+    add_devmode_line(_("Rendering threads"), _canvas_render_threads, "", _("Render this many tiles at once on separate threads. Outline overlay and split view modes always render on a single thread."));
     _canvas_pad.init("/options/rendering/pad", 0.0, 1000.0, 1.0, 0.0, 350.0, true, false);
     add_devmode_line(_("Buffer padding"), _canvas_pad, C_("pixel abbreviation", "px"), _("Use buffers bigger than the window by this amount"));
     _canvas_margin.init("/options/rendering/margin", 0.0, 1000.0, 1.0, 0.0, 100.0, true, false);
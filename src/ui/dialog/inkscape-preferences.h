@@ -355,6 +355,7 @@ protected:
     UI::Widget::PrefCheckButton _canvas_use_new_bisector;
     UI::Widget::PrefSpinButton  _canvas_new_bisector_size;
     UI::Widget::PrefSpinButton  _rendering_tile_size;
+    UI::Widget::PrefSpinButton  _canvas_render_threads;
     UI::Widget::PrefSpinButton  _canvas_pad;
     UI::Widget::PrefSpinButton  _canvas_margin;
     UI::Widget::PrefSpinButton  _canvas_preempt;
@@ -400,6 +401,7 @@ protected:
     UI::Widget::PrefCheckButton _cleanup_swatches;
 
     UI::Widget::PrefCheckButton _lpe_copy_mirroricons;
+    UI::Widget::PrefCheckButton _lpe_async;
 
     UI::Widget::PrefSpinButton  _importexport_export_res;
     UI::Widget::PrefSpinButton  _importexport_import_res;
@@ -125,7 +125,9 @@ void Memory::Private::update() {
             Debug::Heap::Stats stats=heap->stats();
             int features=heap->features();
 
-            aggregate_features &= features;
+            if (!(features & Debug::Heap::SUBALLOCATED)) {
+                aggregate_features &= features;
+            }
 
             if ( row == model->children().end() ) {
                 row = model->append();
@@ -134,13 +136,17 @@ void Memory::Private::update() {
             row->set_value(columns.name, Glib::ustring(heap->name()));
             if ( features & Debug::Heap::SIZE_AVAILABLE ) {
                 row->set_value(columns.total, format_size(stats.size));
-                total.size += stats.size;
+                if (!(features & Debug::Heap::SUBALLOCATED)) {
+                    total.size += stats.size;
+                }
             } else {
                 row->set_value(columns.total, Glib::ustring(_("Unknown")));
             }
             if ( features & Debug::Heap::USED_AVAILABLE ) {
                 row->set_value(columns.used, format_size(stats.bytes_used));
-                total.bytes_used += stats.bytes_used;
+                if (!(features & Debug::Heap::SUBALLOCATED)) {
+                    total.bytes_used += stats.bytes_used;
+                }
             } else {
                 row->set_value(columns.used, Glib::ustring(_("Unknown")));
             }
@@ -9,12 +9,19 @@
  * Released under GNU GPL v2+, read the file 'COPYING' for more information.
  */
 
+#ifdef HAVE_CONFIG_H
+# include "config.h"  // only include where actually required!
+#endif
+
 #include <iostream> // Logging
 #include <algorithm> // Sort
 #include <set> // Coarsener
 #include <array>
 #include <2geom/convex-hull.h>
 #include <epoxy/gl.h>
+#if HAVE_OPENMP
+#include <omp.h>
+#endif
 
 #include "canvas.h"
 #include "canvas-grid.h"
@@ -63,6 +70,10 @@
  *   * paint_rect_internal() Which paints the rectangle using paint_single_buffer(). It renders onto a Cairo
  *                           surface "backing_store". After a piece is rendered there is a call to:
  *
+ *                      (With "/options/rendering/render-threads" above 1, rectangles are instead collected into
+ *                      batches and painted by paint_rects(), which renders each on a worker thread into a surface
+ *                      of its own before pasting them all onto the backing store on the main thread.)
+ *
  *   * queue_draw_area() A Gtk function for marking areas of the window as needing a repaint, which when
  *                       the time is right calls:
  *
@@ -103,6 +114,7 @@ struct Prefs
 {
     // Original parameters
     Pref<int>    tile_size                = Pref<int>   ("/options/rendering/tile-size", 16, 1, 10000);
+    Pref<int>    render_threads           = Pref<int>   ("/options/rendering/render-threads", 1, 1, 64);
     Pref<int>    tile_multiplier          = Pref<int>   ("/options/rendering/tile-multiplier", 16, 1, 512);
     Pref<int>    x_ray_radius             = Pref<int>   ("/options/rendering/xray-radius", 100, 1, 1500);
     Pref<bool>   from_display             = Pref<bool>  ("/options/displayprofile/from_display");
@@ -147,6 +159,7 @@ struct Prefs
     void set_devmode(bool on)
     {
         tile_size.set_enabled(on);
+        render_threads.set_enabled(on);
         render_time_limit.set_enabled(on);
         use_new_bisector.set_enabled(on);
         new_bisector_size.set_enabled(on);
@@ -1089,8 +1102,10 @@ public:
 
     // Content drawing
     bool on_idle();
-    void paint_rect(Geom::IntRect const &rect);
-    void paint_single_buffer(const Cairo::RefPtr<Cairo::ImageSurface> &surface, const Geom::IntRect &rect, bool need_background);
+    void paint_rect(Geom::IntRect const &rect, const Cairo::RefPtr<Cairo::ImageSurface> &content = {});
+    void paint_rects(std::vector<Geom::IntRect> const &rects);
+    void paint_single_buffer(const Cairo::RefPtr<Cairo::ImageSurface> &surface, const Geom::IntRect &rect, bool need_background, bool concurrent = false);
+    int get_render_threads() const;
     std::optional<Geom::Dim2> old_bisector(const Geom::IntRect &rect);
     std::optional<Geom::Dim2> new_bisector(const Geom::IntRect &rect);
     bool need_outline_store() const {return q->_split_mode != Inkscape::SplitMode::NORMAL || q->_render_mode == Inkscape::RenderMode::OUTLINE_OVERLAY;}
@@ -3876,6 +3891,67 @@ bool CanvasPrivate::on_idle()
     // Begin processing redraws.
     auto start_time = g_get_monotonic_time();
 
+    // Rectangles waiting to be painted together, at most one per rendering thread.
+    std::vector<Geom::IntRect> batch;
+    auto const batch_size = get_render_threads();
+
+    // Paint the waiting rectangles, mark them as clean and schedule their repaint. Returns true to indicate timeout.
+    // Note: The batch is always painted to completion before returning to the main loop, so a change of view can never
+    // occur while it is in flight. It is picked up by the next call to on_idle(), just as in the single-threaded case.
+    auto flush_batch = [&, this] {
+        if (batch.empty()) {
+            return false;
+        }
+
+        // Paint the rectangles.
+        paint_rects(batch);
+
+        for (auto const &rect : batch) {
+            // Introduce an artificial delay for each rectangle.
+            if (prefs.debug_slow_redraw) g_usleep(prefs.debug_slow_redraw_time);
+
+            // Mark the rectangle as clean.
+            updater->mark_clean(rect);
+
+            // Get the rectangle of screen-space needing repaint.
+            Geom::IntRect repaint_rect;
+            if (!decoupled_mode) {
+                // Simply translate to get back to screen space.
+                repaint_rect = rect - q->_pos;
+            } else {
+                // Transform into screen space, take bounding box, and round outwards.
+                auto pl = Geom::Parallelogram(rect);
+                pl *= q->_affine * store->affine.inverse();
+                pl *= Geom::Translate(-q->_pos);
+                repaint_rect = pl.bounds().roundOutwards();
+            }
+
+            // Check if repaint is necessary - some rectangles could be entirely off-screen.
+            auto screen_rect = Geom::IntRect({0, 0}, q->get_dimensions());
+            if (regularised(repaint_rect & screen_rect)) {
+                // Schedule repaint.
+                queue_draw_area(repaint_rect);
+                disconnect_bucket_emptier_tick_callback();
+                pending_draw = true;
+            }
+        }
+
+        batch.clear();
+
+        // Check for timeout.
+        auto now = g_get_monotonic_time();
+        auto elapsed = now - start_time;
+        if (elapsed > prefs.render_time_limit) {
+            // Timed out. Temporarily return to GTK main loop, and come back here when next idle.
+            if (prefs.debug_logging) std::cout << "Timed out: " << g_get_monotonic_time() - start_time << " us" << std::endl;
+            framecheckobj.subtype = 1;
+            return true;
+        }
+
+        // No timeout.
+        return false;
+    };
+
     // Paint a given subrectangle of the store given by 'bounds', but avoid painting the part of it within 'clean' if possible.
     // Some parts both outside the bounds and inside the clean region may also be painted if it helps reduce fragmentation.
     // Returns true to indicate timeout.
@@ -3943,50 +4019,16 @@ bool CanvasPrivate::on_idle()
                 if (rect.bottom() == bounds.bottom()) rect.setBottom(std::min(rect.top()    + prefs.preempt, store->rect.bottom()));
             }
 
-            // Paint the rectangle.
-            paint_rect(rect);
-
-            // Introduce an artificial delay for each rectangle.
-            if (prefs.debug_slow_redraw) g_usleep(prefs.debug_slow_redraw_time);
-
-            // Mark the rectangle as clean.
-            updater->mark_clean(rect);
-
-            // Get the rectangle of screen-space needing repaint.
-            Geom::IntRect repaint_rect;
-            if (!decoupled_mode) {
-                // Simply translate to get back to screen space.
-                repaint_rect = rect - q->_pos;
-            } else {
-                // Transform into screen space, take bounding box, and round outwards.
-                auto pl = Geom::Parallelogram(rect);
-                pl *= q->_affine * store->affine.inverse();
-                pl *= Geom::Translate(-q->_pos);
-                repaint_rect = pl.bounds().roundOutwards();
-            }
-
-            // Check if repaint is necessary - some rectangles could be entirely off-screen.
-            auto screen_rect = Geom::IntRect({0, 0}, q->get_dimensions());
-            if (regularised(repaint_rect & screen_rect)) {
-                // Schedule repaint.
-                queue_draw_area(repaint_rect);
-                disconnect_bucket_emptier_tick_callback();
-                pending_draw = true;
-            }
-
-            // Check for timeout.
-            auto now = g_get_monotonic_time();
-            auto elapsed = now - start_time;
-            if (elapsed > prefs.render_time_limit) {
-                // Timed out. Temporarily return to GTK main loop, and come back here when next idle.
-                if (prefs.debug_logging) std::cout << "Timed out: " << g_get_monotonic_time() - start_time << " us" << std::endl;
-                framecheckobj.subtype = 1;
-                return true;
+            // Queue the rectangle for painting, painting the queue once there is a rectangle for every thread.
+            // (Rectangles are taken from the heap closest-first, so each batch is painted in priority order.)
+            batch.emplace_back(rect);
+            if (batch.size() >= (size_t)batch_size) {
+                if (flush_batch()) return true;
             }
         }
 
-        // No timeout.
-        return false;
+        // Paint whatever is left over.
+        return flush_batch();
     };
 
     if (auto vis_store = regularised(visible & store->rect)) {
@@ -4042,11 +4084,71 @@ bool CanvasPrivate::on_idle()
     }
 }
 
-void CanvasPrivate::paint_rect(const Geom::IntRect &rect)
+// Return the number of rectangles that may be painted at once, each on its own thread.
+int CanvasPrivate::get_render_threads() const
+{
+#if HAVE_OPENMP
+    // The outline store requires switching the render mode of the whole drawing, and colour management
+    // transforms are looked up lazily, so in both cases rendering stays on the main thread.
+    if (need_outline_store() || q->_cms_active) {
+        return 1;
+    }
+    return std::min<int>(prefs.render_threads, omp_get_num_procs());
+#else
+    return 1;
+#endif
+}
+
+// Paint a list of rectangles, which must all lie within the store.
+// If multiple threads are available, each rectangle is drawn by a worker into a surface of its own,
+// and the results are then pasted onto the store on the main thread in the order given.
+void CanvasPrivate::paint_rects(std::vector<Geom::IntRect> const &rects)
+{
+    if (rects.size() == 1) {
+        paint_rect(rects.front());
+        return;
+    }
+
+    // Bring the drawing up-to-date on the main thread, as the workers must not modify it.
+    q->_drawing->setColorMode(q->_color_mode);
+    q->_drawing->update();
+
+    bool const need_background = !q->get_opengl_enabled() && crstate()->solid_colour;
+    int const count = rects.size();
+    std::vector<Cairo::RefPtr<Cairo::ImageSurface>> surfaces(count);
+
+#if HAVE_OPENMP
+    #pragma omp parallel for schedule(dynamic, 1) num_threads(count)
+#endif
+    for (int i = 0; i < count; i++) {
+        auto const &rect = rects[i];
+        auto surface = Cairo::ImageSurface::create(Cairo::FORMAT_ARGB32, rect.width() * device_scale, rect.height() * device_scale);
+        cairo_surface_set_device_scale(surface->cobj(), device_scale, device_scale); // No C++ API!
+        paint_single_buffer(surface, rect, need_background, true);
+        surfaces[i] = std::move(surface);
+    }
+
+    for (int i = 0; i < count; i++) {
+        paint_rect(rects[i], surfaces[i]);
+    }
+}
+
+// Paint a rectangle, which must lie within the store. If content is given, it is used instead of rendering
+// the rectangle, and the outline store (if any) is not painted.
+void CanvasPrivate::paint_rect(const Geom::IntRect &rect, const Cairo::RefPtr<Cairo::ImageSurface> &content)
 {
     // Make sure the paint rectangle lies within the store.
     auto store = graphics->get_store();
     assert(store->rect.contains(rect));
+    assert(!content || !need_outline_store());
+
+    // Copy pre-rendered content onto a surface covering exactly the rectangle.
+    auto paste_content = [&] (const Cairo::RefPtr<Cairo::ImageSurface> &surface) {
+        auto cr = Cairo::Context::create(surface);
+        cr->set_operator(Cairo::OPERATOR_SOURCE);
+        cr->set_source(content, 0, 0);
+        cr->paint();
+    };
 
     if (q->get_opengl_enabled()) {
         auto gl = glstate();
@@ -4057,7 +4159,11 @@ void CanvasPrivate::paint_rect(const Geom::IntRect &rect)
             cairo_surface_set_device_scale(surface->cobj(), device_scale, device_scale);
 
             // Actually draw the content with Cairo.
-            paint_single_buffer(surface, rect, false);
+            if (content) {
+                paste_content(surface);
+            } else {
+                paint_single_buffer(surface, rect, false);
+            }
 
             // Convert the surface to a texture.
             return gl->pixelstreamer->finish(std::move(surface));
@@ -4070,7 +4176,7 @@ void CanvasPrivate::paint_rect(const Geom::IntRect &rect)
 
         GLFragment glfragment;
 
-        q->_drawing->setColorMode(q->_color_mode);
+        if (!content) q->_drawing->setColorMode(q->_color_mode);
         glfragment.texture = paint_to_texture();
 
         if (need_outline_store()) {
@@ -4139,12 +4245,16 @@ void CanvasPrivate::paint_rect(const Geom::IntRect &rect)
 
             cairo_surface_set_device_scale(imgs->cobj(), device_scale, device_scale); // No C++ API!
 
-            paint_single_buffer(imgs, rect, normal_content);
+            if (content) {
+                paste_content(imgs);
+            } else {
+                paint_single_buffer(imgs, rect, normal_content);
+            }
 
             surface->mark_dirty();
         };
 
-        q->_drawing->setColorMode(q->_color_mode);
+        if (!content) q->_drawing->setColorMode(q->_color_mode);
         paint_to_surface(cs->store.surface, crstate()->solid_colour);
 
         if (need_outline_store()) {
@@ -4155,7 +4265,9 @@ void CanvasPrivate::paint_rect(const Geom::IntRect &rect)
     }
 }
 
-void CanvasPrivate::paint_single_buffer(const Cairo::RefPtr<Cairo::ImageSurface> &surface, const Geom::IntRect &rect, bool need_background)
+// Render the content of a rectangle onto a surface of the same size. If concurrent is true, this may be called
+// from several worker threads at once, so must only read shared state.
+void CanvasPrivate::paint_single_buffer(const Cairo::RefPtr<Cairo::ImageSurface> &surface, const Geom::IntRect &rect, bool need_background, bool concurrent)
 {
     // Create Cairo context.
     auto cr = Cairo::Context::create(surface);
@@ -4172,7 +4284,7 @@ void CanvasPrivate::paint_single_buffer(const Cairo::RefPtr<Cairo::ImageSurface>
 
     // Render drawing on top of background.
     if (q->_canvas_item_root->is_visible()) {
-        auto buf = Inkscape::CanvasItemBuffer{ rect, device_scale, cr };
+        auto buf = Inkscape::CanvasItemBuffer{ rect, device_scale, cr, concurrent };
         q->_canvas_item_root->render(&buf);
     }
 
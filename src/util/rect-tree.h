@@ -0,0 +1,253 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * A bounding volume hierarchy for fast lookup of rectangles by area or point.
+ */
+/*
+ * Authors:
+ *   See git history.
+ *
+ * Copyright (C) 2022 Authors
+ *
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+#ifndef INKSCAPE_UTIL_RECT_TREE_H
+#define INKSCAPE_UTIL_RECT_TREE_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <utility>
+#include <vector>
+#include <2geom/rect.h>
+
+namespace Inkscape {
+namespace Util {
+
+/**
+ * A RectTree<T> stores a sequence of (rectangle, value) entries and answers the question "which
+ * entries have a rectangle touching this area?" in logarithmic rather than linear time.
+ *
+ * Entries are identified by their position in the sequence given to build(), which is preserved,
+ * so that callers relying on an ordering of the entries (for example z-order) can recover it by
+ * sorting query results by index.
+ *
+ * The tree is built in one go. Afterwards, the rectangle of any entry can be changed with
+ * update(), which refits the bounds of the tree in logarithmic time. Entries may have an empty
+ * rectangle, in which case they are never reported. Since refitting degrades the quality of the
+ * tree, it is rebuilt automatically once as many updates have taken place as there are entries.
+ */
+template <typename T>
+class RectTree
+{
+public:
+    using Entry = std::pair<Geom::OptRect, T>;
+
+    RectTree() = default;
+    explicit RectTree(std::vector<Entry> entries) { build(std::move(entries)); }
+
+    /// Replace the contents of the tree.
+    void build(std::vector<Entry> entries)
+    {
+        _entries = std::move(entries);
+        _rebuild();
+    }
+
+    void clear()
+    {
+        _entries.clear();
+        _nodes.clear();
+        _order.clear();
+        _leaf_of.clear();
+        _updates = 0;
+    }
+
+    std::size_t size() const { return _entries.size(); }
+    bool empty() const { return _entries.empty(); }
+
+    Geom::OptRect const &rect(std::size_t i) const { return _entries[i].first; }
+    T const &value(std::size_t i) const { return _entries[i].second; }
+
+    /// The union of all rectangles in the tree.
+    Geom::OptRect bounds() const { return _nodes.empty() ? Geom::OptRect() : _nodes.front().bounds; }
+
+    /// Change the rectangle of the entry at position i.
+    void update(std::size_t i, Geom::OptRect const &rect)
+    {
+        assert(i < _entries.size());
+        if (_entries[i].first == rect) {
+            return;
+        }
+        _entries[i].first = rect;
+
+        if (++_updates > _entries.size()) {
+            _rebuild();
+            return;
+        }
+
+        for (auto n = _leaf_of[i]; n != NONE; n = _nodes[n].parent) {
+            _refit(n);
+        }
+    }
+
+    /**
+     * Call f(i) for the index i of every entry whose rectangle intersects the given rectangle.
+     * The order of the calls is unspecified.
+     */
+    template <typename F>
+    void visit(Geom::Rect const &area, F &&f) const
+    {
+        if (_nodes.empty()) {
+            return;
+        }
+
+        std::vector<std::size_t> stack{0};
+        while (!stack.empty()) {
+            auto const &node = _nodes[stack.back()];
+            stack.pop_back();
+
+            if (!node.bounds || !node.bounds->intersects(area)) {
+                continue;
+            }
+
+            if (node.leaf) {
+                for (auto k = node.begin; k < node.end; k++) {
+                    auto const i = _order[k];
+                    auto const &r = _entries[i].first;
+                    if (r && r->intersects(area)) {
+                        f(i);
+                    }
+                }
+            } else {
+                stack.push_back(node.left);
+                stack.push_back(node.right);
+            }
+        }
+    }
+
+    /// Return the indices of all entries whose rectangle intersects the given rectangle, in increasing order.
+    std::vector<std::size_t> query(Geom::Rect const &area) const
+    {
+        std::vector<std::size_t> result;
+        visit(area, [&] (std::size_t i) { result.push_back(i); });
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+    /// Return the indices of all entries whose rectangle, enlarged by expand, contains the given point, in increasing order.
+    std::vector<std::size_t> query(Geom::Point const &p, double expand = 0.0) const
+    {
+        auto area = Geom::Rect(p, p);
+        area.expandBy(expand);
+        return query(area);
+    }
+
+private:
+    static constexpr std::size_t NONE = -1;
+    static constexpr std::size_t LEAF_SIZE = 8;
+
+    struct Node
+    {
+        Geom::OptRect bounds;
+        std::size_t parent = NONE;
+        bool leaf = false;
+        std::size_t begin = 0, end = 0;  ///< For leaves: the range of _order covered by this leaf.
+        std::size_t left = 0, right = 0; ///< For internal nodes: the indices of the children.
+    };
+
+    std::vector<Entry> _entries;
+    std::vector<Node> _nodes;           ///< The tree, with the root at index 0.
+    std::vector<std::size_t> _order;    ///< The indices of the entries, permuted so that each leaf covers a contiguous range.
+    std::vector<std::size_t> _leaf_of;  ///< The leaf node containing each entry.
+    std::size_t _updates = 0;           ///< The number of updates since the last rebuild.
+
+    void _rebuild()
+    {
+        _nodes.clear();
+        _order.resize(_entries.size());
+        _leaf_of.assign(_entries.size(), NONE);
+        _updates = 0;
+
+        if (_entries.empty()) {
+            return;
+        }
+
+        for (std::size_t i = 0; i < _entries.size(); i++) {
+            _order[i] = i;
+        }
+
+        _nodes.reserve(2 * (_entries.size() / LEAF_SIZE + 1));
+        _build(0, _entries.size(), NONE);
+    }
+
+    Geom::Point _centre(std::size_t i) const
+    {
+        auto const &r = _entries[i].first;
+        return r ? r->midpoint() : Geom::Point(0, 0);
+    }
+
+    std::size_t _build(std::size_t begin, std::size_t end, std::size_t parent)
+    {
+        auto const n = _nodes.size();
+        _nodes.emplace_back();
+        _nodes[n].parent = parent;
+
+        if (end - begin <= LEAF_SIZE) {
+            _nodes[n].leaf = true;
+            _nodes[n].begin = begin;
+            _nodes[n].end = end;
+            for (auto k = begin; k < end; k++) {
+                _leaf_of[_order[k]] = n;
+            }
+            _refit(n);
+            return n;
+        }
+
+        // Split at the median of the centres along the axis in which they are most spread out.
+        Geom::OptRect centres;
+        for (auto k = begin; k < end; k++) {
+            centres.unionWith(Geom::Rect(_centre(_order[k]), _centre(_order[k])));
+        }
+        auto const axis = centres->width() >= centres->height() ? Geom::X : Geom::Y;
+        auto const mid = begin + (end - begin) / 2;
+        std::nth_element(_order.begin() + begin, _order.begin() + mid, _order.begin() + end,
+                         [&] (std::size_t a, std::size_t b) { return _centre(a)[axis] < _centre(b)[axis]; });
+
+        auto const left = _build(begin, mid, n);
+        auto const right = _build(mid, end, n);
+        _nodes[n].left = left;
+        _nodes[n].right = right;
+        _refit(n);
+        return n;
+    }
+
+    // Recompute the bounds of a node from its entries or children.
+    void _refit(std::size_t n)
+    {
+        auto &node = _nodes[n];
+        node.bounds = Geom::OptRect();
+        if (node.leaf) {
+            for (auto k = node.begin; k < node.end; k++) {
+                node.bounds.unionWith(_entries[_order[k]].first);
+            }
+        } else {
+            node.bounds.unionWith(_nodes[node.left].bounds);
+            node.bounds.unionWith(_nodes[node.right].bounds);
+        }
+    }
+};
+
+} // namespace Util
+} // namespace Inkscape
+
+#endif // INKSCAPE_UTIL_RECT_TREE_H
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
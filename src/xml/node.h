@@ -16,6 +16,7 @@
 #include <cassert>
 #include <vector>
 #include <list>
+#include <glib.h>
 #include <2geom/point.h>
 
 #include "gc-anchored.h"
@@ -149,6 +150,15 @@ public:
      */
     virtual char const *attribute(char const *key) const = 0;
 
+    /**
+     * @brief Get the string representation of a node's attribute by the quark of its name
+     *
+     * Like attribute(char const *), but skips converting the name to a quark.
+     *
+     * @param key The quark of the attribute's name, see g_quark_from_string()
+     */
+    virtual char const *attribute(GQuark key) const = 0;
+
     /**
      * @brief Get a list of the node's attributes
      *
@@ -211,6 +221,9 @@ public:
 
     void setAttribute(Util::const_char_ptr key, Util::const_char_ptr value);
 
+    /// Change an attribute of this node, given the quark of its name.
+    void setAttribute(GQuark key, Util::const_char_ptr value) { this->setAttributeImpl(key, value.data()); }
+
     /**
      * Parses the boolean value of an attribute "key" in repr and sets val accordingly, or to false if
      * the attr is not set.
@@ -607,6 +620,7 @@ protected:
     {}
 
     virtual void setAttributeImpl(char const *key, char const *value) = 0;
+    virtual void setAttributeImpl(GQuark key, char const *value) = 0;
 };
 
 } // namespace XML
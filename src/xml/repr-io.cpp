@@ -11,10 +11,16 @@
  * Released under GNU GPL v2+, read the file 'COPYING' for more information.
  */
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstring>
+#include <mutex>
 #include <string>
 #include <stdexcept>
+#include <thread>
 
+#include <glib/gstdio.h>
 #include <libxml/parser.h>
 #include <libxml/xinclude.h>
 
@@ -48,7 +54,9 @@ using Inkscape::XML::AttributeVector;
 using Inkscape::XML::rebase_href_attrs;
 
 Document *sp_repr_do_read (xmlDocPtr doc, const gchar *default_ns);
+static void sp_repr_finish_root (Node *root, const gchar *default_ns);
 static Node *sp_repr_svg_read_node (Document *xml_doc, xmlNodePtr node, const gchar *default_ns, std::map<std::string, std::string> &prefix_map);
+static Node *sp_repr_svg_read_element (Document *xml_doc, xmlNodePtr node, const gchar *default_ns, std::map<std::string, std::string> &prefix_map);
 static gint sp_repr_qualified_name (gchar *p, gint len, xmlNsPtr ns, const xmlChar *name, const gchar *default_ns, std::map<std::string, std::string> &prefix_map);
 static void sp_repr_write_stream_root_element(Node *repr, Writer &out,
                                               bool add_whitespace, gchar const *default_ns,
@@ -95,12 +103,16 @@ public:
 
     int setFile( char const * filename, bool load_entities );
 
+    int parseOptions() const;
     xmlDocPtr readXml();
+    xmlDocPtr readXml(xmlParserCtxtPtr ctxt, int parse_options);
 
     static int readCb( void * context, char * buffer, int len );
     static int closeCb( void * context );
 
     char const* getEncoding() const { return encoding; }
+    /// Bytes of the file read so far, which may be compressed. Can be read from any thread.
+    long getPosition() const { return position; }
     int read( char * buffer, int len );
     int close();
 private:
@@ -114,6 +126,7 @@ private:
     unsigned int cachedPos;
     Inkscape::IO::FileInputStream* instr;
     Inkscape::IO::GzipInputStream* gzin;
+    std::atomic<long> position{0};
 };
 
 int XmlSource::setFile(char const *filename, bool load_entities=false)
@@ -210,7 +223,7 @@ int XmlSource::setFile(char const *filename, bool load_entities=false)
     return retVal;
 }
 
-xmlDocPtr XmlSource::readXml()
+int XmlSource::parseOptions() const
 {
     int parse_options = XML_PARSE_HUGE | XML_PARSE_RECOVER;
 
@@ -221,8 +234,13 @@ xmlDocPtr XmlSource::readXml()
     // Allow NOENT only if we're filtering out SYSTEM and PUBLIC entities
     if (LoadEntities)     parse_options |= XML_PARSE_NOENT;
 
+    return parse_options;
+}
+
+xmlDocPtr XmlSource::readXml()
+{
     auto doc = xmlReadIO( readCb, closeCb, this,
-                      filename, getEncoding(), parse_options);
+                      filename, getEncoding(), parseOptions());
 
     if (doc && doc->properties && xmlXIncludeProcessFlags(doc, XML_PARSE_NOXINCNODE) < 0) {
         g_warning("XInclude processing failed for %s", filename);
@@ -231,6 +249,15 @@ xmlDocPtr XmlSource::readXml()
     return doc;
 }
 
+/**
+ * Parses with a prepared parser context, for example one with custom SAX handlers.
+ * Does not process XIncludes. Does not read preferences, so it can run on any thread.
+ */
+xmlDocPtr XmlSource::readXml(xmlParserCtxtPtr ctxt, int parse_options)
+{
+    return xmlCtxtReadIO(ctxt, readCb, closeCb, this, filename, getEncoding(), parse_options);
+}
+
 int XmlSource::readCb( void * context, char * buffer, int len )
 {
     int retVal = -1;
@@ -287,6 +314,8 @@ int XmlSource::read( char *buffer, int len )
         got = fread( buffer, 1, len, fp );
     }
 
+    position = ftell(fp);
+
     if ( feof(fp) ) {
         retVal = got;
     } else if ( ferror(fp) ) {
@@ -318,6 +347,223 @@ int XmlSource::close()
     return 0;
 }
 
+namespace Inkscape {
+namespace XML {
+
+namespace {
+thread_local ReadProgress *current_progress = nullptr;
+}
+
+ReadProgress::ReadProgress(std::function<void (double)> callback)
+    : _callback(std::move(callback))
+    , _outer(current_progress)
+{
+    current_progress = this;
+}
+
+ReadProgress::~ReadProgress()
+{
+    current_progress = _outer;
+}
+
+void ReadProgress::report(double fraction)
+{
+    if (current_progress && current_progress->_callback) {
+        current_progress->_callback(fraction);
+    }
+}
+
+} // namespace XML
+} // namespace Inkscape
+
+namespace {
+
+/// Smaller files are read on the calling thread alone; for them a thread costs more than it saves.
+gint64 const STAGED_READ_MIN_SIZE = 1 << 20;
+
+/**
+ * Reads a large file in two overlapping stages. On a worker thread, libxml2 tokenises the file
+ * and builds its tree, announcing each child of the root element once its subtree is complete.
+ * Meanwhile the calling thread turns the completed subtrees into repr nodes, which have to be
+ * created there because they are garbage collected.
+ */
+class StagedRead
+{
+public:
+    StagedRead(XmlSource &src, const gchar *default_ns, gint64 size)
+        : _src(src)
+        , _default_ns(default_ns)
+        , _size(size)
+    {}
+
+    /// Returns the repr document, or null. \a doc receives the libxml2 document to be freed.
+    Document *read(xmlDocPtr &doc);
+
+private:
+    static void _endElementNs(void *ctx, const xmlChar *localname, const xmlChar *prefix, const xmlChar *uri);
+    void _parse(int parse_options);
+    void _convertUpTo(xmlNodePtr last);
+    void _reportProgress();
+
+    XmlSource &_src;
+    const gchar *_default_ns;
+    gint64 _size;
+
+    // Shared with the worker thread
+    xmlParserCtxtPtr _ctxt = nullptr;
+    endElementNsSAX2Func _end_element = nullptr;
+    std::mutex _mutex;
+    std::condition_variable _changed;
+    xmlNodePtr _completed = nullptr; ///< the last child of the root element with a complete subtree
+    xmlDocPtr _doc = nullptr;
+    bool _done = false;
+
+    // Calling thread only
+    Document *_rdoc = nullptr;
+    Node *_root = nullptr;
+    xmlNodePtr _root_node = nullptr;
+    xmlNodePtr _converted = nullptr; ///< the last child of the root element turned into a repr
+    std::map<std::string, std::string> _prefix_map;
+    int _percent = -1;
+};
+
+thread_local StagedRead *staged_read = nullptr;
+
+void StagedRead::_endElementNs(void *ctx, const xmlChar *localname, const xmlChar *prefix, const xmlChar *uri)
+{
+    auto ctxt = static_cast<xmlParserCtxtPtr>(ctx);
+    StagedRead *self = staged_read;
+    self->_end_element(ctx, localname, prefix, uri);
+
+    // Back in the root element, whose last child just ended. Entities are parsed with contexts
+    // of their own, whose nodes are copied later; those are not announced.
+    if (ctxt == self->_ctxt && ctxt->nodeNr == 1 && ctxt->node && ctxt->node->last &&
+        ctxt->node->last->type == XML_ELEMENT_NODE)
+    {
+        std::lock_guard<std::mutex> lock(self->_mutex);
+        self->_completed = ctxt->node->last;
+        self->_changed.notify_one();
+    }
+}
+
+void StagedRead::_parse(int parse_options)
+{
+    staged_read = this;
+    // libxml2 keeps its defaults per thread
+    xmlSubstituteEntitiesDefault(1);
+
+    // With XML_PARSE_RECOVER the document is kept even if it is not well-formed, so the nodes
+    // announced so far stay valid.
+    xmlDocPtr doc = _src.readXml(_ctxt, parse_options);
+    xmlFreeParserCtxt(_ctxt);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _doc = doc;
+    _done = true;
+    _changed.notify_one();
+}
+
+/**
+ * Appends the children of the root element up to \a last to the root repr, creating that first
+ * if needed. They precede a child whose subtree is complete, so they are complete as well, and
+ * the parser only touches nodes after them.
+ */
+void StagedRead::_convertUpTo(xmlNodePtr last)
+{
+    if (!_root) {
+        _root_node = last->parent;
+        _root = sp_repr_svg_read_element(_rdoc, _root_node, _default_ns, _prefix_map);
+    }
+    for (xmlNodePtr node = _converted ? _converted->next : _root_node->children;; node = node->next) {
+        if (Node *repr = sp_repr_svg_read_node(_rdoc, node, _default_ns, _prefix_map)) {
+            _root->appendChild(repr);
+            Inkscape::GC::release(repr);
+        }
+        if (node == last) {
+            break;
+        }
+    }
+    _converted = last;
+}
+
+void StagedRead::_reportProgress()
+{
+    int const percent = std::min<gint64>(100 * _src.getPosition() / _size, 100);
+    if (percent != _percent) {
+        _percent = percent;
+        Inkscape::XML::ReadProgress::report(percent / 100.0);
+    }
+}
+
+Document *StagedRead::read(xmlDocPtr &doc)
+{
+    doc = nullptr;
+    // Preferences may only be read here.
+    int const parse_options = _src.parseOptions();
+
+    xmlInitParser();
+    _ctxt = xmlNewParserCtxt();
+    if (!_ctxt) {
+        return nullptr;
+    }
+    _end_element = _ctxt->sax->endElementNs;
+    _ctxt->sax->endElementNs = &StagedRead::_endElementNs;
+
+    _rdoc = new Inkscape::XML::SimpleDocument();
+
+    std::thread parser(&StagedRead::_parse, this, parse_options);
+    xmlNodePtr last = nullptr;
+    bool done = false;
+    while (!done) {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            // Wake up now and then to report progress within a large subtree.
+            _changed.wait_for(lock, std::chrono::milliseconds(100), [&] { return _done || _completed != last; });
+            done = _done;
+            last = _completed;
+        }
+        if (last && last != _converted) {
+            _convertUpTo(last);
+        }
+        _reportProgress();
+    }
+    parser.join();
+
+    doc = _doc;
+    xmlNodePtr const root_node = doc ? xmlDocGetRootElement(doc) : nullptr;
+    int const xincludes = doc && doc->properties ? xmlXIncludeProcessFlags(doc, XML_PARSE_NOXINCNODE) : 0;
+    if (xincludes < 0) {
+        g_warning("XInclude processing failed for %s", reinterpret_cast<const char *>(doc->URL));
+    }
+    if (!root_node || root_node != _root_node || xincludes > 0) {
+        // Nothing was converted, or the tree has changed since: read it all again.
+        if (_root) {
+            Inkscape::GC::release(_root);
+        }
+        Inkscape::GC::release(_rdoc);
+        return sp_repr_do_read(doc, _default_ns);
+    }
+
+    for (xmlNodePtr node = doc->children; node != nullptr; node = node->next) {
+        if (node == _root_node) {
+            if (_converted->next) {
+                _convertUpTo(_root_node->last);
+            }
+            _rdoc->appendChild(_root);
+            Inkscape::GC::release(_root);
+        } else if (node->type == XML_COMMENT_NODE || node->type == XML_PI_NODE) {
+            Node *repr = sp_repr_svg_read_node(_rdoc, node, _default_ns, _prefix_map);
+            _rdoc->appendChild(repr);
+            Inkscape::GC::release(repr);
+        }
+    }
+
+    sp_repr_finish_root(_root, _default_ns);
+    return _rdoc;
+}
+
+} // namespace
+
 /**
  * Reads XML from a file, and returns the Document.
  * The default namespace can also be specified, if desired.
@@ -348,11 +594,18 @@ Document *sp_repr_read_file (const gchar * filename, const gchar *default_ns)
 
     Inkscape::IO::dump_fopen_call(filename, "N");
 
+    GStatBuf st;
+    bool const staged = g_stat(localFilename, &st) == 0 && st.st_size >= STAGED_READ_MIN_SIZE;
+
     XmlSource src;
 
     if (src.setFile(filename) == 0) {
-        doc = src.readXml();
-        rdoc = sp_repr_do_read(doc, default_ns);
+        if (staged) {
+            rdoc = StagedRead(src, default_ns, st.st_size).read(doc);
+        } else {
+            doc = src.readXml();
+            rdoc = sp_repr_do_read(doc, default_ns);
+        }
         // For some reason, failed ns loading results in this
         // We try a system check version of load with NOENT for adobe
         if (rdoc && strcmp(rdoc->root()->name(), "ns:svg") == 0) {
@@ -499,31 +752,39 @@ Document *sp_repr_do_read (xmlDocPtr doc, const gchar *default_ns)
     }
 
     if (root != nullptr) {
-        /* promote elements of some XML documents that don't use namespaces
-         * into their default namespace */
-        if ( default_ns && !strchr(root->name(), ':') ) {
-            if ( !strcmp(default_ns, SP_SVG_NS_URI) ) {
-                promote_to_namespace(root, "svg");
-            }
-            if ( !strcmp(default_ns, INKSCAPE_EXTENSION_URI) ) {
-                promote_to_namespace(root, INKSCAPE_EXTENSION_NS_NC);
-            }
-        }
+        sp_repr_finish_root(root, default_ns);
+    }
 
+    return rdoc;
+}
 
-        // Clean unnecessary attributes and style properties from SVG documents. (Controlled by
-        // preferences.)  Note: internal Inkscape svg files will also be cleaned (filters.svg,
-        // icons.svg). How can one tell if a file is internal?
-        if ( !strcmp(root->name(), "svg:svg" ) ) {
-            Inkscape::Preferences *prefs = Inkscape::Preferences::get();
-            bool clean = prefs->getBool("/options/svgoutput/check_on_reading");
-            if( clean ) {
-                sp_attribute_clean_tree( root );
-            }
+/**
+ * Brings the root element of a document that was just read into shape.
+ */
+static void sp_repr_finish_root (Node *root, const gchar *default_ns)
+{
+    /* promote elements of some XML documents that don't use namespaces
+     * into their default namespace */
+    if ( default_ns && !strchr(root->name(), ':') ) {
+        if ( !strcmp(default_ns, SP_SVG_NS_URI) ) {
+            promote_to_namespace(root, "svg");
+        }
+        if ( !strcmp(default_ns, INKSCAPE_EXTENSION_URI) ) {
+            promote_to_namespace(root, INKSCAPE_EXTENSION_NS_NC);
         }
     }
 
-    return rdoc;
+
+    // Clean unnecessary attributes and style properties from SVG documents. (Controlled by
+    // preferences.)  Note: internal Inkscape svg files will also be cleaned (filters.svg,
+    // icons.svg). How can one tell if a file is internal?
+    if ( !strcmp(root->name(), "svg:svg" ) ) {
+        Inkscape::Preferences *prefs = Inkscape::Preferences::get();
+        bool clean = prefs->getBool("/options/svgoutput/check_on_reading");
+        if( clean ) {
+            sp_attribute_clean_tree( root );
+        }
+    }
 }
 
 gint sp_repr_qualified_name (gchar *p, gint len, xmlNsPtr ns, const xmlChar *name, const gchar */*default_ns*/, std::map<std::string, std::string> &prefix_map)
@@ -552,9 +813,7 @@ gint sp_repr_qualified_name (gchar *p, gint len, xmlNsPtr ns, const xmlChar *nam
 
 static Node *sp_repr_svg_read_node (Document *xml_doc, xmlNodePtr node, const gchar *default_ns, std::map<std::string, std::string> &prefix_map)
 {
-    xmlAttrPtr prop;
     xmlNodePtr child;
-    gchar c[256];
 
     if (node->type == XML_TEXT_NODE || node->type == XML_CDATA_SECTION_NODE) {
 
@@ -593,6 +852,27 @@ static Node *sp_repr_svg_read_node (Document *xml_doc, xmlNodePtr node, const gc
         return nullptr;
     }
 
+    Node *repr = sp_repr_svg_read_element(xml_doc, node, default_ns, prefix_map);
+
+    for (child = node->xmlChildrenNode; child != nullptr; child = child->next) {
+        Node *crepr = sp_repr_svg_read_node (xml_doc, child, default_ns, prefix_map);
+        if (crepr) {
+            repr->appendChild(crepr);
+            Inkscape::GC::release(crepr);
+        }
+    }
+
+    return repr;
+}
+
+/**
+ * Creates the repr of an element node with its attributes and content, but not its children.
+ */
+static Node *sp_repr_svg_read_element (Document *xml_doc, xmlNodePtr node, const gchar *default_ns, std::map<std::string, std::string> &prefix_map)
+{
+    xmlAttrPtr prop;
+    gchar c[256];
+
     sp_repr_qualified_name (c, 256, node->ns, node->name, default_ns, prefix_map);
     Node *repr = xml_doc->createElement(c);
     /* TODO remember node->ns->prefix if node->ns != NULL */
@@ -609,14 +889,6 @@ static Node *sp_repr_svg_read_node (Document *xml_doc, xmlNodePtr node, const gc
         repr->setContent(reinterpret_cast<gchar*>(node->content));
     }
 
-    for (child = node->xmlChildrenNode; child != nullptr; child = child->next) {
-        Node *crepr = sp_repr_svg_read_node (xml_doc, child, default_ns, prefix_map);
-        if (crepr) {
-            repr->appendChild(crepr);
-            Inkscape::GC::release(crepr);
-        }
-    }
-
     return repr;
 }
 
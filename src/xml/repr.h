@@ -15,6 +15,7 @@
 #ifndef SEEN_SP_REPR_H
 #define SEEN_SP_REPR_H
 
+#include <functional>
 #include <vector>
 #include <glibmm/quark.h>
 
@@ -38,6 +39,30 @@ namespace Inkscape {
 namespace IO {
 class Writer;
 } // namespace IO
+
+namespace XML {
+
+/**
+ * Receives the progress of sp_repr_read_file() on this thread while it exists, as a fraction of
+ * the file read. Only large files report progress. The callback runs on the reading thread, so it
+ * may update the user interface.
+ */
+class ReadProgress
+{
+public:
+    explicit ReadProgress(std::function<void (double)> callback);
+    ~ReadProgress();
+    ReadProgress(ReadProgress const &) = delete;
+    ReadProgress &operator=(ReadProgress const &) = delete;
+
+    static void report(double fraction);
+
+private:
+    std::function<void (double)> _callback;
+    ReadProgress *_outer; ///< the progress this one hides, restored on destruction
+};
+
+} // namespace XML
 } // namespace Inkscape
 
 namespace Geom {
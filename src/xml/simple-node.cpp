@@ -19,6 +19,7 @@
 // clang-format on
 
 #include <algorithm>
+#include <cstdint>
 #include <cstring>
 #include <string>
 
@@ -171,7 +172,8 @@ using Util::share_unsafe;
 
 SimpleNode::SimpleNode(int code, Document *document)
 : Node(), _name(code), _attributes(), _child_count(0),
-  _cached_positions_valid(false)
+  _child_tree(nullptr), _tree_parent(nullptr), _tree_left(nullptr), _tree_right(nullptr),
+  _tree_size(1)
 {
     g_assert(document != nullptr);
 
@@ -184,10 +186,10 @@ SimpleNode::SimpleNode(int code, Document *document)
 
 SimpleNode::SimpleNode(SimpleNode const &node, Document *document)
 : Node(),
-  _cached_position(node._cached_position),
   _name(node._name), _attributes(), _content(node._content),
   _child_count(node._child_count),
-  _cached_positions_valid(node._cached_positions_valid)
+  _child_tree(nullptr), _tree_parent(nullptr), _tree_left(nullptr), _tree_right(nullptr),
+  _tree_size(1)
 {
     g_assert(document != nullptr);
 
@@ -208,11 +210,13 @@ SimpleNode::SimpleNode(SimpleNode const &node, Document *document)
             _first_child = child_copy;
         }
         _last_child = child_copy;
+        _child_tree = _treeMerge(_child_tree, child_copy);
 
         child_copy->release(); // release to avoid a leak
     }
 
     _attributes = node._attributes;
+    _attribute_index = node._attribute_index;
 
     _observers.add(_subtree_observers);
 }
@@ -228,43 +232,193 @@ gchar const *SimpleNode::content() const {
 gchar const *SimpleNode::attribute(gchar const *name) const {
     g_return_val_if_fail(name != nullptr, NULL);
 
-    GQuark const key = g_quark_from_string(name);
+    // A name that was never made into a quark can't be the name of an attribute.
+    GQuark const key = g_quark_try_string(name);
+    return key ? attribute(key) : nullptr;
+}
 
-    for (const auto & iter : _attributes)
-    {
-        if ( iter.key == key ) {
-            return iter.value;
+gchar const *SimpleNode::attribute(GQuark key) const {
+    AttributeRecord const *record = _findAttribute(key);
+    return record ? record->value : nullptr;
+}
+
+AttributeRecord *SimpleNode::_findAttribute(GQuark key) {
+    if (!_attribute_index.empty()) {
+        auto const found = _attribute_index.find(key);
+        return found != _attribute_index.end() ? &_attributes[found->second] : nullptr;
+    }
+    for (auto &record : _attributes) {
+        if (record.key == key) {
+            return &record;
         }
     }
-
     return nullptr;
 }
 
+void SimpleNode::_appendAttribute(GQuark key, ptr_shared value) {
+    _attributes.emplace_back(key, value);
+    if (!_attribute_index.empty()) {
+        _attribute_index.emplace(key, _attributes.size() - 1);
+    } else if (_attributes.size() > ATTRIBUTE_INDEX_THRESHOLD) {
+        _attribute_index.reserve(_attributes.size() * 2);
+        for (unsigned i = 0; i < _attributes.size(); ++i) {
+            _attribute_index.emplace(_attributes[i].key, i);
+        }
+    }
+}
+
+void SimpleNode::_eraseAttribute(AttributeRecord *record) {
+    unsigned const position = record - _attributes.data();
+    _attributes.erase(_attributes.begin() + position);
+    if (_attribute_index.empty()) {
+        return;
+    }
+    if (_attributes.size() <= ATTRIBUTE_INDEX_THRESHOLD) {
+        _attribute_index.clear();
+        return;
+    }
+    for (auto it = _attribute_index.begin(); it != _attribute_index.end();) {
+        if (it->second == position) {
+            it = _attribute_index.erase(it);
+        } else {
+            if (it->second > position) {
+                --it->second;
+            }
+            ++it;
+        }
+    }
+}
+
 unsigned SimpleNode::position() const {
     g_return_val_if_fail(_parent != nullptr, 0);
     return _parent->_childPosition(*this);
 }
 
 unsigned SimpleNode::_childPosition(SimpleNode const &child) const {
-    if (!_cached_positions_valid) {
-        unsigned position=0;
-        for ( SimpleNode *sibling = _first_child ;
-              sibling ; sibling = sibling->_next )
-        {
-            sibling->_cached_position = position;
-            position++;
+    // Count the nodes before the child in the treap, walking up to the root.
+    unsigned position = child._tree_left ? child._tree_left->_tree_size : 0;
+    for (SimpleNode const *node = &child; node->_tree_parent; node = node->_tree_parent) {
+        SimpleNode const *parent = node->_tree_parent;
+        if (parent->_tree_right == node) {
+            position += (parent->_tree_left ? parent->_tree_left->_tree_size : 0) + 1;
         }
-        _cached_positions_valid = true;
     }
-    return child._cached_position;
+    return position;
 }
 
 Node *SimpleNode::nthChild(unsigned index) {
-    SimpleNode *child = _first_child;
-    for ( ; index > 0 && child ; child = child->_next ) {
-        index--;
+    if (index >= _child_count) {
+        return nullptr;
+    }
+    if (index == _child_count - 1) {
+        return _last_child;
+    }
+    SimpleNode *node = _child_tree;
+    while (node) {
+        unsigned const before = node->_tree_left ? node->_tree_left->_tree_size : 0;
+        if (index < before) {
+            node = node->_tree_left;
+        } else if (index == before) {
+            return node;
+        } else {
+            index -= before + 1;
+            node = node->_tree_right;
+        }
+    }
+    return nullptr;
+}
+
+namespace {
+
+/// Treap priority of a node: a hash of its address, which is as good as a random number here.
+std::uint64_t tree_priority(SimpleNode const *node) {
+    auto x = static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(node));
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdull;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ull;
+    x ^= x >> 33;
+    return x;
+}
+
+} // namespace
+
+/// Joins two treaps, all of whose nodes in \a left come before those in \a right.
+SimpleNode *SimpleNode::_treeMerge(SimpleNode *left, SimpleNode *right) {
+    if (!left) {
+        return right;
+    }
+    if (!right) {
+        return left;
+    }
+    SimpleNode *root;
+    if (tree_priority(left) > tree_priority(right)) {
+        root = left;
+        root->_tree_right = _treeMerge(left->_tree_right, right);
+        root->_tree_right->_tree_parent = root;
+    } else {
+        root = right;
+        root->_tree_left = _treeMerge(left, right->_tree_left);
+        root->_tree_left->_tree_parent = root;
+    }
+    root->_tree_size = 1 + (root->_tree_left ? root->_tree_left->_tree_size : 0) +
+                       (root->_tree_right ? root->_tree_right->_tree_size : 0);
+    root->_tree_parent = nullptr;
+    return root;
+}
+
+/// Splits a treap into its first \a count nodes and the rest.
+void SimpleNode::_treeSplit(SimpleNode *tree, unsigned count, SimpleNode *&left, SimpleNode *&right) {
+    if (!tree) {
+        left = right = nullptr;
+        return;
+    }
+    unsigned const before = tree->_tree_left ? tree->_tree_left->_tree_size : 0;
+    if (before < count) {
+        _treeSplit(tree->_tree_right, count - before - 1, tree->_tree_right, right);
+        if (tree->_tree_right) {
+            tree->_tree_right->_tree_parent = tree;
+        }
+        left = tree;
+    } else {
+        _treeSplit(tree->_tree_left, count, left, tree->_tree_left);
+        if (tree->_tree_left) {
+            tree->_tree_left->_tree_parent = tree;
+        }
+        right = tree;
+    }
+    tree->_tree_size = 1 + (tree->_tree_left ? tree->_tree_left->_tree_size : 0) +
+                       (tree->_tree_right ? tree->_tree_right->_tree_size : 0);
+    tree->_tree_parent = nullptr;
+}
+
+void SimpleNode::_treeInsert(SimpleNode *child, unsigned position) {
+    child->_tree_parent = child->_tree_left = child->_tree_right = nullptr;
+    child->_tree_size = 1;
+    SimpleNode *left, *right;
+    _treeSplit(_child_tree, position, left, right);
+    _child_tree = _treeMerge(_treeMerge(left, child), right);
+}
+
+void SimpleNode::_treeRemove(SimpleNode *child) {
+    // Replace the child by the merge of its subtrees, and shrink the subtrees above it.
+    SimpleNode *const parent = child->_tree_parent;
+    SimpleNode *const merged = _treeMerge(child->_tree_left, child->_tree_right);
+    if (merged) {
+        merged->_tree_parent = parent;
+    }
+    if (!parent) {
+        _child_tree = merged;
+    } else if (parent->_tree_left == child) {
+        parent->_tree_left = merged;
+    } else {
+        parent->_tree_right = merged;
+    }
+    for (SimpleNode *node = parent; node; node = node->_tree_parent) {
+        node->_tree_size--;
     }
-    return child;
+    child->_tree_parent = child->_tree_left = child->_tree_right = nullptr;
+    child->_tree_size = 1;
 }
 
 bool SimpleNode::matchAttributeName(gchar const *partial_name) const {
@@ -318,13 +472,23 @@ SimpleNode::setAttributeImpl(gchar const *name, gchar const *value)
     // sanity check: `name` must not contain whitespace
     g_assert(std::none_of(name, name + strlen(name), [](char c) { return g_ascii_isspace(c); }));
 
+    setAttributeImpl(g_quark_from_string(name), value);
+}
+
+void
+SimpleNode::setAttributeImpl(GQuark key, gchar const *value)
+{
+    g_return_if_fail(key != 0);
+
+    gchar const *name = g_quark_to_string(key);
+
     // Check usefulness of attributes on elements in the svg namespace, optionally don't add them to tree.
-    Glib::ustring element = g_quark_to_string(_name);
-    //g_message("setAttribute:  %s: %s: %s", element.c_str(), name, value);
+    gchar const *element = g_quark_to_string(_name);
+    //g_message("setAttribute:  %s: %s: %s", element, name, value);
     gchar* cleaned_value = g_strdup( value );
 
     // Only check elements in SVG name space and don't block setting attribute to NULL.
-    if( element.substr(0,4) == "svg:" && value != nullptr) {
+    if( std::strncmp(element, "svg:", 4) == 0 && value != nullptr) {
 
         Inkscape::Preferences *prefs = Inkscape::Preferences::get();
         if( prefs->getBool("/options/svgoutput/check_on_editing") ) {
@@ -358,15 +522,7 @@ SimpleNode::setAttributeImpl(gchar const *name, gchar const *value)
         }
     }
 
-    GQuark const key = g_quark_from_string(name);
-
-    AttributeRecord *ref = nullptr;
-    for ( auto & existing : _attributes ) {
-        if ( existing.key == key ) {
-            ref = &existing;
-            break;
-        }
-    }
+    AttributeRecord *ref = _findAttribute(key);
     Debug::EventTracker<> tracker;
 
     ptr_shared old_value=( ref ? ref->value : ptr_shared() );
@@ -376,14 +532,14 @@ SimpleNode::setAttributeImpl(gchar const *name, gchar const *value)
         new_value = share_string(cleaned_value);
         tracker.set<DebugSetAttribute>(*this, key, new_value);
         if (!ref) {
-	    _attributes.emplace_back(key, new_value);
+            _appendAttribute(key, new_value);
         } else {
             ref->value = new_value;
         }
     } else { //clearing attribute
         tracker.set<DebugClearAttribute>(*this, key);
         if (ref) {
-	    _attributes.erase(std::find(_attributes.begin(),_attributes.end(),(*ref)));
+            _eraseAttribute(ref);
         }
     }
 
@@ -423,6 +579,9 @@ void SimpleNode::addChild(Node *generic_child, Node *generic_ref) {
 
     Debug::EventTracker<DebugAddChild> tracker(*this, *child, ref);
 
+    // appending needs no position lookup
+    _treeInsert(child, !ref ? 0 : ref == _last_child ? _child_count : _childPosition(*ref) + 1);
+
     SimpleNode *next;
     if (ref) {
         next = ref->_next;
@@ -437,18 +596,8 @@ void SimpleNode::addChild(Node *generic_child, Node *generic_ref) {
 
     if (!next) { // appending?
         _last_child = child;
-        // set cached position if possible when appending
-        if (!ref) {
-            // if !next && !ref, child is sole child
-            child->_cached_position = 0;
-            _cached_positions_valid = true;
-        } else if (_cached_positions_valid) {
-            child->_cached_position = ref->_cached_position + 1;
-        }
     } else {
         next->_prev = child;
-        // invalidate cached positions otherwise
-        _cached_positions_valid = false;
     }
 
     child->_setParent(this);
@@ -479,10 +628,9 @@ void SimpleNode::removeChild(Node *generic_child) {
     if (next) { // removing the last child?
         next->_prev = ref;
     } else {
-        // removing any other child invalidates the cached positions
         _last_child = ref;
-        _cached_positions_valid = false;
     }
+    _treeRemove(child);
 
     child->_next = nullptr;
     child->_prev = nullptr;
@@ -544,7 +692,8 @@ void SimpleNode::changeOrder(Node *generic_child, Node *generic_ref) {
         _last_child = child;
     }
 
-    _cached_positions_valid = false;
+    _treeRemove(child);
+    _treeInsert(child, ref ? _childPosition(*ref) + 1 : 0);
 
     _document->logger()->notifyChildOrderChanged(*this, *child, prev, ref);
     _observers.notifyChildOrderChanged(*this, *child, prev, ref);
@@ -556,14 +705,19 @@ void SimpleNode::setPosition(int pos) {
     // a position beyond the end of the list means the end of the list;
     // a negative position is the same as an infinitely large position
 
+    unsigned const siblings = _parent->_child_count - 1;
+    if (pos < 0 || static_cast<unsigned>(pos) > siblings) {
+        pos = siblings;
+    }
+
+    // the new previous sibling is the pos-th one of the siblings other than this node
     SimpleNode *ref=nullptr;
-    for ( SimpleNode *sibling = _parent->_first_child ;
-          sibling && pos ; sibling = sibling->_next )
-    {
-        if ( sibling != this ) {
-            ref = sibling;
-            pos--;
+    if (pos > 0) {
+        unsigned index = pos - 1;
+        if (index >= position()) {
+            index++;
         }
+        ref = dynamic_cast<SimpleNode *>(_parent->nthChild(index));
     }
 
     _parent->changeOrder(this, ref);
@@ -16,7 +16,9 @@
 #define SEEN_INKSCAPE_XML_SIMPLE_NODE_H
 
 #include <cassert>
+#include <functional>
 #include <iostream>
+#include <unordered_map>
 #include <vector>
 
 #include "xml/node.h"
@@ -82,6 +84,7 @@ public:
     void setPosition(int pos) override;
 
     char const *attribute(char const *key) const override;
+    char const *attribute(GQuark key) const override;
     bool matchAttributeName(char const *partial_name) const override;
 
     char const *content() const override;
@@ -127,30 +130,56 @@ protected:
 
     virtual SimpleNode *_duplicate(Document *doc) const=0;
     void setAttributeImpl(char const *key, char const *value) override;
+    void setAttributeImpl(GQuark key, char const *value) override;
 
 private:
     void operator=(Node const &); // no assign
 
+    /// Attributes beyond this count are found through _attribute_index rather than by a scan.
+    static constexpr std::size_t ATTRIBUTE_INDEX_THRESHOLD = 8;
+
+    using AttributeIndex = std::unordered_map<GQuark, unsigned, std::hash<GQuark>, std::equal_to<GQuark>,
+                                              Inkscape::GC::Alloc<std::pair<GQuark const, unsigned>, Inkscape::GC::AUTO>>;
+
     void _setParent(SimpleNode *parent);
     unsigned _childPosition(SimpleNode const &child) const;
 
+    // The children also form a treap ordered by position, which finds the n-th child and the
+    // position of a child in logarithmic time. Its nodes are the children themselves.
+    static SimpleNode *_treeMerge(SimpleNode *left, SimpleNode *right);
+    static void _treeSplit(SimpleNode *tree, unsigned count, SimpleNode *&left, SimpleNode *&right);
+    void _treeInsert(SimpleNode *child, unsigned position);
+    void _treeRemove(SimpleNode *child);
+
+    AttributeRecord *_findAttribute(GQuark key);
+    AttributeRecord const *_findAttribute(GQuark key) const {
+        return const_cast<SimpleNode *>(this)->_findAttribute(key);
+    }
+    void _appendAttribute(GQuark key, Inkscape::Util::ptr_shared value);
+    void _eraseAttribute(AttributeRecord *record);
+
     SimpleNode *_parent;
     SimpleNode *_next;
     SimpleNode *_prev;
     Document *_document;
-    mutable unsigned _cached_position;
 
     int _name;
 
-    AttributeVector _attributes;
+    AttributeVector _attributes; ///< in insertion order, which serialisation keeps
+    AttributeIndex _attribute_index; ///< positions in _attributes by key, once there are many
 
     Inkscape::Util::ptr_shared _content;
 
     unsigned _child_count;
-    mutable bool _cached_positions_valid;
     SimpleNode *_first_child;
     SimpleNode *_last_child;
 
+    SimpleNode *_child_tree;  ///< root of the treap of the children
+    SimpleNode *_tree_parent; ///< links of this node in the treap of its siblings
+    SimpleNode *_tree_left;
+    SimpleNode *_tree_right;
+    unsigned _tree_size;      ///< number of nodes in the subtree rooted here
+
     CompositeNodeObserver _observers;
     CompositeNodeObserver _subtree_observers;
 };
@@ -1,15 +1,34 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 /** @file
- * TODO: insert short description here
+ * Fuzz targets: document loading, and with FUZZ_PATH_DATA defined, SVG path data
  *//*
  * Authors: see git history
  *
  * Copyright (C) 2017 Authors
  * Released under GNU GPL v2+, read the file 'COPYING' for more information.
  */
+#include <string>
+
 #include "xml/repr.h"
 #include "inkscape.h"
 #include "document.h"
+#include "svg/svg.h"
+
+#ifdef FUZZ_PATH_DATA
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    // The parser reads up to the terminating null, as it does on attribute values.
+    std::string const d(reinterpret_cast<char const *>(data), size);
+    Geom::PathVector const pathv = sp_svg_read_pathv(d.c_str());
+    // Written paths must read back to the same structure.
+    Geom::PathVector const reread = sp_svg_read_pathv(sp_svg_write_path(pathv).c_str());
+    if (reread.size() != pathv.size()) {
+        abort();
+    }
+    return 0;
+}
+
+#else
 
 extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
     g_type_init();
@@ -20,3 +39,5 @@ extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
     auto doc = std::unique_ptr<SPDocument>(SPDocument::createNewDocFromMem((const char *)data, size, 0));
     return 0;
 }
+
+#endif
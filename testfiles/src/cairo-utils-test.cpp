@@ -1,6 +1,6 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 /** @file
- * Tests for classes like Pixbuf from cairo-utils
+ * Tests for classes like Pixbuf from cairo-utils, and for the pixel kernels of cairo-simd
  *//*
  * Authors: see git history
  *
@@ -10,6 +10,9 @@
  */
 
 #include <gtest/gtest.h>
+#include <random>
+#include <vector>
+#include <src/display/cairo-simd.h>
 #include <src/display/cairo-utils.h>
 #include <src/inkscape.h>
 
@@ -48,4 +51,56 @@ TEST_F(PixbufTest, creatingFromSvgUriWithoutViewboxOrWidthAndHeightReturnsNull)
     double default_dpi = 96.0;
 
     ASSERT_EQ(Inkscape::Pixbuf::create_from_data_uri(uri_data.c_str(), default_dpi), nullptr);
-}
\ No newline at end of file
+}
+
+// The vectorized row kernels must give exactly the same pixels as the scalar ones.
+TEST(CairoSimdTest, rowKernelsMatchScalarKernels)
+{
+    using namespace Inkscape::SIMD;
+
+    std::mt19937 gen(42);
+    auto random_pixel = [&] {
+        guint32 a = gen() % 256;
+        auto channel = [&] { return a ? guint32(gen() % (a + 1)) : 0u; };
+        return a << 24 | channel() << 16 | channel() << 8 | channel();
+    };
+    auto random_int = [&](int low, int high) { return low + int(gen() % (high - low + 1)); };
+
+    Level const best = get_level();
+    for (int iter = 0; iter < 200; ++iter) {
+        int n = random_int(0, 67);
+        std::vector<guint32> in1(n), in2(n), expected(n), actual(n);
+        for (int i = 0; i < n; ++i) {
+            in1[i] = random_pixel();
+            in2[i] = random_pixel();
+        }
+
+        gint32 k[4] = {random_int(-1000, 1000), random_int(-255000, 255000), random_int(-255000, 255000),
+                       random_int(-65025000, 65025000)};
+        gint32 matrix[20];
+        for (int i = 0; i < 20; ++i) {
+            matrix[i] = random_int(-500, 500) * (i % 5 == 4 ? 255 : 1);
+        }
+        double s = random_int(0, 1000) / 1000.0;
+        double saturate[9] = {0.213+0.787*s, 0.715-0.715*s, 0.072-0.072*s,
+                              0.213-0.213*s, 0.715+0.285*s, 0.072-0.072*s,
+                              0.213-0.213*s, 0.715-0.715*s, 0.072+0.928*s};
+
+        auto run = [&](std::vector<guint32> &out, int kernel) {
+            switch (kernel) {
+                case 0: compose_arithmetic_row(in1.data(), in2.data(), out.data(), n, k); break;
+                case 1: color_matrix_row(in1.data(), out.data(), n, matrix); break;
+                case 2: color_matrix_saturate_row(in1.data(), out.data(), n, saturate); break;
+                case 3: color_matrix_hue_rotate_row(in1.data(), out.data(), n, matrix); break;
+            }
+        };
+        for (int kernel = 0; kernel < 4; ++kernel) {
+            set_level(Level::NONE);
+            run(expected, kernel);
+            set_level(best);
+            run(actual, kernel);
+            EXPECT_EQ(expected, actual) << "kernel " << kernel << ", " << n << " pixels";
+        }
+    }
+    set_level(best);
+}
@@ -0,0 +1,100 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * SPDocument test
+ *//*
+ * Authors: see git history
+ *
+ * Copyright (C) 2022 Authors
+ *
+ * Released under GNU GPL version 2 or later, read the file 'COPYING' for more information
+ */
+
+#include <gtest/gtest.h>
+#include <2geom/transforms.h>
+#include <src/document.h>
+#include <src/inkscape.h>
+#include <src/object/sp-item.h>
+
+using namespace Inkscape;
+
+class SPDocumentTest : public ::testing::Test {
+  protected:
+    void SetUp() override
+    {
+        // setup hidden dependency
+        Application::create(false);
+
+        std::string svg("\
+<svg xmlns='http://www.w3.org/2000/svg' xmlns:inkscape='http://www.inkscape.org/namespaces/inkscape' width='100' height='100'>\
+    <g id='layer1' inkscape:groupmode='layer'>\
+        <rect id='rect1' width='10' height='10' />\
+        <g id='group1'>\
+            <rect id='rect2' x='20' width='10' height='10' />\
+            <rect id='rect3' x='40' width='10' height='10' />\
+        </g>\
+        <rect id='rect4' x='60' width='10' height='10' style='display:none' />\
+    </g>\
+</svg>");
+        doc.reset(SPDocument::createNewDocFromMem(svg.c_str(), svg.size(), true));
+        doc->ensureUpToDate();
+    }
+
+    std::vector<std::string> ids(std::vector<SPItem *> const &items)
+    {
+        std::vector<std::string> result;
+        for (auto item : items) {
+            result.emplace_back(item->getId());
+        }
+        return result;
+    }
+
+    std::unique_ptr<SPDocument> doc;
+};
+
+TEST_F(SPDocumentTest, getItemsInBox)
+{
+    auto const all = Geom::Rect(-1, -1, 101, 101);
+    using V = std::vector<std::string>;
+
+    EXPECT_EQ(ids(doc->getItemsInBox(0, all)), V({"rect1", "group1"}));
+    EXPECT_EQ(ids(doc->getItemsInBox(0, all, true)), V({"rect1", "group1", "rect4"}));
+    EXPECT_EQ(ids(doc->getItemsInBox(0, all, false, false, false, true)), V({"rect1", "rect2", "rect3"}));
+    EXPECT_EQ(ids(doc->getItemsInBox(0, all, false, false, true, true)), V({"rect1", "rect2", "rect3", "group1"}));
+    EXPECT_EQ(ids(doc->getItemsInBox(0, Geom::Rect(15, -1, 35, 11), false, false, true, true)), V({"rect2"}));
+    EXPECT_EQ(ids(doc->getItemsPartiallyInBox(0, Geom::Rect(15, -1, 35, 11))), V({"group1"}));
+}
+
+TEST_F(SPDocumentTest, getItemsInBoxFollowsChanges)
+{
+    auto const box = Geom::Rect(75, -1, 101, 11);
+    using V = std::vector<std::string>;
+
+    EXPECT_EQ(ids(doc->getItemsInBox(0, box, false, false, true, true)), V());
+
+    // Move an item into the box.
+    doc->getObjectById("rect3")->setAttribute("x", "80");
+    doc->ensureUpToDate();
+    EXPECT_EQ(ids(doc->getItemsInBox(0, box, false, false, true, true)), V({"rect3"}));
+
+    // Move a group, which moves its children too.
+    doc->getObjectById("group1")->setAttribute("transform", "translate(0,50)");
+    doc->ensureUpToDate();
+    EXPECT_EQ(ids(doc->getItemsInBox(0, box, false, false, true, true)), V());
+    EXPECT_EQ(ids(doc->getItemsInBox(0, box * Geom::Translate(0, 50), false, false, true, true)), V({"rect3"}));
+
+    // Remove an item.
+    doc->getObjectById("rect3")->deleteObject();
+    doc->ensureUpToDate();
+    EXPECT_EQ(ids(doc->getItemsInBox(0, box * Geom::Translate(0, 50), false, false, true, true)), V());
+}
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,213 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Tests for clones that share their drawing items
+ *//*
+ * Authors: see git history
+ *
+ * Copyright (C) 2022 Authors
+ *
+ * Released under GNU GPL version 2 or later, read the file 'COPYING' for more information
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <cairo.h>
+#include <gtest/gtest.h>
+#include <src/display/drawing-context.h>
+#include <src/display/drawing-instance.h>
+#include <src/display/drawing.h>
+#include <src/document.h>
+#include <src/inkscape.h>
+#include <src/object/sp-root.h>
+#include <src/object/sp-use.h>
+
+using namespace Inkscape;
+
+namespace {
+
+constexpr int SIZE = 200;
+
+/// A document shown in a drawing of its own, with or without sharing between clones.
+struct View
+{
+    std::unique_ptr<SPDocument> doc;
+    std::unique_ptr<Drawing> drawing;
+    unsigned key;
+
+    View(std::string const &svg, bool share)
+        : doc(SPDocument::createNewDocFromMem(svg.c_str(), svg.size(), true))
+        , drawing(std::make_unique<Drawing>())
+        , key(SPItem::display_key_new(1))
+    {
+        doc->ensureUpToDate();
+        drawing->setShareClones(share);
+        drawing->setRoot(doc->getRoot()->invoke_show(*drawing, key, SP_ITEM_SHOW_DISPLAY));
+        drawing->update();
+    }
+
+    ~View()
+    {
+        doc->getRoot()->invoke_hide(key);
+    }
+
+    SPUse *use(char const *id) const { return dynamic_cast<SPUse *>(doc->getObjectById(id)); }
+
+    void hide(char const *id) { use(id)->invoke_hide(key); }
+
+    void show(char const *id)
+    {
+        drawing->root()->appendChild(use(id)->invoke_show(*drawing, key, SP_ITEM_SHOW_DISPLAY));
+        drawing->update();
+    }
+
+    /// Returns the drawing items the child of the clone is shown with, or null if it has none.
+    DrawingItem *childItem(char const *id) const { return use(id)->child->get_arenaitem(key); }
+
+    std::vector<unsigned char> render() const
+    {
+        auto surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, SIZE, SIZE);
+        {
+            DrawingContext dc(surface, Geom::Point(0, 0));
+            drawing->render(dc, Geom::IntRect(0, 0, SIZE, SIZE));
+        }
+        cairo_surface_flush(surface);
+        auto const data = cairo_image_surface_get_data(surface);
+        std::vector<unsigned char> pixels(data, data + cairo_image_surface_get_stride(surface) * SIZE);
+        cairo_surface_destroy(surface);
+        return pixels;
+    }
+};
+
+/// Checks that the renderings differ by no more than antialiasing does between transforms.
+void expect_same_rendering(std::vector<unsigned char> const &a, std::vector<unsigned char> const &b)
+{
+    ASSERT_EQ(a.size(), b.size());
+    int worst = 0;
+    for (std::size_t i = 0; i < a.size(); i++) {
+        worst = std::max(worst, std::abs(int(a[i]) - int(b[i])));
+    }
+    EXPECT_LE(worst, 2);
+}
+
+// Clones a whole number of pixels apart, at fractional positions, scaled and rotated.
+std::string const svg("\
+<svg width='200' height='200' xmlns:xlink='http://www.w3.org/1999/xlink'>\
+  <defs>\
+    <symbol id='symbol1'>\
+      <rect width='12' height='8' fill='#ff0000' stroke='#000080' stroke-width='1.5' />\
+      <circle cx='6' cy='4' r='3' fill='#00ff00' fill-opacity='0.5' />\
+    </symbol>\
+  </defs>\
+  <use id='use0' xlink:href='#symbol1' x='10' y='10' />\
+  <use id='use1' xlink:href='#symbol1' x='40' y='10' />\
+  <use id='use2' xlink:href='#symbol1' x='70.25' y='10.5' />\
+  <use id='use3' xlink:href='#symbol1' x='100.7' y='13.3' />\
+  <use id='use4' xlink:href='#symbol1' transform='translate(20,60) scale(2.5)' />\
+  <use id='use5' xlink:href='#symbol1' transform='translate(120,60) rotate(30)' />\
+  <use id='use6' xlink:href='#symbol1' x='15' y='150' fill='#0000ff' />\
+  <use id='use7' xlink:href='#symbol1' x='150' y='150' />\
+</svg>");
+
+char const *const ids[] = {"use0", "use1", "use2", "use3", "use4", "use5", "use6", "use7"};
+
+} // namespace
+
+class DrawingInstanceTest : public ::testing::Test {
+  protected:
+    void SetUp() override
+    {
+        // setup hidden dependency
+        Application::create(false);
+    }
+};
+
+TEST_F(DrawingInstanceTest, SharedClonesRenderLikeUnshared)
+{
+    View shared(svg, true);
+    View unshared(svg, false);
+
+    // One clone shows its child for all the others of the same style; the blue one has its own.
+    auto source = dynamic_cast<DrawingSource *>(shared.childItem("use0")->parent());
+    ASSERT_TRUE(source != nullptr);
+    EXPECT_EQ(source->instanceCount(), 7u);
+    auto other = dynamic_cast<DrawingSource *>(shared.childItem("use6")->parent());
+    ASSERT_TRUE(other != nullptr);
+    EXPECT_EQ(other->instanceCount(), 1u);
+    for (auto id : ids) {
+        if (std::string(id) != "use0" && std::string(id) != "use6") {
+            EXPECT_EQ(shared.childItem(id), nullptr) << id;
+        }
+        EXPECT_TRUE(unshared.childItem(id) != nullptr) << id;
+    }
+
+    expect_same_rendering(shared.render(), unshared.render());
+}
+
+TEST_F(DrawingInstanceTest, HidingAndShowingTheOwningClone)
+{
+    View shared(svg, true);
+    View unshared(svg, false);
+
+    shared.hide("use0");
+    unshared.hide("use0");
+    shared.drawing->update();
+    unshared.drawing->update();
+
+    // Another clone took over showing the content.
+    EXPECT_EQ(shared.childItem("use0"), nullptr);
+    DrawingSource *source = nullptr;
+    for (auto id : ids) {
+        if (std::string(id) == "use6") {
+            continue;
+        }
+        if (auto item = shared.childItem(id)) {
+            ASSERT_EQ(source, nullptr) << "content shown twice";
+            source = dynamic_cast<DrawingSource *>(item->parent());
+        }
+    }
+    ASSERT_TRUE(source != nullptr);
+    EXPECT_EQ(source->instanceCount(), 6u);
+    expect_same_rendering(shared.render(), unshared.render());
+
+    shared.show("use0");
+    unshared.show("use0");
+    EXPECT_EQ(source->instanceCount(), 7u);
+    expect_same_rendering(shared.render(), unshared.render());
+
+    // Hiding every clone but one leaves a source with the last one.
+    for (auto id : ids) {
+        if (std::string(id) != "use7") {
+            shared.hide(id);
+            unshared.hide(id);
+        }
+    }
+    shared.drawing->update();
+    unshared.drawing->update();
+    auto last = shared.childItem("use7");
+    ASSERT_TRUE(last != nullptr);
+    source = dynamic_cast<DrawingSource *>(last->parent());
+    ASSERT_TRUE(source != nullptr);
+    EXPECT_EQ(source->instanceCount(), 1u);
+    expect_same_rendering(shared.render(), unshared.render());
+}
+
+TEST_F(DrawingInstanceTest, SharedClonesFollowZoom)
+{
+    View shared(svg, true);
+    View unshared(svg, false);
+
+    for (double scale : {0.5, 1.3, 2.0}) {
+        shared.drawing->root()->setTransform(Geom::Scale(scale));
+        unshared.drawing->root()->setTransform(Geom::Scale(scale));
+        shared.drawing->update(Geom::IntRect::infinite(), DrawingItem::STATE_ALL, DrawingItem::STATE_ALL);
+        unshared.drawing->update(Geom::IntRect::infinite(), DrawingItem::STATE_ALL, DrawingItem::STATE_ALL);
+        SCOPED_TRACE("scale " + std::to_string(scale));
+        expect_same_rendering(shared.render(), unshared.render());
+    }
+}
+
+// vim: filetype=cpp:expandtab:shiftwidth=4:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,96 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Tests for drawing text from cached glyph masks
+ *//*
+ * Authors: see git history
+ *
+ * Copyright (C) 2022 Authors
+ *
+ * Released under GNU GPL version 2 or later, read the file 'COPYING' for more information
+ */
+
+#include <cstdint>
+#include <string>
+
+#include <cairo.h>
+#include <gtest/gtest.h>
+#include <src/display/drawing-context.h>
+#include <src/display/drawing.h>
+#include <src/document.h>
+#include <src/inkscape.h>
+#include <src/object/sp-root.h>
+
+using namespace Inkscape;
+
+namespace {
+
+constexpr int WIDTH = 300;
+constexpr int HEIGHT = 60;
+
+/// Returns the total alpha of the document rendered with or without glyph masks.
+double render_alpha(SPDocument *doc, bool use_masks)
+{
+    Drawing drawing;
+    if (use_masks) {
+        drawing.setCacheBudget(64 << 20);
+    }
+    unsigned const key = SPItem::display_key_new(1);
+    drawing.setRoot(doc->getRoot()->invoke_show(drawing, key, SP_ITEM_SHOW_DISPLAY));
+    drawing.update();
+
+    auto surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, WIDTH, HEIGHT);
+    {
+        DrawingContext dc(surface, Geom::Point(0, 0));
+        drawing.render(dc, Geom::IntRect(0, 0, WIDTH, HEIGHT));
+    }
+    cairo_surface_flush(surface);
+    auto const data = cairo_image_surface_get_data(surface);
+    auto const stride = cairo_image_surface_get_stride(surface);
+    double alpha = 0;
+    for (int y = 0; y < HEIGHT; y++) {
+        auto const row = reinterpret_cast<std::uint32_t const *>(data + y * stride);
+        for (int x = 0; x < WIDTH; x++) {
+            alpha += row[x] >> 24;
+        }
+    }
+    cairo_surface_destroy(surface);
+
+    doc->getRoot()->invoke_hide(key);
+    return alpha;
+}
+
+} // namespace
+
+class DrawingTextTest : public ::testing::Test {
+  protected:
+    void SetUp() override
+    {
+        // setup hidden dependency
+        Application::create(false);
+    }
+};
+
+// Where glyphs overlap, a translucent fill must not get darker than where they don't, whether
+// the glyphs are drawn from masks or as one path. The masks are placed at a quarter pixel, so
+// only the total coverage is compared.
+TEST_F(DrawingTextTest, OverlappingTranslucentGlyphs)
+{
+    for (std::string fill : {"fill:#000000;fill-opacity:0.5", "fill:#2040ff;fill-opacity:0.4;fill-rule:evenodd"}) {
+        std::string svg("\
+<svg width='300' height='60'>\
+  <text x='5' y='40' style='font-family:sans-serif;font-size:28px;letter-spacing:-9px;" + fill + "'>\
+WWMMmmwwOOoo&#x0301;&#x0308;</text>\
+</svg>");
+        SPDocument *doc = SPDocument::createNewDocFromMem(svg.c_str(), svg.size(), true);
+        ASSERT_TRUE(doc != nullptr);
+        doc->ensureUpToDate();
+
+        double const path_alpha = render_alpha(doc, false);
+        double const mask_alpha = render_alpha(doc, true);
+        ASSERT_GT(path_alpha, 0);
+        SCOPED_TRACE(fill);
+        EXPECT_NEAR(mask_alpha / path_alpha, 1.0, 0.01);
+    }
+}
+
+// vim: filetype=cpp:expandtab:shiftwidth=4:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -16,6 +16,9 @@
 #include <src/live_effects/lpe-bool.h>
 #include <src/object/sp-ellipse.h>
 #include <src/object/sp-lpe-item.h>
+#include <src/object/sp-namedview.h>
+#include <src/object/sp-shape.h>
+#include <src/svg/svg.h>
 
 using namespace Inkscape;
 using namespace Inkscape::LivePathEffect;
@@ -162,4 +165,122 @@ TEST_F(LPETest, Bool_canBeApplyedToNonSiblingPaths)
     auto operand_path = lpe_bool_op_effect->getParameter("operand-path")->param_getSVGValue();
     auto circle = dynamic_cast<SPGenericEllipse *>(doc->getObjectById(operand_path.substr(1)));
     ASSERT_TRUE(circle != nullptr);
-}
\ No newline at end of file
+}
+// RESULT REUSE
+// The display unit is not part of the key the reused results are checked against, so the ruler
+// after a reused spiro result has to run again and match a fresh document with the new unit.
+TEST_F(LPETest, Stack_recomputedAfterDisplayUnitChange)
+{
+    auto make_svg = [](char const *units) {
+        return std::string("\
+<svg width='100' height='100'\
+  xmlns:sodipodi='http://sodipodi.sourceforge.net/DTD/sodipodi-0.dtd'\
+  xmlns:inkscape='http://www.inkscape.org/namespaces/inkscape'>\
+  <sodipodi:namedview id='namedview1' inkscape:document-units='") + units + "' />\
+  <defs>\
+    <inkscape:path-effect id='path-effect1' effect='spiro' lpeversion='1' />\
+    <inkscape:path-effect id='path-effect2' effect='ruler' unit='mm' mark_distance='5'\
+      mark_length='4' minor_mark_length='2' major_mark_steps='5' shift='0' offset='0'\
+      mark_dir='left' border_marks='both' lpeversion='1' />\
+  </defs>\
+  <path id='path1'\
+    inkscape:path-effect='#path-effect1;#path-effect2'\
+    inkscape:original-d='M 10,50 C 30,10 70,90 90,50'\
+    d='M 10,50 90,50' />\
+</svg>";
+    };
+
+    std::string svg = make_svg("px");
+    SPDocument *doc = SPDocument::createNewDocFromMem(svg.c_str(), svg.size(), true);
+    ASSERT_TRUE(doc != nullptr);
+    doc->ensureUpToDate();
+    auto lpe_item = dynamic_cast<SPLPEItem *>(doc->getObjectById("path1"));
+    ASSERT_TRUE(lpe_item != nullptr);
+    sp_lpe_item_update_patheffect(lpe_item, false, true);
+    std::string const before = lpe_item->getAttribute("d");
+
+    doc->getNamedView()->setDisplayUnit("mm");
+    sp_lpe_item_update_patheffect(lpe_item, false, true);
+    std::string const after = lpe_item->getAttribute("d");
+
+    std::string fresh_svg = make_svg("mm");
+    SPDocument *fresh = SPDocument::createNewDocFromMem(fresh_svg.c_str(), fresh_svg.size(), true);
+    ASSERT_TRUE(fresh != nullptr);
+    fresh->ensureUpToDate();
+    auto fresh_item = dynamic_cast<SPLPEItem *>(fresh->getObjectById("path1"));
+    ASSERT_TRUE(fresh_item != nullptr);
+    sp_lpe_item_update_patheffect(fresh_item, false, true);
+
+    EXPECT_NE(before, after);
+    EXPECT_EQ(after, fresh_item->getAttribute("d"));
+}
+
+// A cacheable stage is skipped while nothing in its key changes, and runs again when one of its
+// parameters, the transform of the item or its input path does. A result different from what
+// the effect computes is stored to tell the two apart.
+TEST_F(LPETest, PatternAlongPath_resultReusedUntilKeyChanges)
+{
+    std::string svg("\
+<svg width='100' height='100'\
+  xmlns:sodipodi='http://sodipodi.sourceforge.net/DTD/sodipodi-0.dtd'\
+  xmlns:inkscape='http://www.inkscape.org/namespaces/inkscape'>\
+  <defs>\
+    <inkscape:path-effect id='path-effect1' effect='skeletal' pattern='M 0,0 10,0 10,4 0,4 Z'\
+      copytype='repeated' prop_scale='1' scale_y_rel='false' spacing='0' normal_offset='0'\
+      tang_offset='0' prop_units='false' vertical_pattern='false' hide_knot='false'\
+      fuse_tolerance='0' lpeversion='1' />\
+  </defs>\
+  <g id='group1'>\
+    <path id='path1'\
+      inkscape:path-effect='#path-effect1'\
+      inkscape:original-d='M 10,50 C 30,10 70,90 90,50'\
+      d='M 10,50 90,50' />\
+  </g>\
+</svg>");
+
+    SPDocument *doc = SPDocument::createNewDocFromMem(svg.c_str(), svg.size(), true);
+    ASSERT_TRUE(doc != nullptr);
+    doc->ensureUpToDate();
+    auto lpe_item = dynamic_cast<SPShape *>(doc->getObjectById("path1"));
+    ASSERT_TRUE(lpe_item != nullptr);
+    auto lpe = lpe_item->getFirstPathEffectOfType(EffectType::PATTERN_ALONG_PATH);
+    ASSERT_TRUE(lpe != nullptr);
+
+    auto const run = [&] {
+        doc->ensureUpToDate();
+        sp_lpe_item_update_patheffect(lpe_item, false, true);
+        return lpe_item->curve()->get_pathvector();
+    };
+    auto const computed = run();
+    Geom::PathVector const stored = sp_svg_read_pathv("M 1,1 2,2 3,1");
+    auto const store = [&] {
+        lpe->storeResult(lpe_item, lpe->pathvector_before_effect, stored);
+    };
+
+    // Nothing changed: the stored result is shown.
+    Geom::PathVector cached;
+    ASSERT_TRUE(lpe->cachedResult(lpe_item, lpe->pathvector_before_effect, cached));
+    EXPECT_EQ(cached, computed);
+    store();
+    EXPECT_EQ(run(), stored);
+
+    // A parameter changed.
+    lpe->getRepr()->setAttribute("prop_scale", "2");
+    auto const scaled = run();
+    EXPECT_NE(scaled, stored);
+    EXPECT_NE(scaled, computed);
+    lpe->getRepr()->setAttribute("prop_scale", "1");
+    EXPECT_EQ(run(), computed);
+
+    // The transform of the item changed.
+    store();
+    doc->getObjectById("group1")->setAttribute("transform", "translate(5,7)");
+    EXPECT_EQ(run(), computed);
+
+    // The input path changed.
+    store();
+    lpe_item->setAttribute("inkscape:original-d", "M 10,50 C 30,20 70,80 90,50");
+    auto const reshaped = run();
+    EXPECT_NE(reshaped, stored);
+    EXPECT_NE(reshaped, computed);
+}
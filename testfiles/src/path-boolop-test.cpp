@@ -1,4 +1,5 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
+#include <cmath>
 #include <gtest/gtest.h>
 #include <src/path/path-boolop.h>
 #include <src/svg/svg.h>
@@ -83,4 +84,57 @@ TEST_F(PathBoolopTest, DifferenceOutside){
     comparePaths(pvRectangleDifference, pvBothPaths);
 }
 
+TEST_F(PathBoolopTest, IntersectionDistantSubpaths){
+    // test that subpaths far from the other operand do not change the intersection
+    Geom::PathVector pvWithDistant = pvRectangleBigger;
+    pvWithDistant.push_back(Geom::Path(Geom::Rect(100, 100, 102, 102)));
+    pvWithDistant.push_back(Geom::Path(Geom::Rect(-50, 0, -40, 10)));
+    Geom::PathVector pvRectangleIntersection = sp_pathvector_boolop(pvWithDistant, pvRectangleSmaller, bool_op_inters, fill_oddEven, fill_oddEven);
+    comparePaths(pvRectangleIntersection, pvRectangleSmaller);
+    pvRectangleIntersection = sp_pathvector_boolop(pvRectangleSmaller, pvWithDistant, bool_op_inters, fill_oddEven, fill_oddEven, true);
+    EXPECT_EQ(pvRectangleIntersection.size(), 1u);
+    EXPECT_EQ(pvRectangleIntersection.boundsExact(), pvRectangleSmaller.boundsExact());
+}
+
+static double area(Geom::PathVector const &pathv)
+{
+    // Shoelace formula; the output of livarot has line segments only for polygons
+    double sum = 0;
+    for (auto const &path : pathv) {
+        for (auto const &curve : path) {
+            auto const p0 = curve.initialPoint();
+            auto const p1 = curve.finalPoint();
+            sum += p0[Geom::X] * p1[Geom::Y] - p1[Geom::X] * p0[Geom::Y];
+        }
+    }
+    return std::abs(sum / 2);
+}
+
+TEST_F(PathBoolopTest, UnionMany){
+    // test that uniting many overlapping squares at once gives the same shape as uniting them one after another
+    std::vector<Geom::PathVector> squares;
+    for (int i = 0; i < 5; i++) {
+        for (int j = 0; j < 5; j++) {
+            if (i != 2 || j != 2) {
+                squares.push_back(Geom::PathVector(Geom::Path(Geom::Rect(i, j, i + 1.5, j + 1.5))));
+            }
+        }
+    }
+
+    Geom::PathVector pvUnion = sp_pathvector_union(squares, fill_nonZero);
+    Geom::PathVector pvSequential = squares[0];
+    for (unsigned i = 1; i < squares.size(); i++) {
+        pvSequential = sp_pathvector_boolop(pvSequential, squares[i], bool_op_union, fill_nonZero, fill_nonZero, true);
+    }
+
+    // 5.5 by 5.5 with a hole of 0.5 by 0.5 where the middle square is missing
+    EXPECT_EQ(pvUnion.size(), 2u);
+    EXPECT_NEAR(area(pvUnion), 30.0, 1e-6);
+    EXPECT_NEAR(area(pvUnion), area(pvSequential), 1e-6);
+    auto const bounds = pvUnion.boundsExact();
+    ASSERT_TRUE(bounds);
+    EXPECT_TRUE(Geom::are_near(bounds->min(), Geom::Point(0, 0), 1e-6));
+    EXPECT_TRUE(Geom::are_near(bounds->max(), Geom::Point(5.5, 5.5), 1e-6));
+}
+
 //
\ No newline at end of file
@@ -9,9 +9,14 @@
  *
  * Released under GNU GPL v2+, read the file 'COPYING' for more information.
  */
+#include <cstdint>
+#include <memory>
+#include <string>
 #include <gtest/gtest.h>
+#include <src/document.h>
 #include <src/object/sp-object.h>
 #include <src/object/sp-item.h>
+#include <src/object/sp-object-pool.h>
 #include <src/xml/node.h>
 #include <src/xml/text-node.h>
 #include <doc-per-case-test.h>
@@ -120,3 +125,49 @@ TEST_F(SPObjectTest, Advanced) {
         EXPECT_EQ(tmp[index++], &child);
     }
 }
+
+TEST_F(SPObjectTest, Pool) {
+    auto pool = _doc->objectPool();
+    ASSERT_TRUE(pool != nullptr);
+    auto const count = pool->objectCount();
+    auto const used = pool->used();
+
+    // Objects made outside a scope don't come from any pool.
+    auto item = new SPItem();
+    EXPECT_EQ(count, pool->objectCount());
+    delete item;
+
+    {
+        SPObjectPool::Scope scope(pool);
+        item = new SPItem();
+    }
+    auto const address = reinterpret_cast<std::uintptr_t>(item);
+    EXPECT_EQ(count + 1, pool->objectCount());
+    EXPECT_LE(used + sizeof(SPItem), pool->used());
+    EXPECT_LE(pool->used(), pool->reserved());
+    delete item;
+    EXPECT_EQ(count, pool->objectCount());
+    EXPECT_EQ(used, pool->used());
+
+    // Storage of a freed object is reused for the next one of its size.
+    {
+        SPObjectPool::Scope scope(pool);
+        item = new SPItem();
+    }
+    EXPECT_EQ(address, reinterpret_cast<std::uintptr_t>(item));
+    delete item;
+}
+
+TEST_F(SPObjectTest, PoolPerDocument) {
+    auto const other_count = _doc->objectPool()->objectCount();
+    std::string const svg("<svg><rect width='1' height='1' /><g><circle r='1' /></g></svg>");
+    std::unique_ptr<SPDocument> doc(SPDocument::createNewDocFromMem(svg.c_str(), svg.size(), false));
+    ASSERT_TRUE(doc != nullptr);
+
+    // The root, the rect, the group and the circle at least, and none of them in another pool.
+    EXPECT_NE(doc->objectPool(), _doc->objectPool());
+    EXPECT_GE(doc->objectPool()->objectCount(), 4u);
+    EXPECT_EQ(other_count, _doc->objectPool()->objectCount());
+    doc.reset();
+    EXPECT_EQ(other_count, _doc->objectPool()->objectCount());
+}
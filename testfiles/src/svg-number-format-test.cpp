@@ -0,0 +1,165 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Test for the number formatting of SVG and CSS output
+ *//*
+ * Authors: see git history
+ *
+ * Copyright (C) 2022 Authors
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+#include "svg/number-format.h"
+#include "svg/path-string.h"
+#include "svg/strip-trailing-zeros.h"
+#include "svg/svg.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <2geom/path.h>
+#include <gtest/gtest.h>
+
+using namespace Inkscape::SVG;
+
+static std::string number(double val, int precision, int min_exp)
+{
+    char buf[NUMBER_BUFFER_SIZE];
+    return std::string(buf, format_number(buf, val, precision, min_exp));
+}
+
+static std::string general(double val, int precision)
+{
+    char buf[NUMBER_BUFFER_SIZE];
+    return std::string(buf, format_number_general(buf, val, precision));
+}
+
+static std::string fixed(double val, int decimals)
+{
+    char buf[NUMBER_BUFFER_SIZE];
+    return std::string(buf, format_number_fixed(buf, val, decimals));
+}
+
+TEST(SvgNumberFormatTest, pathStyle)
+{
+    EXPECT_EQ(number(0.0, 8, -8), "0");
+    EXPECT_EQ(number(-4.0, 8, -8), "-4");
+    EXPECT_EQ(number(761.92918978947023, 2, -8), "760");
+    EXPECT_EQ(number(761.92918978947023, 4, -8), "761.9");
+    EXPECT_EQ(number(0.0123456789, 8, -8), "0.01234568");
+    EXPECT_EQ(number(0.000123456789, 8, -8), "1.2345679e-4");
+    EXPECT_EQ(number(9.99999999, 8, -8), "10");
+    EXPECT_EQ(number(1e20, 8, -8), "1e20");
+    EXPECT_EQ(number(-1e-8, 8, -8), "-1e-8");
+    EXPECT_EQ(number(1e-9, 8, -8), "0");
+    // Rounded once, to the nearest of the requested digits.
+    EXPECT_EQ(number(15706224.64, 7, -8), "15706220");
+    EXPECT_EQ(number(86.135346874999996, 10, -8), "86.13534687");
+}
+
+TEST(SvgNumberFormatTest, generalStyle)
+{
+    EXPECT_EQ(general(1.23456789, 8), "1.2345679");
+    EXPECT_EQ(general(-12345678.9, 8), "-12345679");
+    EXPECT_EQ(general(1.234e-12, 8), "1.234e-12");
+    EXPECT_EQ(general(3e9, 8), "3e+09");
+    EXPECT_EQ(general(0.00123456, 8), "0.00123456");
+    EXPECT_EQ(general(0.125, 2), "0.12");
+
+    std::mt19937 random(1);
+    std::uniform_real_distribution<double> mantissa(-10.0, 10.0);
+    std::uniform_int_distribution<int> exponent(-6, 5);
+    for (int i = 0; i < 100000; ++i) {
+        double const val = mantissa(random) * std::pow(10.0, exponent(random));
+        int const precision = 1 + i % 15;
+        char buf[64];
+        std::snprintf(buf, sizeof(buf), "%.*g", precision, val);
+        ASSERT_EQ(general(val, precision), strip_trailing_zeros(buf)) << val << " " << precision;
+    }
+
+    // All the digits a double has, and magnitudes beyond the exact powers of ten.
+    EXPECT_EQ(general(-916.7088907750053, 16), "-916.7088907750053");
+    EXPECT_EQ(general(1.280955973327445e-09, 15), "1.28095597332744e-09");
+    std::uniform_real_distribution<double> coordinate(-2000.0, 2000.0);
+    std::uniform_int_distribution<int> wide_exponent(-40, 30);
+    for (int i = 0; i < 200000; ++i) {
+        double const val = i % 2 ? coordinate(random) : mantissa(random) * std::pow(10.0, wide_exponent(random));
+        int const precision = 15 + i % 3;
+        char buf[64];
+        std::snprintf(buf, sizeof(buf), "%.*g", precision, val);
+        ASSERT_EQ(general(val, precision), strip_trailing_zeros(buf)) << val << " " << precision;
+    }
+}
+
+TEST(SvgNumberFormatTest, fixedStyle)
+{
+    EXPECT_EQ(fixed(12345678.9, 8), "12345678.9");
+    EXPECT_EQ(fixed(-0.00123456, 8), "-0.00123456");
+    EXPECT_EQ(fixed(1.234e-12, 8), "0");
+    EXPECT_EQ(fixed(2.5, 0), "2");
+}
+
+TEST(SvgNumberFormatTest, pathString)
+{
+    PathString str;
+    str.moveTo(1.5, 2).lineTo(1e-5, 3.25).closePath();
+    EXPECT_EQ(str.string(), sp_svg_write_path(sp_svg_read_pathv(str.c_str())));
+}
+
+// Run with --gtest_also_run_disabled_tests to compare with formatting through iostreams.
+TEST(SvgNumberFormatTest, DISABLED_Benchmark)
+{
+    std::mt19937 random(1);
+    std::uniform_real_distribution<double> coordinate(-2000.0, 2000.0);
+    std::vector<double> values(1000000);
+    for (auto &value : values) {
+        value = coordinate(random);
+    }
+
+    auto const start_stream = std::chrono::steady_clock::now();
+    std::size_t size_stream = 0;
+    for (auto value : values) {
+        std::ostringstream s;
+        s.imbue(std::locale::classic());
+        s.setf(std::ios::showpoint);
+        s.precision(8);
+        s << value;
+        size_stream += strip_trailing_zeros(s.str()).size();
+    }
+    auto const start_format = std::chrono::steady_clock::now();
+    std::size_t size_format = 0;
+    char buf[NUMBER_BUFFER_SIZE];
+    for (auto value : values) {
+        size_format += format_number_general(buf, value, 8) - buf;
+    }
+    auto const end = std::chrono::steady_clock::now();
+
+    auto const ms = [](auto duration) { return std::chrono::duration<double, std::milli>(duration).count(); };
+    std::cout << values.size() << " numbers: iostream " << ms(start_format - start_stream) << " ms, format_number_general "
+              << ms(end - start_format) << " ms" << std::endl;
+    EXPECT_EQ(size_stream, size_format);
+
+    Geom::Path path(Geom::Point(0, 0));
+    for (std::size_t i = 0; i + 1 < values.size(); i += 2) {
+        path.appendNew<Geom::LineSegment>(Geom::Point(values[i], values[i + 1]));
+    }
+    auto const start_path = std::chrono::steady_clock::now();
+    auto const data = sp_svg_write_path(path);
+    std::cout << path.size() << " path nodes: sp_svg_write_path " << ms(std::chrono::steady_clock::now() - start_path)
+              << " ms for " << data.size() << " bytes" << std::endl;
+}
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -307,6 +307,37 @@ TEST_F(SvgPathGeomTest, testReadImplicitSeparation)
     }
 }
 
+TEST_F(SvgPathGeomTest, testReadSmoothCurves)
+{
+    // The first control point of S mirrors the last one of a preceding cubic curve
+    Geom::PathVector pv_good;
+    pv_good.push_back(Geom::Path(Geom::Point(0, 0)));
+    pv_good.back().append(Geom::CubicBezier(Geom::Point(0, 0), Geom::Point(1, 1), Geom::Point(2, 1), Geom::Point(3, 0)));
+    pv_good.back().append(Geom::CubicBezier(Geom::Point(3, 0), Geom::Point(4, -1), Geom::Point(5, 1), Geom::Point(6, 0)));
+    pv_good.back().append(Geom::LineSegment(Geom::Point(6, 0), Geom::Point(6, 0)));
+    pv_good.back().append(Geom::CubicBezier(Geom::Point(6, 0), Geom::Point(6, 0), Geom::Point(8, 1), Geom::Point(9, 0)));
+    {
+        char const *path_str = "M 0,0 C 1,1 2,1 3,0 S 5,1 6,0 L 6,0 S 8,1 9,0";
+        Geom::PathVector pv = sp_svg_read_pathv(path_str);
+        ASSERT_TRUE(bpathEqual(pv, pv_good)) << path_str;
+    }
+    {
+        char const *path_str = "m 0,0 c 1,1 2,1 3,0 s 2,1 3,0 l 0,0 s 2,1 3,0";
+        Geom::PathVector pv = sp_svg_read_pathv(path_str);
+        ASSERT_TRUE(bpathEqual(pv, pv_good)) << path_str;
+    }
+}
+
+TEST_F(SvgPathGeomTest, testReadRelativeClosingSnap)
+{
+    // Relative coordinates that return to the start up to rounding close the path exactly
+    char const *path_str = "m 0.1,0.2 l 0.3,0 0,0.6 -0.3,0 0,-0.6 z";
+    Geom::PathVector pv = sp_svg_read_pathv(path_str);
+    ASSERT_EQ(pv.size(), 1u);
+    EXPECT_TRUE(pv[0].closed());
+    EXPECT_EQ(pv[0].back_open().finalPoint(), Geom::Point(0.1, 0.2));
+}
+
 TEST_F(SvgPathGeomTest, testReadErrorMisplacedCharacter)
 {
 
@@ -0,0 +1,171 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Text relayout tests
+ *//*
+ * Authors: see git history
+ *
+ * Copyright (C) 2022 Authors
+ *
+ * Released under GNU GPL version 2 or later, read the file 'COPYING' for more information
+ */
+
+#include <gtest/gtest.h>
+#include <src/document.h>
+#include <src/inkscape.h>
+#include <src/libnrtype/Layout-TNG.h>
+#include <src/object/sp-item.h>
+#include <src/text-editing.h>
+#include <src/xml/node.h>
+
+using namespace Inkscape;
+using Inkscape::Text::Layout;
+
+namespace {
+
+/// What the layout shows of one character.
+struct CharacterLayout
+{
+    unsigned paragraph;
+    unsigned line;
+    unsigned shape;
+    Geom::Point anchor;
+    Geom::Rect box;
+    bool cursor;
+};
+
+/// Everything a layout shows through its iterators.
+struct LayoutSummary
+{
+    std::vector<CharacterLayout> characters;
+    std::vector<int> line_starts;
+    std::vector<int> cursor_positions;
+};
+
+LayoutSummary summarize(Layout const &layout)
+{
+    LayoutSummary summary;
+    for (auto it = layout.begin(); it != layout.end(); it.nextCharacter()) {
+        summary.characters.push_back({layout.paragraphIndex(it), layout.lineIndex(it), layout.shapeIndex(it),
+                                      layout.characterAnchorPoint(it), layout.characterBoundingBox(it),
+                                      layout.isCursorPosition(it)});
+    }
+    auto it = layout.begin();
+    do {
+        summary.line_starts.push_back(layout.iteratorToCharIndex(it));
+    } while (it.nextStartOfLine());
+    it = layout.begin();
+    do {
+        summary.cursor_positions.push_back(layout.iteratorToCharIndex(it));
+    } while (it.nextCursorPosition());
+    return summary;
+}
+
+void expect_same_layout(LayoutSummary const &relayout, LayoutSummary const &full)
+{
+    ASSERT_EQ(relayout.characters.size(), full.characters.size());
+    for (std::size_t i = 0; i < full.characters.size(); i++) {
+        auto const &a = relayout.characters[i];
+        auto const &b = full.characters[i];
+        EXPECT_EQ(a.paragraph, b.paragraph) << "character " << i;
+        EXPECT_EQ(a.line, b.line) << "character " << i;
+        EXPECT_EQ(a.shape, b.shape) << "character " << i;
+        EXPECT_TRUE(Geom::are_near(a.anchor, b.anchor, 1e-6)) << "character " << i;
+        EXPECT_TRUE(Geom::are_near(a.box.min(), b.box.min(), 1e-6)) << "character " << i;
+        EXPECT_TRUE(Geom::are_near(a.box.max(), b.box.max(), 1e-6)) << "character " << i;
+        EXPECT_EQ(a.cursor, b.cursor) << "character " << i;
+    }
+    EXPECT_EQ(relayout.line_starts, full.line_starts);
+    EXPECT_EQ(relayout.cursor_positions, full.cursor_positions);
+}
+
+} // namespace
+
+class TextRelayoutTest : public ::testing::Test {
+  protected:
+    void SetUp() override
+    {
+        // setup hidden dependency
+        Application::create(false);
+    }
+
+    static SPDocument *load(std::string const &svg)
+    {
+        auto doc = SPDocument::createNewDocFromMem(svg.c_str(), svg.size(), true);
+        doc->ensureUpToDate();
+        return doc;
+    }
+
+    static Layout const *layout(SPDocument *doc)
+    {
+        auto item = dynamic_cast<SPItem *>(doc->getObjectById("text1"));
+        return item ? te_get_layout(item) : nullptr;
+    }
+
+    /**
+     * Replaces the content of each paragraph in turn, keeping the document up to date between
+     * the edits, and checks that the layout matches that of the same text loaded afresh.
+     */
+    static void check_edits(std::string const &svg_begin, std::vector<std::string> const &paragraphs,
+                            std::string const &svg_end, std::vector<std::string> const &replacements)
+    {
+        auto make_svg = [&] (std::vector<std::string> const &texts) {
+            std::string svg = svg_begin;
+            for (std::size_t i = 0; i < texts.size(); i++) {
+                svg += paragraphs[i] + texts[i] + paragraphs.back();
+            }
+            return svg + svg_end;
+        };
+
+        // paragraphs holds the opening tag of each paragraph, then the closing tag
+        std::vector<std::string> texts(paragraphs.size() - 1, "The quick brown fox jumps over the lazy dog.");
+        auto doc = load(make_svg(texts));
+        ASSERT_TRUE(layout(doc) != nullptr);
+
+        for (std::size_t i = 0; i < texts.size(); i++) {
+            texts[i] = replacements[i % replacements.size()];
+            auto content = doc->getObjectById("para" + std::to_string(i))->getRepr()->firstChild();
+            ASSERT_TRUE(content != nullptr);
+            content->setContent(texts[i].c_str());
+            doc->ensureUpToDate();
+
+            auto fresh = load(make_svg(texts));
+            ASSERT_TRUE(layout(fresh) != nullptr);
+            SCOPED_TRACE("after editing paragraph " + std::to_string(i));
+            expect_same_layout(summarize(*layout(doc)), summarize(*layout(fresh)));
+        }
+    }
+};
+
+TEST_F(TextRelayoutTest, EditedParagraphOfText)
+{
+    check_edits("\
+<svg width='400' height='400'\
+  xmlns:sodipodi='http://sodipodi.sourceforge.net/DTD/sodipodi-0.dtd'>\
+  <text id='text1' x='10' y='20' style='font-size:12px;line-height:1.25'>",
+                {"<tspan sodipodi:role='line' x='10' id='para0'>",
+                 "<tspan sodipodi:role='line' x='10' id='para1'>",
+                 "<tspan sodipodi:role='line' x='10' id='para2'>",
+                 "<tspan sodipodi:role='line' x='10' id='para3'>",
+                 "</tspan>"},
+                "</text></svg>",
+                {"Short.", "A much longer paragraph than the one it replaces, set on the same line.", "x"});
+}
+
+TEST_F(TextRelayoutTest, EditedParagraphOfFlowedText)
+{
+    check_edits("\
+<svg width='400' height='400'>\
+  <flowRoot id='text1' style='font-size:12px;line-height:1.25'>\
+    <flowRegion><rect x='10' y='10' width='120' height='380' /></flowRegion>",
+                {"<flowPara id='para0'>",
+                 "<flowPara id='para1'>",
+                 "<flowPara id='para2'>",
+                 "<flowPara id='para3'>",
+                 "</flowPara>"},
+                "</flowRoot></svg>",
+                // shorter, longer and equally long text, so later paragraphs move up, down or stay
+                {"Short.", "A much longer paragraph than the one it replaces, wrapped over several more lines of the frame.",
+                 "The quick brown fox jumps over the lazy cat."});
+}
+
+// vim: filetype=cpp:expandtab:shiftwidth=4:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -12,8 +12,11 @@
  * Released under GNU GPL v2+, read the file 'COPYING' for more information.
  */
 
+#include <random>
+
 #include "gtest/gtest.h"
 #include "util/longest-common-suffix.h"
+#include "util/rect-tree.h"
 
 TEST(UtilTest, NearestCommonAncestor)
 {
@@ -79,4 +82,70 @@ TEST(UtilTest, NearestCommonAncestor)
     ASSERT_EQ(nearest_common_ancestor(iter(node3a), iter(node3b), iter(node0)), iter(node2));
 }
 
+TEST(UtilTest, RectTree)
+{
+    std::mt19937 gen(12345);
+    std::uniform_real_distribution<double> pos(0.0, 1000.0);
+    std::uniform_real_distribution<double> size(0.0, 50.0);
+
+    auto random_rect = [&] () -> Geom::OptRect {
+        if (gen() % 10 == 0) {
+            return {};
+        }
+        auto const x = pos(gen), y = pos(gen);
+        return Geom::Rect(x, y, x + size(gen), y + size(gen));
+    };
+
+    std::vector<Inkscape::Util::RectTree<int>::Entry> entries;
+    for (int i = 0; i < 500; i++) {
+        entries.emplace_back(random_rect(), i);
+    }
+    Inkscape::Util::RectTree<int> tree(entries);
+    ASSERT_EQ(tree.size(), entries.size());
+
+    auto brute_force = [&] (Geom::Rect const &area) {
+        std::vector<std::size_t> result;
+        for (std::size_t i = 0; i < entries.size(); i++) {
+            if (entries[i].first && entries[i].first->intersects(area)) {
+                result.push_back(i);
+            }
+        }
+        return result;
+    };
+
+    auto check = [&] {
+        for (int n = 0; n < 100; n++) {
+            auto const area = random_rect();
+            if (!area) {
+                continue;
+            }
+            ASSERT_EQ(tree.query(*area), brute_force(*area));
+        }
+        for (int n = 0; n < 100; n++) {
+            auto const p = Geom::Point(pos(gen), pos(gen));
+            auto area = Geom::Rect(p, p);
+            area.expandBy(2.0);
+            ASSERT_EQ(tree.query(p, 2.0), brute_force(area));
+        }
+    };
+
+    check();
+
+    // Refit, then enough updates to force a rebuild; the values must keep their positions.
+    for (int round = 0; round < 2; round++) {
+        for (std::size_t i = 0; i < entries.size(); i += 2) {
+            entries[i].first = random_rect();
+            tree.update(i, entries[i].first);
+        }
+        check();
+    }
+    for (std::size_t i = 0; i < entries.size(); i++) {
+        ASSERT_EQ(tree.value(i), (int)i);
+    }
+
+    tree.clear();
+    ASSERT_TRUE(tree.empty());
+    ASSERT_TRUE(tree.query(Geom::Rect(0, 0, 1000, 1000)).empty());
+}
+
 // vim: filetype=cpp:expandtab:shiftwidth=4:softtabstop=4:fileencoding=utf-8:textwidth=99 :
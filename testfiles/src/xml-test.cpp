@@ -12,6 +12,13 @@
  * Released under GNU GPL v2+, read the file 'COPYING' for more information.
  */
 
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
 #include "gtest/gtest.h"
 #include "xml/repr.h"
 
@@ -72,6 +79,167 @@ TEST(XmlTest, nodeiter)
     ASSERT_EQ(testdoc->root()->findChildPath(path), nullptr);
 }
 
+TEST(XmlTest, manyAttributes)
+{
+    auto testdoc = std::shared_ptr<Inkscape::XML::Document>(sp_repr_read_buf("<svg><g/></svg>", SP_SVG_NS_URI));
+    ASSERT_TRUE(testdoc);
+    auto node = testdoc->root()->firstChild();
+
+    // Enough attributes to be looked up through the index
+    for (int i = 0; i < 20; ++i) {
+        node->setAttribute("attr" + std::to_string(i), std::to_string(i));
+    }
+    node->removeAttribute("attr3");
+    node->removeAttribute("attr17");
+    node->setAttribute("attr5", "five");
+    node->setAttribute(g_quark_from_string("attr20"), "20");
+
+    auto const &list = node->attributeList();
+    ASSERT_EQ(list.size(), 19u);
+    // Insertion order is kept
+    EXPECT_STREQ(g_quark_to_string(list[3].key), "attr4");
+    EXPECT_STREQ(g_quark_to_string(list.back().key), "attr20");
+    for (auto const &record : list) {
+        EXPECT_EQ(node->attribute(g_quark_to_string(record.key)), static_cast<char const *>(record.value));
+        EXPECT_EQ(node->attribute(record.key), static_cast<char const *>(record.value));
+    }
+    EXPECT_STREQ(node->attribute("attr5"), "five");
+    EXPECT_EQ(node->attribute("attr3"), nullptr);
+    EXPECT_EQ(node->attribute("attr17"), nullptr);
+    EXPECT_EQ(node->attribute("never-set-anywhere"), nullptr);
+
+    // Back to a few attributes, looked up by a scan
+    for (int i = 0; i < 15; ++i) {
+        node->removeAttribute("attr" + std::to_string(i));
+    }
+    ASSERT_EQ(list.size(), 5u);
+    EXPECT_STREQ(node->attribute("attr19"), "19");
+    EXPECT_EQ(node->attribute("attr14"), nullptr);
+}
+
+TEST(XmlTest, childPositions)
+{
+    auto testdoc = std::shared_ptr<Inkscape::XML::Document>(sp_repr_read_buf("<svg/>", SP_SVG_NS_URI));
+    ASSERT_TRUE(testdoc);
+    auto root = testdoc->root();
+
+    // Mirror inserts, removals and moves in a vector and compare positions
+    std::vector<Inkscape::XML::Node *> expected;
+    for (int i = 0; i < 200; ++i) {
+        auto child = testdoc->createElement("svg:g");
+        auto const position = (i * 7) % (expected.size() + 1);
+        root->addChild(child, position ? expected[position - 1] : nullptr);
+        expected.insert(expected.begin() + position, child);
+        Inkscape::GC::release(child);
+    }
+    for (int i = 0; i < 50; ++i) {
+        auto const position = (i * 13) % expected.size();
+        root->removeChild(expected[position]);
+        expected.erase(expected.begin() + position);
+    }
+    for (int i = 0; i < 50; ++i) {
+        auto child = expected[(i * 11) % expected.size()];
+        auto const position = (i * 5) % expected.size();
+        child->setPosition(position);
+        expected.erase(std::find(expected.begin(), expected.end(), child));
+        expected.insert(expected.begin() + position, child);
+    }
+
+    ASSERT_EQ(root->childCount(), expected.size());
+    auto child = root->firstChild();
+    for (unsigned i = 0; i < expected.size(); ++i, child = child->next()) {
+        ASSERT_EQ(child, expected[i]);
+        EXPECT_EQ(root->nthChild(i), expected[i]);
+        EXPECT_EQ(expected[i]->position(), i);
+    }
+    EXPECT_EQ(root->nthChild(expected.size()), nullptr);
+}
+
+namespace {
+
+/// Checks that two repr subtrees have the same nodes, names, contents and attributes in order.
+void expect_same_tree(Inkscape::XML::Node const *a, Inkscape::XML::Node const *b)
+{
+    ASSERT_EQ(a->type(), b->type());
+    ASSERT_STREQ(a->name(), b->name());
+    EXPECT_STREQ(a->content(), b->content()) << a->name();
+
+    auto const &attrs_a = a->attributeList();
+    auto const &attrs_b = b->attributeList();
+    ASSERT_EQ(attrs_a.size(), attrs_b.size()) << a->name();
+    for (std::size_t i = 0; i < attrs_a.size(); ++i) {
+        EXPECT_EQ(attrs_a[i].key, attrs_b[i].key);
+        EXPECT_STREQ(attrs_a[i].value.pointer(), attrs_b[i].value.pointer());
+    }
+
+    ASSERT_EQ(a->childCount(), b->childCount()) << a->name();
+    for (auto ca = a->firstChild(), cb = b->firstChild(); ca; ca = ca->next(), cb = cb->next()) {
+        expect_same_tree(ca, cb);
+        if (testing::Test::HasFatalFailure()) {
+            return;
+        }
+    }
+}
+
+} // namespace
+
+// Files of 1 MiB and more are parsed on a worker thread while the repr tree is built.
+TEST(XmlTest, stagedReadOfLargeFile)
+{
+    std::string svg = R"""(<?xml version="1.0" encoding="UTF-8" standalone="no"?>
+<!DOCTYPE svg [ <!ENTITY label "entity &amp; text"> ]>
+<!-- comment before the root -->
+<?xml-stylesheet href="style.css" type="text/css"?>
+<svg xmlns="http://www.w3.org/2000/svg" xmlns:inkscape="http://www.inkscape.org/namespaces/inkscape"
+     xmlns:sodipodi="http://sodipodi.sourceforge.net/DTD/sodipodi-0.dtd" xmlns:other="http://example.org/other"
+     width="100" height="100">
+  <sodipodi:namedview id="namedview1" inkscape:zoom="1"/>
+  <style><![CDATA[ rect { fill: red; } ]]></style>
+)""";
+    for (int i = 0; svg.size() < (3 << 19); ++i) {
+        svg += "  <g id='g" + std::to_string(i) + "' inkscape:label='&label; " + std::to_string(i) + "' other:data='x'>\n"
+               "    <rect x='" + std::to_string(i % 97) + "' y='1' width='2' height='3'/>\n"
+               "    <!-- comment " + std::to_string(i) + " -->\n"
+               "    <text><tspan>&label; &lt;" + std::to_string(i) + "&gt;</tspan> tail</text>\n"
+               "  </g>\n";
+        if (i % 1000 == 0) {
+            svg += "  <?pi-in-root " + std::to_string(i) + "?>\n  <!-- between children -->\n";
+        }
+    }
+    svg += "</svg>\n<!-- comment after the root -->\n<?pi-after-root done?>\n";
+    ASSERT_GE(svg.size(), 1u << 20);
+
+    auto const filename = testing::TempDir() + "xml-test-staged-read.svg";
+    {
+        std::ofstream out(filename, std::ios::binary);
+        out << svg;
+    }
+
+    int reports = 0;
+    double last_fraction = 0;
+    std::shared_ptr<Inkscape::XML::Document> from_file;
+    {
+        Inkscape::XML::ReadProgress progress([&] (double fraction) {
+            EXPECT_GE(fraction, last_fraction);
+            EXPECT_LE(fraction, 1.0);
+            last_fraction = fraction;
+            reports++;
+        });
+        from_file.reset(sp_repr_read_file(filename.c_str(), SP_SVG_NS_URI));
+    }
+    std::remove(filename.c_str());
+    auto from_mem = std::shared_ptr<Inkscape::XML::Document>(sp_repr_read_mem(svg.c_str(), svg.size(), SP_SVG_NS_URI));
+    ASSERT_TRUE(from_file);
+    ASSERT_TRUE(from_mem);
+
+    // Only the staged read reports progress.
+    EXPECT_GT(reports, 0);
+
+    // Including the comments and processing instructions around the root element
+    expect_same_tree(from_file.get(), from_mem.get());
+    EXPECT_GT(from_file->root()->childCount(), 10000u);
+}
+
 /*
   Local Variables:
   mode:c++